@@ -0,0 +1,50 @@
+/*
+ * SHA-1/SHA-256 using the ARMv8 Cryptography Extensions
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _ASM_ARMV8_SHA_CE_H_
+#define _ASM_ARMV8_SHA_CE_H_
+
+/*
+ * The SHA instructions are optional in ARMv8.0, ID_AA64ISAR0_EL1 tells
+ * whether this CPU implements them.
+ */
+static inline unsigned long read_id_aa64isar0(void)
+{
+	unsigned long isar0;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+	return isar0;
+}
+
+static inline int sha1_ce_present(void)
+{
+	return ((read_id_aa64isar0() >> 8) & 0xf) != 0;
+}
+
+static inline int sha256_ce_present(void)
+{
+	return ((read_id_aa64isar0() >> 12) & 0xf) != 0;
+}
+
+/**
+ * sha1_ce_transform() - Run the SHA-1 compression function over blocks
+ *
+ * @state:	Hash state (A..E), updated in place
+ * @src:	Input, @blocks * 64 bytes
+ * @blocks:	Number of 64 byte blocks, at least one
+ */
+void sha1_ce_transform(uint32_t state[5], const uint8_t *src, int blocks);
+
+/**
+ * sha256_ce_transform() - Run the SHA-256 compression function over blocks
+ *
+ * @state:	Hash state (A..H), updated in place
+ * @src:	Input, @blocks * 64 bytes
+ * @blocks:	Number of 64 byte blocks, at least one
+ */
+void sha256_ce_transform(uint32_t state[8], const uint8_t *src, int blocks);
+
+#endif /* _ASM_ARMV8_SHA_CE_H_ */
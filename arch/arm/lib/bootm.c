@@ -80,6 +80,9 @@ static void announce_and_cleanup(int fake)
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
 #endif
+#ifdef CONFIG_BOOTSTAGE_EXPORT
+	bootstage_export_save();
+#endif
 
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
@@ -0,0 +1,26 @@
+/*
+ * Helper for the AArch64 string routines
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __ARM_LIB_SHIFT_64_H
+#define __ARM_LIB_SHIFT_64_H
+
+/*
+ * \out = the 8 bytes starting \rsh bits into the aligned word \lo and
+ * continuing in the next word \hi. \lsh holds -\rsh, register shifts
+ * use the amount modulo 64. \tmp is clobbered.
+ */
+	.macro	shift_word, out, lo, hi, rsh, lsh, tmp
+#ifdef __AARCH64EB__
+	lsl	\out, \lo, \rsh
+	lsr	\tmp, \hi, \lsh
+#else
+	lsr	\out, \lo, \rsh
+	lsl	\tmp, \hi, \lsh
+#endif
+	orr	\out, \out, \tmp
+	.endm
+
+#endif
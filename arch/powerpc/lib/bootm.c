@@ -59,6 +59,9 @@ static void boot_jump_linux(bootm_headers_t *images)
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
 #endif
+#ifdef CONFIG_BOOTSTAGE_EXPORT
+	bootstage_export_save();
+#endif
 
 #if defined(CONFIG_SYS_INIT_RAM_LOCK) && !defined(CONFIG_E500)
 	unlock_ram_in_cache();
@@ -70,3 +70,21 @@ phys_addr_t map_to_sysmem(const void *ptr)
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
 }
+
+/* There is no cache; remember the setting so that callers can restore it */
+static int sandbox_dcache_on = 1;
+
+void dcache_enable(void)
+{
+	sandbox_dcache_on = 1;
+}
+
+void dcache_disable(void)
+{
+	sandbox_dcache_on = 0;
+}
+
+int dcache_status(void)
+{
+	return sandbox_dcache_on;
+}
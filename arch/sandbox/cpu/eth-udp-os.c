@@ -0,0 +1,100 @@
+/*
+ * Sandbox Ethernet frames carried over a host UDP socket: each datagram
+ * holds one frame, so a script on the host can play the rest of the
+ * network (see test/net/).
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <asm/eth-udp-os.h>
+
+int sandbox_eth_udp_os_init(const char *peer,
+			    struct eth_sandbox_udp_priv *priv)
+{
+	struct sockaddr_in local;
+	char host[64];
+	const char *colon;
+	struct in_addr addr;
+	int bufsize = 1 << 20;
+
+	colon = strchr(peer, ':');
+	if (!colon || colon - peer >= sizeof(host)) {
+		printf("sandbox eth: expected host:port, got '%s'\n", peer);
+		return -1;
+	}
+	memcpy(host, peer, colon - peer);
+	host[colon - peer] = '\0';
+	if (!inet_aton(host, &addr)) {
+		printf("sandbox eth: bad address '%s'\n", host);
+		return -1;
+	}
+	priv->peer_ip = ntohl(addr.s_addr);
+	priv->peer_port = atoi(colon + 1);
+
+	priv->sd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (priv->sd < 0) {
+		perror("sandbox eth: socket");
+		return -1;
+	}
+
+	/* a window of full-size frames may land between two polls */
+	setsockopt(priv->sd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(priv->sd, (struct sockaddr *)&local, sizeof(local)) < 0) {
+		perror("sandbox eth: bind");
+		close(priv->sd);
+		priv->sd = -1;
+		return -1;
+	}
+
+	return 0;
+}
+
+int sandbox_eth_udp_os_send(const void *packet, int length,
+			    const struct eth_sandbox_udp_priv *priv)
+{
+	struct sockaddr_in to;
+
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_addr.s_addr = htonl(priv->peer_ip);
+	to.sin_port = htons(priv->peer_port);
+
+	if (sendto(priv->sd, packet, length, 0, (struct sockaddr *)&to,
+		   sizeof(to)) != length)
+		return -1;
+
+	return 0;
+}
+
+int sandbox_eth_udp_os_recv(void *packet, int size,
+			    const struct eth_sandbox_udp_priv *priv)
+{
+	ssize_t len;
+
+	len = recv(priv->sd, packet, size, MSG_DONTWAIT);
+	if (len < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+
+	return len;
+}
+
+void sandbox_eth_udp_os_halt(struct eth_sandbox_udp_priv *priv)
+{
+	if (priv->sd >= 0)
+		close(priv->sd);
+	priv->sd = -1;
+}
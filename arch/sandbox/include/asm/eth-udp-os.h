@@ -0,0 +1,54 @@
+/*
+ * Sandbox Ethernet frames carried over a host UDP socket
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __ETH_UDP_OS_H
+#define __ETH_UDP_OS_H
+
+/**
+ * struct eth_sandbox_udp_priv - host side of a sandbox Ethernet device
+ *
+ * sd:		host socket descriptor, -1 if not open
+ * peer_ip:	IPv4 address frames are sent to (host byte order)
+ * peer_port:	UDP port frames are sent to
+ */
+struct eth_sandbox_udp_priv {
+	int sd;
+	unsigned int peer_ip;
+	unsigned short peer_port;
+};
+
+/**
+ * sandbox_eth_udp_os_init() - open a socket towards the frame peer
+ *
+ * @peer:	"host:port" of the peer, host given as a dotted quad
+ * @priv:	filled in on success
+ * @return 0 if OK, -1 on error
+ */
+int sandbox_eth_udp_os_init(const char *peer,
+			    struct eth_sandbox_udp_priv *priv);
+
+/**
+ * sandbox_eth_udp_os_send() - send one frame to the peer
+ *
+ * @return 0 if OK, -1 on error
+ */
+int sandbox_eth_udp_os_send(const void *packet, int length,
+			    const struct eth_sandbox_udp_priv *priv);
+
+/**
+ * sandbox_eth_udp_os_recv() - fetch one frame without waiting
+ *
+ * @return length of the frame, 0 if none is waiting, -1 on error
+ */
+int sandbox_eth_udp_os_recv(void *packet, int size,
+			    const struct eth_sandbox_udp_priv *priv);
+
+/**
+ * sandbox_eth_udp_os_halt() - close the socket
+ */
+void sandbox_eth_udp_os_halt(struct eth_sandbox_udp_priv *priv);
+
+#endif
@@ -67,6 +67,9 @@ struct sandbox_state {
 	bool ignore_missing_state_on_read;	/* No error if state missing */
 	bool show_lcd;			/* Show LCD on start-up */
 	enum state_terminal_raw term_raw;	/* Terminal raw/cooked */
+	const char *eth_peer;		/* host:port exchanging eth frames */
+	const char *eth_pcap;		/* pcap file replayed as eth input */
+	const char *nand_spec;		/* backing file and geometry of NAND */
 
 	/* Pointer to information for each SPI bus/cs */
 	struct sandbox_spi_info spi[CONFIG_SANDBOX_SPI_MAX_BUS]
@@ -42,6 +42,9 @@ void bootm_announce_and_cleanup(void)
 	bootstage_mark_name(BOOTSTAGE_ID_BOOTM_HANDOFF, "start_kernel");
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
+#endif
+#ifdef CONFIG_BOOTSTAGE_EXPORT
+	bootstage_export_save();
 #endif
 	board_final_cleanup();
 }
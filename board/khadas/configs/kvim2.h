@@ -207,7 +207,9 @@
             "if imgread kernel ${recovery_part} ${loadaddr} ${recovery_offset}; then wipeisb; bootm ${loadaddr}; fi;"\
             "\0"\
         "init_display="\
-            "osd open;osd clear;imgread pic logo bootup $loadaddr;bmp display $bootup_offset;bmp scale"\
+            "osd open;osd clear;imgread pic logo bootup $loadaddr;"\
+            "if itest ${bootup_cached} == 0; then bmp display $bootup_offset;bmp scale;imgread fbcache logo bootup $loadaddr;"\
+            "else bmp scale; fi"\
             "\0"\
         "cmdline_keys="\
             "if keyman init 0x1234; then "\
@@ -307,6 +309,7 @@
 #define CONFIG_OF_LIBFDT 1
 #define CONFIG_ANDROID_BOOT_IMAGE 1
 #define CONFIG_ANDROID_IMG 1
+#define CONFIG_ANDROID_IMG_PLACE 1
 #define CONFIG_SYS_BOOTM_LEN (64<<20) /* Increase max gunzip size*/
 
 /* cpu */
@@ -382,6 +385,7 @@
 #define CONFIG_CMD_UBI
 #define CONFIG_CMD_UBIFS
 #define CONFIG_RBTREE
+#define CONFIG_MTD_UBI_FASTMAP	/* attach from the fastmap when Linux left one */
 #define CONFIG_CMD_NAND_TORTURE 1
 #define CONFIG_CMD_MTDPARTS   1
 #define CONFIG_MTD_PARTITIONS 1
@@ -394,6 +398,8 @@
 #ifdef	CONFIG_AML_SD_EMMC
 	#define CONFIG_GENERIC_MMC 1
 	#define CONFIG_CMD_MMC 1
+	#define CONFIG_BLOCK_ASYNC 1
+	#define CONFIG_MMC_CMD_STATS 1
 	#define	CONFIG_SYS_MMC_ENV_DEV 1
 	#define CONFIG_EMMC_DDR52_EN 0
 	#define CONFIG_EMMC_DDR52_CLK 35000000
@@ -414,6 +420,7 @@
 #endif
 
 #define	CONFIG_PARTITIONS 1
+#define CONFIG_BLOCK_CACHE 1
 #define CONFIG_SYS_NO_FLASH  1
 
 /*SPI*/
@@ -444,6 +451,7 @@
 #define CONFIG_AML_OSD 1
 #define CONFIG_OSD_SCALE_ENABLE 1
 #define CONFIG_CMD_BMP 1
+#define CONFIG_AML_LOGO_FB_CACHE 1
 
 #if defined(CONFIG_AML_VOUT)
 #define CONFIG_AML_CVBS 1
@@ -468,6 +476,7 @@
 #define CONFIG_CMD_FASTBOOT 1
 #define CONFIG_FASTBOOT_FLASH_MMC_DEV 1
 #define CONFIG_FASTBOOT_FLASH 1
+#define CONFIG_FASTBOOT_FLASH_STREAM 1
 #define CONFIG_USB_GADGET 1
 #define CONFIG_USBDOWNLOAD_GADGET 1
 #define CONFIG_SYS_CACHELINE_SIZE 64
@@ -498,6 +507,9 @@
 	#define CONFIG_GATEWAYIP       10.18.9.1           /* Our getway ip address */
 	#define CONFIG_SERVERIP        10.18.9.113         /* Tftp server ip address */
 	#define CONFIG_NETMASK         255.255.255.0
+	#define CONFIG_IP_DEFRAG       1                   /* large NFS READs */
+	#define CONFIG_NFS_READ_SIZE   8192
+	#define CONFIG_NFS_WINDOWSIZE  4
 #endif /* (CONFIG_CMD_NET) */
 
 /* other devices */
@@ -531,12 +543,15 @@
 #define CONFIG_FS_FAT 1
 #define CONFIG_FS_EXT4 1
 #define CONFIG_LZO 1
+#define CONFIG_LZ4 1
 
 /* Cache Definitions */
 //#define CONFIG_SYS_DCACHE_OFF
 //#define CONFIG_SYS_ICACHE_OFF
 
 /* other functions */
+#define CONFIG_USE_ARCH_MEMCPY	1
+#define CONFIG_USE_ARCH_MEMSET	1
 #define CONFIG_NEED_BL301	1
 #define CONFIG_NEED_BL32	1
 #define CONFIG_CMD_RSVMEM	1
@@ -41,35 +41,82 @@
 #include <part.h>
 #include <sparse_format.h>
 
-void write_sparse_image(block_dev_desc_t *dev_desc,
-		disk_partition_t *info, const char *part_name,
-		void *data, unsigned sz)
+enum {
+	SPARSE_STREAM_FILE_HDR,
+	SPARSE_STREAM_CHUNK_HDR,
+	SPARSE_STREAM_RAW,
+	SPARSE_STREAM_FILL,
+	SPARSE_STREAM_DONE,
+	SPARSE_STREAM_ERROR,
+};
+
+/* Blocks written per call when expanding a FILL chunk */
+#define SPARSE_FILL_BLOCKS	32
+
+/*
+ * Gather a header that may arrive split over several pieces.
+ * Returns 1 once all @size bytes are in @dst.
+ */
+static int sparse_collect(struct sparse_stream *ss, void *dst,
+			  unsigned int size, char **data, unsigned int *len)
+{
+	unsigned int n = min(size - ss->have, *len);
+
+	memcpy(dst + ss->have, *data, n);
+	ss->have += n;
+	*data += n;
+	*len -= n;
+	if (ss->have < size)
+		return 0;
+
+	ss->have = 0;
+	return 1;
+}
+
+/*
+ * Write @blkcnt blocks from @buf. Only data straight from the caller's
+ * piece may be left in flight (@async), our own buffers are reused.
+ */
+static int sparse_write_blocks(struct sparse_stream *ss, void *buf,
+			       lbaint_t blkcnt, int async)
 {
-	lbaint_t blk;
-	lbaint_t blkcnt;
 	lbaint_t blks;
-	uint32_t bytes_written = 0;
-	unsigned int chunk;
-	unsigned int chunk_data_sz;
-	uint32_t *fill_buf = NULL;
-	uint32_t fill_val;
-	sparse_header_t *sparse_header;
-	chunk_header_t *chunk_header;
-	uint32_t total_blocks = 0;
-	int i;
 
-	/* Read and skip over sparse image header */
-	sparse_header = (sparse_header_t *) data;
-
-	data += sparse_header->file_hdr_sz;
-	if (sparse_header->file_hdr_sz > sizeof(sparse_header_t))
-	{
-		/*
-		 * Skip the remaining bytes in a header that is longer than
-		 * we expected.
-		 */
-		data += (sparse_header->file_hdr_sz - sizeof(sparse_header_t));
+	if (sparse_stream_sync(ss))
+		return -1;
+
+	if (async && ss->async) {
+		if (blk_write_submit(ss->dev_desc, ss->blk, blkcnt, buf,
+				     &ss->req)) {
+			printf("%s: Write failed to start\n", __func__);
+			fastboot_fail("flash write failure");
+			return -1;
+		}
+		ss->busy = 1;
+	} else {
+		blks = ss->dev_desc->block_write(ss->dev_desc->dev, ss->blk,
+						 blkcnt, buf);
+		if (blks != blkcnt) {
+			printf("%s: Write failed " LBAFU "\n", __func__, blks);
+			fastboot_fail("flash write failure");
+			return -1;
+		}
 	}
+	ss->blk += blkcnt;
+	ss->bytes_written += blkcnt * ss->info->blksz;
+
+	return 0;
+}
+
+static void sparse_next_chunk(struct sparse_stream *ss)
+{
+	ss->state = ss->chunks_left ? SPARSE_STREAM_CHUNK_HDR :
+				      SPARSE_STREAM_DONE;
+}
+
+static int sparse_start_file(struct sparse_stream *ss)
+{
+	sparse_header_t *sparse_header = &ss->sparse_header;
 
 	debug("=== Sparse Image Header ===\n");
 	debug("magic: 0x%x\n", sparse_header->magic);
@@ -82,163 +129,301 @@ void write_sparse_image(block_dev_desc_t *dev_desc,
 	debug("total_chunks: %d\n", sparse_header->total_chunks);
 
 	/* verify sparse_header->blk_sz is an exact multiple of info->blksz */
-	if (sparse_header->blk_sz !=
-	    (sparse_header->blk_sz & ~(info->blksz - 1))) {
+	if (!sparse_header->blk_sz || sparse_header->blk_sz !=
+	    (sparse_header->blk_sz & ~(ss->info->blksz - 1))) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
 		fastboot_fail("sparse image block size issue");
-		return;
+		return -1;
+	}
+	if (sparse_header->file_hdr_sz < sizeof(sparse_header_t) ||
+	    sparse_header->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		fastboot_fail("sparse image header size issue");
+		return -1;
 	}
 
 	puts("Flashing Sparse Image\n");
 
-	/* Start processing chunks */
-	blk = info->start;
-	for (chunk=0; chunk<sparse_header->total_chunks; chunk++)
-	{
-		/* Read and skip over chunk header */
-		chunk_header = (chunk_header_t *) data;
-		data += sizeof(chunk_header_t);
-
-		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
-			debug("=== Chunk Header ===\n");
-			debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
-			debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
-			debug("total_size: 0x%x\n", chunk_header->total_sz);
+	/*
+	 * Skip the remaining bytes in a header that is longer than
+	 * we expected.
+	 */
+	ss->skip = sparse_header->file_hdr_sz - sizeof(sparse_header_t);
+	ss->chunks_left = sparse_header->total_chunks;
+	sparse_next_chunk(ss);
+
+	return 0;
+}
+
+static int sparse_start_chunk(struct sparse_stream *ss)
+{
+	chunk_header_t *chunk_header = &ss->chunk_header;
+	unsigned int chunk_hdr_sz = ss->sparse_header.chunk_hdr_sz;
+	unsigned int chunk_data_sz;
+	lbaint_t blkcnt;
+
+	if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+		debug("=== Chunk Header ===\n");
+		debug("chunk_type: 0x%x\n", chunk_header->chunk_type);
+		debug("chunk_data_sz: 0x%x\n", chunk_header->chunk_sz);
+		debug("total_size: 0x%x\n", chunk_header->total_sz);
+	}
+
+	ss->skip = chunk_hdr_sz - sizeof(chunk_header_t);
+	ss->chunks_left--;
+
+	chunk_data_sz = ss->sparse_header.blk_sz * chunk_header->chunk_sz;
+	blkcnt = chunk_data_sz / ss->info->blksz;
+	switch (chunk_header->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk_header->total_sz != chunk_hdr_sz + chunk_data_sz) {
+			fastboot_fail("Bogus chunk size for chunk type Raw");
+			return -1;
 		}
+		break;
 
-		if (sparse_header->chunk_hdr_sz > sizeof(chunk_header_t))
-		{
-			/*
-			 * Skip the remaining bytes in a header that is longer
-			 * than we expected.
-			 */
-			data += (sparse_header->chunk_hdr_sz -
-				 sizeof(chunk_header_t));
+	case CHUNK_TYPE_FILL:
+		if (chunk_header->total_sz != chunk_hdr_sz + sizeof(uint32_t)) {
+			fastboot_fail("Bogus chunk size for chunk type FILL");
+			return -1;
 		}
+		break;
 
-		chunk_data_sz = sparse_header->blk_sz * chunk_header->chunk_sz;
-		blkcnt = chunk_data_sz / info->blksz;
-		switch (chunk_header->chunk_type)
-		{
-			case CHUNK_TYPE_RAW:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + chunk_data_sz))
-			{
-				fastboot_fail(
-					"Bogus chunk size for chunk type Raw");
-				return;
-			}
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
-			}
-
-			blks = dev_desc->block_write(dev_desc->dev, blk, blkcnt,
-						     data);
-			if (blks != blkcnt) {
-				printf("%s: Write failed " LBAFU "\n",
-				       __func__, blks);
-				fastboot_fail("flash write failure");
-				return;
-			}
-			blk += blkcnt;
-			bytes_written += blkcnt * info->blksz;
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
-			break;
+	case CHUNK_TYPE_DONT_CARE:
+		ss->blk += blkcnt;
+		ss->total_blocks += chunk_header->chunk_sz;
+		sparse_next_chunk(ss);
+		return 0;
 
-			case CHUNK_TYPE_FILL:
-			if (chunk_header->total_sz !=
-			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t)))
-			{
-				fastboot_fail(
-					"Bogus chunk size for chunk type FILL");
-				return;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(info->blksz,
-						    ARCH_DMA_MINALIGN));
-			if (!fill_buf)
-			{
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL");
-				return;
-			}
-
-			fill_val = *(uint32_t *)data;
-			data = (char *) data + sizeof(uint32_t);
-
-			for (i = 0; i < (info->blksz / sizeof(fill_val)); i++)
-				fill_buf[i] = fill_val;
-
-			if (blk + blkcnt > info->start + info->size) {
-				printf(
-				    "%s: Request would exceed partition size!\n",
-				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!");
-				return;
-			}
-
-			for (i = 0; i < blkcnt; i++) {
-				blks = dev_desc->block_write(dev_desc->dev,
-							     blk, 1, fill_buf);
-				if (blks != 1) {
-					printf(
-					    "%s: Write failed, block # " LBAFU "\n",
-					    __func__, blkcnt);
-					fastboot_fail("flash write failure");
-					free(fill_buf);
-					return;
-				}
-				blk++;
-			}
-			bytes_written += blkcnt * info->blksz;
-			total_blocks += chunk_data_sz / sparse_header->blk_sz;
-
-			free(fill_buf);
+	case CHUNK_TYPE_CRC32:
+		if (chunk_header->total_sz != chunk_hdr_sz) {
+			fastboot_fail("Bogus chunk size for chunk type Dont Care");
+			return -1;
+		}
+		ss->total_blocks += chunk_header->chunk_sz;
+		ss->skip += chunk_data_sz;
+		sparse_next_chunk(ss);
+		return 0;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk_header->chunk_type);
+		fastboot_fail("Unknown chunk type");
+		return -1;
+	}
+
+	if (ss->blk + blkcnt > ss->info->start + ss->info->size) {
+		printf("%s: Request would exceed partition size!\n", __func__);
+		fastboot_fail("Request would exceed partition size!");
+		return -1;
+	}
+
+	ss->total_blocks += chunk_header->chunk_sz;
+	ss->data_left = chunk_data_sz;
+	if (chunk_header->chunk_type == CHUNK_TYPE_FILL)
+		ss->state = SPARSE_STREAM_FILL;
+	else if (chunk_data_sz)
+		ss->state = SPARSE_STREAM_RAW;
+	else
+		sparse_next_chunk(ss);
+
+	return 0;
+}
+
+/* Write RAW chunk data, whole blocks straight from @data */
+static int sparse_write_raw(struct sparse_stream *ss, char **data,
+			    unsigned int *len)
+{
+	unsigned int blksz = ss->info->blksz;
+	unsigned int n = min(ss->data_left, *len);
+	lbaint_t blkcnt;
+
+	if (ss->partial_len || n < blksz) {
+		/* A block split between two pieces goes through a bounce */
+		n = min(n, blksz - ss->partial_len);
+		memcpy(ss->partial + ss->partial_len, *data, n);
+		ss->partial_len += n;
+		if (ss->partial_len == blksz) {
+			if (sparse_write_blocks(ss, ss->partial, 1, 0))
+				return -1;
+			ss->partial_len = 0;
+		}
+	} else {
+		blkcnt = n / blksz;
+		n = blkcnt * blksz;
+		if (sparse_write_blocks(ss, *data, blkcnt, 1))
+			return -1;
+	}
+
+	*data += n;
+	*len -= n;
+	ss->data_left -= n;
+	if (!ss->data_left)
+		sparse_next_chunk(ss);
+
+	return 0;
+}
+
+static int sparse_write_fill(struct sparse_stream *ss)
+{
+	unsigned int blksz = ss->info->blksz;
+	lbaint_t blkcnt = ss->data_left / blksz;
+	lbaint_t n;
+	int i;
+
+	for (i = 0; i < SPARSE_FILL_BLOCKS * blksz / sizeof(uint32_t); i++)
+		ss->fill_buf[i] = ss->fill_val;
+
+	while (blkcnt) {
+		n = min_t(lbaint_t, blkcnt, SPARSE_FILL_BLOCKS);
+		if (sparse_write_blocks(ss, ss->fill_buf, n, 0))
+			return -1;
+		blkcnt -= n;
+	}
+	sparse_next_chunk(ss);
+
+	return 0;
+}
+
+int sparse_stream_init(struct sparse_stream *ss, block_dev_desc_t *dev_desc,
+		       disk_partition_t *info)
+{
+	memset(ss, 0, sizeof(*ss));
+	ss->dev_desc = dev_desc;
+	ss->info = info;
+	ss->blk = info->start;
+	ss->state = SPARSE_STREAM_FILE_HDR;
+
+	ss->partial = memalign(ARCH_DMA_MINALIGN,
+			       ROUNDUP(info->blksz, ARCH_DMA_MINALIGN));
+	ss->fill_buf = memalign(ARCH_DMA_MINALIGN,
+				ROUNDUP(SPARSE_FILL_BLOCKS * info->blksz,
+					ARCH_DMA_MINALIGN));
+	if (!ss->partial || !ss->fill_buf) {
+		free(ss->partial);
+		free(ss->fill_buf);
+		ss->partial = NULL;
+		ss->fill_buf = NULL;
+		ss->state = SPARSE_STREAM_ERROR;
+		fastboot_fail("Malloc failed for sparse image");
+		return -1;
+	}
+
+	return 0;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, void *buf, unsigned int len)
+{
+	char *data = buf;
+	unsigned int n;
+	int ret = 0;
+
+	while (len && ss->state < SPARSE_STREAM_DONE) {
+		if (ss->skip) {
+			n = min(ss->skip, len);
+			ss->skip -= n;
+			data += n;
+			len -= n;
+			continue;
+		}
+
+		switch (ss->state) {
+		case SPARSE_STREAM_FILE_HDR:
+			if (sparse_collect(ss, &ss->sparse_header,
+					   sizeof(sparse_header_t), &data, &len))
+				ret = sparse_start_file(ss);
 			break;
 
-			case CHUNK_TYPE_DONT_CARE:
-			blk += blkcnt;
-			total_blocks += chunk_header->chunk_sz;
+		case SPARSE_STREAM_CHUNK_HDR:
+			if (sparse_collect(ss, &ss->chunk_header,
+					   sizeof(chunk_header_t), &data, &len))
+				ret = sparse_start_chunk(ss);
 			break;
 
-			case CHUNK_TYPE_CRC32:
-			if (chunk_header->total_sz !=
-			    sparse_header->chunk_hdr_sz)
-			{
-				fastboot_fail(
-					"Bogus chunk size for chunk type Dont Care");
-				return;
-			}
-			total_blocks += chunk_header->chunk_sz;
-			data += chunk_data_sz;
+		case SPARSE_STREAM_RAW:
+			ret = sparse_write_raw(ss, &data, &len);
 			break;
 
-			default:
-			printf("%s: Unknown chunk type: %x\n", __func__,
-			       chunk_header->chunk_type);
-			fastboot_fail("Unknown chunk type");
-			return;
+		case SPARSE_STREAM_FILL:
+			if (sparse_collect(ss, &ss->fill_val, sizeof(uint32_t),
+					   &data, &len))
+				ret = sparse_write_fill(ss);
+			break;
 		}
+
+		if (ret)
+			ss->state = SPARSE_STREAM_ERROR;
+	}
+
+	return ss->state == SPARSE_STREAM_ERROR ? -1 : 0;
+}
+
+/* Wait for the write left in flight by sparse_stream_write() */
+int sparse_stream_sync(struct sparse_stream *ss)
+{
+	lbaint_t blks;
+
+	if (!ss->busy)
+		return 0;
+
+	ss->busy = 0;
+	blks = blk_write_wait(&ss->req);
+	if (blks != ss->req.blkcnt) {
+		printf("%s: Write failed " LBAFU "\n", __func__, blks);
+		fastboot_fail("flash write failure");
+		ss->state = SPARSE_STREAM_ERROR;
+		return -1;
 	}
 
+	return 0;
+}
+
+/* Let a write in flight move on, without waiting for it */
+void sparse_stream_poll(struct sparse_stream *ss)
+{
+	if (ss->busy)
+		blk_write_poll(&ss->req);
+}
+
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name)
+{
+	int ret = -1;
+
+	sparse_stream_sync(ss);
+	free(ss->partial);
+	free(ss->fill_buf);
+	ss->partial = NULL;
+	ss->fill_buf = NULL;
+
+	if (ss->state == SPARSE_STREAM_ERROR)
+		return -1;
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
-	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %u bytes to '%s'\n", bytes_written, part_name);
+	      ss->total_blocks, ss->sparse_header.total_blks);
+	printf("........ wrote %u bytes to '%s'\n", ss->bytes_written,
+	       part_name);
 
-	if (total_blocks != sparse_header->total_blks)
+	if (ss->state != SPARSE_STREAM_DONE ||
+	    ss->total_blocks != ss->sparse_header.total_blks) {
 		fastboot_fail("sparse image write failure");
+	} else {
+		fastboot_okay("");
+		ret = 0;
+	}
+	ss->state = SPARSE_STREAM_ERROR;
+
+	return ret;
+}
+
+void write_sparse_image(block_dev_desc_t *dev_desc,
+		disk_partition_t *info, const char *part_name,
+		void *data, unsigned sz)
+{
+	struct sparse_stream ss;
+
+	if (sparse_stream_init(&ss, dev_desc, info))
+		return;
 
-	fastboot_okay("");
-	return;
+	sparse_stream_write(&ss, data, sz);
+	sparse_stream_finish(&ss, part_name);
 }
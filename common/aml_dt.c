@@ -3,7 +3,10 @@
 #include <command.h>
 #include <image.h>
 #include <malloc.h>
+#include <aml_dt.h>
+#include <lz4.h>
 #include <asm/arch/io.h>
+#include <asm/byteorder.h>
 
 //#define AML_DT_DEBUG
 #ifdef AML_DT_DEBUG
@@ -30,7 +33,6 @@
 
 #define AML_DT_UBOOT_ENV	"aml_dt"
 #define DT_HEADER_MAGIC		0xedfe0dd0	/*header of dtb file*/
-#define AML_DT_HEADER_MAGIC	0x5f4c4d41	/*"AML_", multi dtbs supported*/
 
 #define IS_GZIP_FORMAT(data)		((data & (0x0000FFFF)) == (0x00008B1F))
 #define GUNZIP_BUF_SIZE				(0x500000) /* 5MB */
@@ -52,6 +54,142 @@ int is_dtb_encrypt(unsigned char *buffer)
 	return 1;
 }
 
+static const struct aml_dt_v3_entry *aml_dt_v3_entry(const void *blob,
+						       int index)
+{
+	const struct aml_dt_v3_header *hdr = blob;
+
+	return blob + sizeof(*hdr) + index * le32_to_cpu(hdr->entry_size);
+}
+
+int aml_dt_v3_find(const void *blob, const char *soc, const char *plat,
+		   const char *vari)
+{
+	const struct aml_dt_v3_header *hdr = blob;
+	const char *part[AML_DT_V3_ID_FIELDS] = { soc, plat, vari };
+	char id[AML_DT_V3_ID_SIZE];
+	int lo, hi, mid, cmp, i;
+
+	if (le32_to_cpu(hdr->entry_size) < sizeof(struct aml_dt_v3_entry))
+		return -ENOENT;
+
+	memset(id, 0, sizeof(id));
+	for (i = 0; i < AML_DT_V3_ID_FIELDS; i++) {
+		if (!part[i])
+			continue;
+		/* a longer string cannot be in the index */
+		if (strlen(part[i]) > AML_DT_V3_ID_LEN)
+			return -ENOENT;
+		strncpy(id + i * AML_DT_V3_ID_LEN, part[i], AML_DT_V3_ID_LEN);
+	}
+
+	lo = 0;
+	hi = le32_to_cpu(hdr->count);
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		cmp = memcmp(id, aml_dt_v3_entry(blob, mid)->id, sizeof(id));
+		if (!cmp)
+			return mid;
+		if (cmp < 0)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	return -ENOENT;
+}
+
+void *aml_dt_v3_load(const void *blob, int index, void *dest,
+		     unsigned long dest_size)
+{
+	const struct aml_dt_v3_entry *e = aml_dt_v3_entry(blob, index);
+	const void *src = blob + le32_to_cpu(e->offset);
+	unsigned long size = le32_to_cpu(e->size);
+	unsigned long dtb_size = le32_to_cpu(e->dtb_size);
+	void *copy = NULL;
+	int ret = -EINVAL;
+
+	if (dtb_size > dest_size) {
+		printf("      dtb too large: 0x%lx\n", dtb_size);
+		return NULL;
+	}
+
+	if (e->comp == IH_COMP_NONE) {
+		if (blob == dest)
+			return (void *)src;
+		memmove(dest, src, dtb_size);
+		return dest;
+	}
+
+	/* inflating over the compressed data would overwrite it */
+	if (dest < src + size && src < dest + dtb_size) {
+		copy = malloc(size);
+		if (!copy)
+			return NULL;
+		memcpy(copy, src, size);
+		src = copy;
+	}
+
+	switch (e->comp) {
+	case IH_COMP_GZIP:
+		ret = gunzip(dest, dest_size, (unsigned char *)src, &size);
+		break;
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t len = dest_size;
+
+		ret = ulz4fn(src, size, dest, &len);
+		break;
+	}
+#endif
+	default:
+		printf("      Unsupported dtb compression %d\n", e->comp);
+	}
+	free(copy);
+
+	if (ret || readl(dest) != DT_HEADER_MAGIC) {
+		printf("      Failed to decompress dtb %d\n", index);
+		return NULL;
+	}
+
+	return dest;
+}
+
+/*
+ * Boot-time lookup in a version 3 container: one binary search on the
+ * index and one entry decompressed, straight to @dest. Returns 0 if
+ * there is no usable match.
+ */
+static unsigned long get_dt_v3_entry(unsigned long blob, unsigned long dest,
+				     const char *aml_dt)
+{
+	char *id, *s;
+	char *tokens[AML_DT_ID_VARI_TOTAL] = {NULL, NULL, NULL};
+	void *dtb;
+	int i;
+
+	id = strdup(aml_dt);
+	if (!id)
+		return 0;
+	s = id;
+	for (i = 0; i < AML_DT_ID_VARI_TOTAL; i++)
+		tokens[i] = strsep(&s, "_");
+	printf("        aml_dt soc: %s platform: %s variant: %s\n", tokens[0],
+	       tokens[1], tokens[2]);
+
+	i = aml_dt_v3_find((void *)blob, tokens[0], tokens[1], tokens[2]);
+	free(id);
+	if (i < 0) {
+		printf("      Not match any dtb.\n");
+		return 0;
+	}
+
+	printf("      Find match dtb: %d\n", i);
+	dtb = aml_dt_v3_load((void *)blob, i, (void *)dest, DTB_MAX_SIZE);
+
+	return (unsigned long)dtb;
+}
+
 unsigned long __attribute__((unused))
 	get_multi_dt_entry(unsigned long fdt_addr){
 	unsigned int dt_magic = readl(fdt_addr);
@@ -137,6 +275,15 @@ unsigned long __attribute__((unused))
 		aml_dtb_header_size = 8+(aml_each_id_length * AML_DT_ID_VARI_TOTAL);
 		printf("      Multi dtb tool version: v%d .\n", dt_tool_version);
 
+		if (dt_tool_version == AML_DT_V3_VERSION) {
+			fdt_addr = get_dt_v3_entry(fdt_addr, dt_entry,
+						   aml_dt_buf);
+			free(aml_dt_buf);
+			if (gzip_buf)
+				free(gzip_buf);
+			return fdt_addr ? fdt_addr : dt_entry;
+		}
+
 		/*fdt_addr + 0x8: num of dtbs*/
 		dt_total = readl(fdt_addr + AML_DT_TOTAL_DTB_OFFSET);
 		printf("      Support %d dtbs.\n", dt_total);
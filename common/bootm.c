@@ -15,6 +15,7 @@
 #include <malloc.h>
 #include <asm/io.h>
 #include <linux/lzo.h>
+#include <lz4.h>
 #include <lzma/LzmaTypes.h>
 #include <lzma/LzmaDec.h>
 #include <lzma/LzmaTools.h>
@@ -157,8 +158,6 @@ static int bootm_find_os(cmd_tbl_t *cmdtp, int flag, int argc,
 
 		images.os.end = android_image_get_end(os_hdr);
 		images.os.load = android_image_get_kload(os_hdr);
-		if (images.os.load == 0x10008000)
-			images.os.load = 0x1080000;
 		images.ep = images.os.load;
 		ep_found = true;
 		break;
@@ -324,10 +323,9 @@ static int decomp_image(int comp, ulong load, ulong image_start, int type,
 	*load_end = load;
 	switch (comp) {
 	case IH_COMP_NONE:
-		/*if (load == image_start) {
+		if (load == image_start) {
 			printf("   XIP %s ... ", type_name);
-		} else */
-		{
+		} else {
 			printf("   Loading %s(COMP_NONE) ... ", type_name);
 			memmove_wd(load_buf, image_buf, image_len, CHUNKSZ);
 		}
@@ -401,6 +399,23 @@ static int decomp_image(int comp, ulong load, ulong image_start, int type,
 		break;
 	}
 #endif /* CONFIG_LZO */
+#ifdef CONFIG_LZ4
+	case IH_COMP_LZ4: {
+		size_t size = unc_len;
+		int ret;
+
+		printf("   Uncompressing %s ... ", type_name);
+		ret = ulz4fn(image_buf, image_len, load_buf, &size);
+		if (ret) {
+			printf("LZ4: uncompress or overwrite error %d - must RESET board to recover\n",
+			       ret);
+			return BOOTM_ERR_RESET;
+		}
+
+		*load_end = load + size;
+		break;
+	}
+#endif /* CONFIG_LZ4 */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
@@ -816,6 +831,13 @@ static const void *boot_get_kernel(cmd_tbl_t *cmdtp, int flag, int argc,
 	/* copy from dataflash if needed */
 	img_addr = genimg_get_image(img_addr);
 
+#ifdef CONFIG_ANDROID_BOOT_IMAGE
+	/* Android image whose sections imgread already put in place */
+	buf = android_image_get_placed(img_addr);
+	if (buf)
+		img_addr = map_to_sysmem(buf);
+#endif
+
 	/* check image type, for FIT images get FIT kernel node */
 	*os_data = *os_len = 0;
 	buf = map_sysmem(img_addr, 0);
@@ -13,8 +13,13 @@
  */
 
 #include <common.h>
+#include <bootstage_export.h>
+#include <errno.h>
+#include <fs.h>
 #include <libfdt.h>
 #include <malloc.h>
+#include <u-boot/crc.h>
+#include <asm/io.h>
 #include <linux/compiler.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -137,6 +142,7 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 
 	rec->start_us = timer_get_boot_us();
 	rec->name = name;
+	rec->id = id;
 	return rec->start_us;
 }
 
@@ -292,6 +298,134 @@ void bootstage_report(void)
 	}
 }
 
+int bootstage_export(void *base, int size)
+{
+	struct bootstage_export_hdr *hdr = base;
+	struct bootstage_export_rec *out;
+	struct bootstage_record *rec;
+	char *names, *ptr, *end = (char *)base + size;
+	char buf[20];
+	uint32_t count, flags;
+	int id;
+
+	for (rec = record, id = count = 0; id < BOOTSTAGE_ID_COUNT;
+			id++, rec++) {
+		if (rec->time_us != 0)
+			count++;
+	}
+
+	out = (struct bootstage_export_rec *)(hdr + 1);
+	names = (char *)(out + count);
+	if (names > end)
+		return -ENOSPC;
+
+	/* Write the records and their names, failing if we run out of space */
+	ptr = names;
+	for (rec = record, id = 0; id < BOOTSTAGE_ID_COUNT; id++, rec++) {
+		const char *name;
+		int len;
+
+		if (rec->time_us == 0)
+			continue;
+
+		name = get_record_name(buf, sizeof(buf), rec);
+		len = strlen(name) + 1;
+		if (ptr + len > end)
+			return -ENOSPC;
+
+		flags = 0;
+		if (rec->flags & BOOTSTAGEF_ERROR)
+			flags |= BOOTSTAGE_EXPORTF_ERROR;
+		if (rec->start_us)
+			flags |= BOOTSTAGE_EXPORTF_ACCUM;
+		out->id = cpu_to_le32(rec->id);
+		out->flags = cpu_to_le32(flags);
+		out->time_us = cpu_to_le32(rec->time_us);
+		out->name = cpu_to_le32(ptr - names);
+		memcpy(ptr, name, len);
+		ptr += len;
+		out++;
+	}
+
+	hdr->magic = cpu_to_le32(BOOTSTAGE_EXPORT_MAGIC);
+	hdr->version = cpu_to_le32(BOOTSTAGE_EXPORT_VERSION);
+	hdr->count = cpu_to_le32(count);
+	hdr->size = cpu_to_le32(ptr - (char *)base);
+	hdr->crc32 = cpu_to_le32(crc32(0, (uchar *)(hdr + 1),
+				       ptr - (char *)(hdr + 1)));
+	hdr->reserved = 0;
+
+	return ptr - (char *)base;
+}
+
+/**
+ * Write an export to the file named by the bootstage_file variable
+ *
+ * @param buf	Export to write
+ * @param size	Size of export
+ * @return 0 if ok or no file is set, -ve on error
+ */
+static int bootstage_export_file(void *buf, int size)
+{
+	char *spec, *ifname, *dev_part, *fname;
+	loff_t actwrite;
+	int ret = -EINVAL;
+
+	/* bootstage_file is "<interface> <dev[:part]> <filename>" */
+	spec = getenv("bootstage_file");
+	if (!spec)
+		return 0;
+	spec = strdup(spec);
+	if (!spec)
+		return -ENOMEM;
+
+	ifname = strsep(&spec, " ");
+	dev_part = strsep(&spec, " ");
+	fname = spec;
+	if (ifname && dev_part && fname && *fname) {
+		ret = -EIO;
+		if (!fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY) &&
+		    !fs_write(fname, map_to_sysmem(buf), 0, size, &actwrite))
+			ret = 0;
+	}
+	free(ifname);
+
+	return ret;
+}
+
+int bootstage_export_save(void)
+{
+	void *buf;
+	int size, ret;
+
+#ifdef CONFIG_BOOTSTAGE_EXPORT_ADDR
+	size = CONFIG_BOOTSTAGE_EXPORT_SIZE;
+	buf = map_sysmem(CONFIG_BOOTSTAGE_EXPORT_ADDR, size);
+#else
+	if (!getenv("bootstage_file"))
+		return 0;
+	size = sizeof(struct bootstage_export_hdr) + BOOTSTAGE_ID_COUNT *
+		(sizeof(struct bootstage_export_rec) + 64);
+	buf = malloc(size);
+	if (!buf)
+		return -ENOMEM;
+#endif
+
+	ret = bootstage_export(buf, size);
+	if (ret >= 0)
+		ret = bootstage_export_file(buf, ret);
+	if (ret < 0)
+		printf("bootstage: Failed to export timings (err=%d)\n", ret);
+
+#ifdef CONFIG_BOOTSTAGE_EXPORT_ADDR
+	unmap_sysmem(buf);
+#else
+	free(buf);
+#endif
+
+	return ret < 0 ? ret : 0;
+}
+
 ulong __timer_get_boot_us(void)
 {
 	static ulong base_time;
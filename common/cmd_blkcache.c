@@ -0,0 +1,82 @@
+/*
+ * Block cache statistics and control
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <part.h>
+
+static int do_blkcache_show(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	struct block_cache_stats stats;
+	unsigned total;
+
+	blkcache_stats(&stats);
+	total = stats.hits + stats.misses;
+
+	printf("    hits: %u\n"
+	       "    misses: %u\n"
+	       "    hit rate: %u%%\n"
+	       "    readahead blocks: %u\n"
+	       "    entries: %u\n"
+	       "    max blocks/entry: %u\n"
+	       "    max entries: %u\n",
+	       stats.hits, stats.misses,
+	       total ? stats.hits * 100 / total : 0,
+	       stats.readahead, stats.entries,
+	       stats.max_blocks_per_entry, stats.max_entries);
+
+	return 0;
+}
+
+static int do_blkcache_configure(cmd_tbl_t *cmdtp, int flag, int argc,
+				 char * const argv[])
+{
+	unsigned blocks, entries;
+
+	if (argc != 3)
+		return CMD_RET_USAGE;
+
+	blocks = simple_strtoul(argv[1], NULL, 0);
+	entries = simple_strtoul(argv[2], NULL, 0);
+	blkcache_configure(blocks, entries);
+
+	printf("changed to max of %u entries of %u blocks each\n",
+	       entries, blocks);
+
+	return 0;
+}
+
+static cmd_tbl_t cmd_blkcache_sub[] = {
+	U_BOOT_CMD_MKENT(show, 1, 0, do_blkcache_show, "", ""),
+	U_BOOT_CMD_MKENT(configure, 3, 0, do_blkcache_configure, "", ""),
+};
+
+static int do_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	/* Skip past 'blkcache' */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], cmd_blkcache_sub,
+			 ARRAY_SIZE(cmd_blkcache_sub));
+
+	if (c)
+		return c->cmd(cmdtp, flag, argc, argv);
+	else
+		return CMD_RET_USAGE;
+}
+
+U_BOOT_CMD(
+	blkcache,	4,	0,	do_blkcache,
+	"block cache diagnostics and control",
+	"show - show and reset statistics\n"
+	"blkcache configure <blocks> <entries> - set max blocks per entry\n"
+	"    and number of entries, 0 entries disables the cache"
+);
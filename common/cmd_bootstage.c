@@ -11,6 +11,11 @@
 #define CONFIG_BOOTSTAGE_STASH_SIZE	-1
 #endif
 
+#ifndef CONFIG_BOOTSTAGE_EXPORT_ADDR
+#define CONFIG_BOOTSTAGE_EXPORT_ADDR	-1UL
+#define CONFIG_BOOTSTAGE_EXPORT_SIZE	0x4000
+#endif
+
 static int do_bootstage_report(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
 {
@@ -24,8 +29,13 @@ static int get_base_size(int argc, char * const argv[], ulong *basep,
 {
 	char *endp;
 
-	*basep = CONFIG_BOOTSTAGE_STASH;
-	*sizep = CONFIG_BOOTSTAGE_STASH_SIZE;
+	if (!strcmp(argv[0], "export")) {
+		*basep = CONFIG_BOOTSTAGE_EXPORT_ADDR;
+		*sizep = CONFIG_BOOTSTAGE_EXPORT_SIZE;
+	} else {
+		*basep = CONFIG_BOOTSTAGE_STASH;
+		*sizep = CONFIG_BOOTSTAGE_STASH_SIZE;
+	}
 	if (argc < 2)
 		return 0;
 	*basep = simple_strtoul(argv[1], &endp, 16);
@@ -63,10 +73,35 @@ static int do_bootstage_stash(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+static int do_bootstage_export(cmd_tbl_t *cmdtp, int flag, int argc,
+			       char * const argv[])
+{
+	ulong base, size;
+	int ret;
+
+	if (get_base_size(argc, argv, &base, &size))
+		return CMD_RET_USAGE;
+	if (base == -1UL) {
+		printf("No bootstage export area defined\n");
+		return 1;
+	}
+
+	ret = bootstage_export((void *)base, size);
+	if (ret < 0) {
+		printf("Not enough space for bootstage export\n");
+		return 1;
+	}
+	printf("Exported %d bytes to %08lx\n", ret, base);
+	setenv_hex("filesize", ret);
+
+	return 0;
+}
+
 static cmd_tbl_t cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+	U_BOOT_CMD_MKENT(export, 4, 0, do_bootstage_export, "", ""),
 };
 
 /*
@@ -96,5 +131,6 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	" - check boot progress and timing\n"
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
-	"unstash [<start> [<size>]]  - Unstash data from memory"
+	"unstash [<start> [<size>]]  - Unstash data from memory\n"
+	"export [<start> [<size>]]   - Export timings for bootstage-diff"
 );
@@ -17,6 +17,14 @@
 #include <asm/arch/bl31_apis.h>
 #include <asm/arch/secure_apb.h>
 #include <libfdt.h>
+#include <lz4.h>
+#include <malloc.h>
+#include <u-boot/zlib.h>
+#include <asm/unaligned.h>
+#ifdef CONFIG_AML_LOGO_FB_CACHE
+#include <video.h>
+#include <u-boot/crc.h>
+#endif
 
 typedef struct andr_img_hdr boot_img_hdr;
 
@@ -25,9 +33,10 @@ typedef struct andr_img_hdr boot_img_hdr;
 #define wrnP(fmt...)   printf("wrn:"fmt)
 #define MsgP(fmt...)   printf("[imgread]"fmt)
 
-#define IMG_PRELOAD_SZ  (1U<<20) //Total read 1M at first to read the image header
-#define PIC_PRELOAD_SZ  (8U<<10) //Total read 4k at first to read the image header
-#define RES_OLD_FMT_READ_SZ (8U<<20)
+#define RES_HEAD_READ_SZ (512U) //res image header and the first item heads, the table is read up to its size
+#define IMG_HEAD_PRELOAD_SZ (2U<<10) //android header, or header of a secure boot image
+#define IMG_STREAM_CHUNK_SZ (256U<<10) //kernel read and inflated in pieces of this size
+#define IMG_SECOND_MIN_SZ   (256U<<10)
 
 typedef struct __aml_enc_blk{
         unsigned int  nOffset;
@@ -216,6 +225,167 @@ static int do_image_read_dtb(cmd_tbl_t *cmdtp, int flag, int argc, char * const
 }
 
 
+#ifdef CONFIG_ANDROID_IMG_PLACE
+static int _img_read_timed(const char* partName, unsigned char* buf, uint64_t off, unsigned sz)
+{
+    int rc;
+
+    bootstage_start(BOOTSTAGE_ID_ACCUM_IMGREAD_READ, "imgread_read");
+    rc = store_read_ops((unsigned char*)partName, buf, off, sz);
+    bootstage_accum(BOOTSTAGE_ID_ACCUM_IMGREAD_READ);
+    if (rc)
+        errorP("Fail to read 0x%xB from part[%s] at offset 0x%llx\n", sz, partName, off);
+
+    return rc;
+}
+
+//Inflate a gzip kernel to its load address while it is read, chunk by chunk
+static int _img_stream_gunzip(const char* partName, uint64_t off, unsigned compSz,
+        unsigned char* chunk, unsigned firstSz, unsigned char* dst, ulong* dstSz)
+{
+    z_stream s;
+    unsigned inSz = firstSz;
+    int r;
+
+    memset(&s, 0, sizeof(s));
+    s.zalloc = gzalloc;
+    s.zfree = gzfree;
+    r = inflateInit2(&s, 16 + MAX_WBITS);//gzip wrapped
+    if (r != Z_OK) {
+        errorP("inflateInit2() returned %d\n", r);
+        return __LINE__;
+    }
+    s.next_out = dst;
+    s.avail_out = *dstSz;
+
+    for (;;) {
+        s.next_in = chunk;
+        s.avail_in = inSz;
+        bootstage_start(BOOTSTAGE_ID_ACCUM_IMGREAD_INFLATE, "imgread_inflate");
+        r = inflate(&s, Z_NO_FLUSH);
+        bootstage_accum(BOOTSTAGE_ID_ACCUM_IMGREAD_INFLATE);
+        if (r == Z_STREAM_END)
+            break;
+        if (r != Z_OK || s.avail_in || !compSz) {
+            errorP("Kernel inflate failed %d, out 0x%lx\n", r, s.total_out);
+            inflateEnd(&s);
+            return __LINE__;
+        }
+        inSz = min(compSz, IMG_STREAM_CHUNK_SZ);
+        if (_img_read_timed(partName, chunk, off, inSz)) {
+            inflateEnd(&s);
+            return __LINE__;
+        }
+        off += inSz;
+        compSz -= inSz;
+    }
+    *dstSz = s.total_out;
+    inflateEnd(&s);
+
+    return 0;
+}
+
+/*
+ * Load an android image section by section instead of as one blob: the kernel
+ * goes straight to its load address (inflated on the fly if it is gzip), and
+ * ramdisk and second are read into a buffer they can be booted from.
+ * bootm then neither moves the image out of the way of the kernel nor
+ * relocates the ramdisk.
+ *
+ * Returns 0 when placed, -1 to fall back to a contiguous load (nothing beyond
+ * the header has been read then), or the line of the error.
+ */
+static int _img_place_android(const char* partName, unsigned char* loadaddr, uint64_t imgOff)
+{
+    const boot_img_hdr* hdr = (const boot_img_hdr*)loadaddr;
+    const unsigned pageSz   = hdr->page_size;
+    const unsigned kernelSz = ALIGN(hdr->kernel_size, pageSz);
+    const unsigned restSz   = ALIGN(hdr->ramdisk_size, pageSz) + ALIGN(hdr->second_size, pageSz);
+    //multi-dtb entries are unpacked where second is, up to 256K
+    const unsigned restBufSz = ALIGN(hdr->ramdisk_size, pageSz) + max(ALIGN(hdr->second_size, pageSz), IMG_SECOND_MIN_SZ);
+    const unsigned firstSz  = min(kernelSz, IMG_STREAM_CHUNK_SZ);
+    const ulong kload       = android_image_get_kload(hdr);
+    uint64_t off            = imgOff + pageSz;
+    struct andr_img_placed placed;
+    unsigned char* chunk = NULL;
+    unsigned char* buf = NULL;
+    unsigned keptKernelSz = 0;
+    ulong kernelMax = 0;
+    int comp;
+    int rc = __LINE__;
+
+    if (pageSz < IMG_HEAD_PRELOAD_SZ || (pageSz & (pageSz - 1)) || !hdr->kernel_size)
+        return -1;
+
+    //header page then the first kernel chunk, so the kernel format can be told
+    chunk = malloc(pageSz + IMG_STREAM_CHUNK_SZ);
+    if (!chunk)
+        return -1;
+    memcpy(chunk, hdr, IMG_HEAD_PRELOAD_SZ);
+    if (_img_read_timed(partName, chunk + pageSz, off, firstSz))
+        goto _out;
+    off += firstSz;
+
+    comp = android_image_get_comp((const boot_img_hdr*)chunk);
+    if (IH_COMP_NONE == comp)
+        kernelMax = kernelSz;
+    else if (IH_COMP_GZIP == comp)
+        kernelMax = CONFIG_SYS_BOOTM_LEN;
+    else
+        keptKernelSz = kernelSz;//left for bootm to decompress
+
+    buf = malloc(pageSz + keptKernelSz + restBufSz);
+    if (!buf || (kernelMax && kload < (ulong)buf + pageSz + restBufSz && (ulong)buf < kload + kernelMax)
+            || (kernelMax && kload < (ulong)chunk + pageSz + IMG_STREAM_CHUNK_SZ && (ulong)chunk < kload + kernelMax)) {
+        free(buf);
+        free(chunk);
+        return -1;
+    }
+    memcpy(buf, chunk, pageSz);
+
+    placed.hdr = (const boot_img_hdr*)buf;
+    placed.buf = buf;
+    placed.kernel_comp = IH_COMP_NONE;
+    placed.kernel_len = hdr->kernel_size;
+    placed.kernel_data = kload;
+    placed.rd_data = (ulong)buf + pageSz + keptKernelSz;
+    placed.second_data = placed.rd_data + ALIGN(hdr->ramdisk_size, pageSz);
+
+    if (keptKernelSz) {
+        memcpy(buf + pageSz, chunk + pageSz, firstSz);
+        if (kernelSz > firstSz && _img_read_timed(partName, buf + pageSz + firstSz, off, kernelSz - firstSz))
+            goto _out;
+        placed.kernel_comp = comp;
+        placed.kernel_data = (ulong)buf + pageSz;
+    } else if (IH_COMP_NONE == comp) {
+        memcpy((void*)kload, chunk + pageSz, firstSz);
+        if (kernelSz > firstSz && _img_read_timed(partName, (unsigned char*)kload + firstSz, off, kernelSz - firstSz))
+            goto _out;
+    } else {
+        placed.kernel_len = kernelMax;
+        if (_img_stream_gunzip(partName, off, kernelSz - firstSz, chunk + pageSz, firstSz,
+                    (unsigned char*)kload, &placed.kernel_len))
+            goto _out;
+    }
+    off = imgOff + pageSz + kernelSz;
+
+    if (restSz && _img_read_timed(partName, (unsigned char*)placed.rd_data, off, restSz))
+        goto _out;
+
+    android_image_set_placed((ulong)loadaddr, &placed);
+    MsgP("kernel(%s) 0x%lx B at 0x%lx, ramdisk+second 0x%x B at 0x%lx, %s\n",
+            genimg_get_comp_name(comp), placed.kernel_len, placed.kernel_data,
+            restSz, placed.rd_data, keptKernelSz ? "kernel left for bootm" : "nothing left to move");
+    buf = NULL;//freed with the placed record
+    rc = 0;
+
+_out:
+    free(buf);
+    free(chunk);
+    return rc;
+}
+#endif// #ifdef CONFIG_ANDROID_IMG_PLACE
+
 static int do_image_read_kernel(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
     unsigned    kernel_size;
@@ -240,12 +410,15 @@ static int do_image_read_kernel(cmd_tbl_t *cmdtp, int flag, int argc, char * con
 
     if (3 < argc) flashReadOff = simple_strtoull(argv[3], NULL, 0) ;
 
-    rc = store_read_ops((unsigned char*)partName, loadaddr, flashReadOff, IMG_PRELOAD_SZ);
+    bootstage_mark_name(BOOTSTAGE_KERNELREAD_START, "kernelread_start");
+#ifdef CONFIG_ANDROID_BOOT_IMAGE
+    android_image_set_placed(0, NULL);
+#endif
+    rc = store_read_ops((unsigned char*)partName, loadaddr, flashReadOff, IMG_HEAD_PRELOAD_SZ);
     if (rc) {
-        errorP("Fail to read 0x%xB from part[%s] at offset 0\n", IMG_PRELOAD_SZ, partName);
+        errorP("Fail to read 0x%xB from part[%s] at offset 0\n", IMG_HEAD_PRELOAD_SZ, partName);
         return __LINE__;
     }
-    flashReadOff += IMG_PRELOAD_SZ;
 
     genFmt = genimg_get_format(hdr_addr);
     if (IMAGE_FORMAT_ANDROID != genFmt) {
@@ -275,14 +448,26 @@ static int do_image_read_kernel(cmd_tbl_t *cmdtp, int flag, int argc, char * con
         debugP("dtbSz 0x%x, Total actualBootImgSz 0x%x\n", dtbSz, actualBootImgSz);
     }
 
-    if (actualBootImgSz > IMG_PRELOAD_SZ)
+#ifdef CONFIG_ANDROID_IMG_PLACE
+    if (!secureKernelImgSz)
     {
-        const unsigned leftSz = actualBootImgSz - IMG_PRELOAD_SZ;
+        rc = _img_place_android(partName, loadaddr, flashReadOff);
+        if (rc >= 0) {
+            bootstage_mark_name(BOOTSTAGE_KERNELREAD_STOP, "kernelread_done");
+            return rc;
+        }
+    }
+#endif// #ifdef CONFIG_ANDROID_IMG_PLACE
+
+    if (actualBootImgSz > IMG_HEAD_PRELOAD_SZ)
+    {
+        const unsigned leftSz = actualBootImgSz - IMG_HEAD_PRELOAD_SZ;
 
         debugP("Left sz 0x%x\n", leftSz);
-        rc = store_read_ops((unsigned char*)partName, loadaddr + IMG_PRELOAD_SZ, flashReadOff, leftSz);
+        rc = store_read_ops((unsigned char*)partName, loadaddr + IMG_HEAD_PRELOAD_SZ,
+                flashReadOff + IMG_HEAD_PRELOAD_SZ, leftSz);
         if (rc) {
-            errorP("Fail to read 0x%xB from part[%s] at offset 0x%x\n", leftSz, partName, IMG_PRELOAD_SZ);
+            errorP("Fail to read 0x%xB from part[%s] at offset 0x%x\n", leftSz, partName, IMG_HEAD_PRELOAD_SZ);
             return __LINE__;
         }
     }
@@ -291,6 +476,7 @@ static int do_image_read_kernel(cmd_tbl_t *cmdtp, int flag, int argc, char * con
     //because secure boot will use DMA which need disable MMU temp
     //here must update the cache, otherwise nand will fail (eMMC is OK)
     flush_cache((unsigned long)loadaddr,(unsigned long)actualBootImgSz);
+    bootstage_mark_name(BOOTSTAGE_KERNELREAD_STOP, "kernelread_done");
 
     return 0;
 }
@@ -320,8 +506,6 @@ typedef struct {
 }AmlResImgHead_t;
 #pragma pack(pop)
 
-#define LOGO_OLD_FMT_READ_SZ (8U<<20)//if logo format old, read 8M
-
 static int img_res_check_log_header(const AmlResImgHead_t* pResImgHead)
 {
     int rc = 0;
@@ -339,6 +523,45 @@ static int img_res_check_log_header(const AmlResImgHead_t* pResImgHead)
     return 0;
 }
 
+//Read the res image header and its item table to loadaddr, return how many bytes were read, 0 on error
+static unsigned img_res_read_head(const char* partName, unsigned char* loadaddr)
+{
+    const AmlResImgHead_t* pResImgHead = (AmlResImgHead_t*)loadaddr;
+    unsigned tableSz = 0;
+    int rc = 0;
+
+    rc = store_read_ops((unsigned char*)partName, loadaddr, 0, RES_HEAD_READ_SZ);
+    if (rc) {
+        errorP("Fail to read 0x%xB from part[%s] at offset 0\n", RES_HEAD_READ_SZ, partName);
+        return 0;
+    }
+
+    if (img_res_check_log_header(pResImgHead)) {
+        errorP("Logo header err.\n");
+        return 0;
+    }
+
+    if (pResImgHead->imgItemNum >= pResImgHead->imgSz / AML_RES_ITEM_HEAD_SZ) {
+        errorP("item num %u too large for image sz 0x%x\n", pResImgHead->imgItemNum, pResImgHead->imgSz);
+        return 0;
+    }
+    tableSz = AML_RES_IMG_HEAD_SZ + pResImgHead->imgItemNum * AML_RES_ITEM_HEAD_SZ;
+    tableSz = ALIGN(tableSz, RES_HEAD_READ_SZ);
+    if (tableSz > RES_HEAD_READ_SZ)
+    {
+        rc = store_read_ops((unsigned char*)partName, loadaddr + RES_HEAD_READ_SZ,
+                RES_HEAD_READ_SZ, tableSz - RES_HEAD_READ_SZ);
+        if (rc) {
+            errorP("Fail to read 0x%xB from part[%s] at offset 0x%x\n",
+                    tableSz - RES_HEAD_READ_SZ, partName, RES_HEAD_READ_SZ);
+            return 0;
+        }
+    }
+    debugP("item num %u, table sz 0x%x\n", pResImgHead->imgItemNum, tableSz);
+
+    return tableSz;
+}
+
 static int do_image_read_res(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
     const char* const partName = argv[1];
@@ -356,27 +579,20 @@ static int do_image_read_res(cmd_tbl_t *cmdtp, int flag, int argc, char * const
     }
     pResImgHead = (AmlResImgHead_t*)loadaddr;
 
-    rc = store_read_ops((unsigned char*)partName, loadaddr, flashReadOff, IMG_PRELOAD_SZ);
-    if (rc) {
-        errorP("Fail to read 0x%xB from part[%s] at offset 0\n", IMG_PRELOAD_SZ, partName);
-        return __LINE__;
-    }
-    flashReadOff = IMG_PRELOAD_SZ;
-
-    if (img_res_check_log_header(pResImgHead)) {
-        errorP("Logo header err.\n");
+    flashReadOff = img_res_read_head(partName, loadaddr);
+    if (!flashReadOff) {
         return __LINE__;
     }
 
     //Read the actual size of the new version res imgae
     totalSz = pResImgHead->imgSz;
-    if (totalSz > IMG_PRELOAD_SZ )
+    if (totalSz > flashReadOff)
     {
-        const unsigned leftSz = totalSz - flashReadOff;
+        const unsigned leftSz = totalSz - (unsigned)flashReadOff;
 
         rc = store_read_ops((unsigned char*)partName, loadaddr + (unsigned)flashReadOff, flashReadOff, leftSz);
         if (rc) {
-            errorP("Fail to read 0x%xB from part[%s] at offset 0x%x\n", leftSz, partName, IMG_PRELOAD_SZ);
+            errorP("Fail to read 0x%xB from part[%s] at offset 0x%x\n", leftSz, partName, (unsigned)flashReadOff);
             return __LINE__;
         }
     }
@@ -418,10 +634,217 @@ static int imgread_uncomp_pic(unsigned char* srcAddr, const unsigned srcSz,
         *dstDatSz = srcSz;
         return gunzip(dstAddr, dstBufSz, srcAddr, dstDatSz);
     }
+#ifdef CONFIG_LZ4
+    if (get_unaligned_le32(srcAddr) == LZ4_MAGIC || get_unaligned_le32(srcAddr) == LZ4_LEGACY_MAGIC)
+    {
+        size_t unLz4Sz = dstBufSz;
+        int rc = ulz4fn(srcAddr, srcSz, dstAddr, &unLz4Sz);
+
+        *dstDatSz = unLz4Sz;
+        return rc;
+    }
+#endif// #ifdef CONFIG_LZ4
 
     return 0;
 }
 
+//correct bootup for mbox
+static const char* img_res_pic_name(const char* picName)
+{
+    char* outputmode = getenv("outputmode");
+
+    if (strcmp("bootup", picName) || !outputmode) return picName;//not env outputmode
+
+    if (!strncmp("720", outputmode, 3) || !strncmp("576", outputmode, 3) || !strncmp("480", outputmode, 3))
+        return "bootup_720";
+
+    return "bootup_1080";
+}
+
+//first item named picName or orgName in the table read by img_res_read_head
+static const AmlResItemHead_t* img_res_find_item(const AmlResImgHead_t* pResImgHead,
+        const char* picName, const char* orgName)
+{
+    const AmlResItemHead_t* pItem = (AmlResItemHead_t*)(pResImgHead + 1);
+    unsigned itemIndex = 0;
+
+    for (itemIndex = 0; itemIndex < pResImgHead->imgItemNum; ++itemIndex, ++pItem)
+    {
+        if (IH_MAGIC != pItem->magic) {
+            errorP("item magic 0x%x != 0x%x\n", pItem->magic, IH_MAGIC);
+            return NULL;
+        }
+        if (!strcmp(picName, pItem->name) || !strcmp(orgName, pItem->name))
+            return pItem;
+    }
+
+    return NULL;
+}
+
+#ifdef CONFIG_AML_LOGO_FB_CACHE
+/*
+ * A copy of the frame buffer, as left by drawing one picture of the logo
+ * image, is kept in the logo part after the image. When it matches the
+ * picture, the image and the current display it is read straight into the
+ * frame buffer, with no bmp to read, inflate or convert.
+ */
+#define LOGO_FB_CACHE_MAGIC     0x43424654  //"TFBC"
+#define LOGO_FB_CACHE_ALIGN     (4U<<10)
+#define LOGO_FB_CACHE_HEAD_SZ   512 //pixels follow the head
+
+typedef struct {
+    __u32   magic;
+    __u32   hcrc;       //crc32 of this head, with hcrc 0
+    __u32   imgCrc;     //crc of the logo image the picture is in
+    __u32   imgSz;
+    __u32   itemStart;
+    __u32   itemSz;
+    __u32   width;      //frame buffer, see video_get_fb()
+    __u32   height;
+    __u32   format;
+    __u32   dataSz;
+    char    name[IH_NMLEN];
+}LogoFbCacheHead_t;
+
+//fill the head a cache of pItem would have for the current frame buffer, return its address or 0
+static ulong _logo_fb_cache_head(LogoFbCacheHead_t* pHead, const AmlResImgHead_t* pResImgHead,
+        const AmlResItemHead_t* pItem)
+{
+    ulong fbBase = 0;
+
+    memset(pHead, 0, sizeof(*pHead));
+    pHead->dataSz = video_get_fb(&fbBase, &pHead->width, &pHead->height, &pHead->format);
+    if (!pHead->dataSz) return 0;
+
+    pHead->magic     = LOGO_FB_CACHE_MAGIC;
+    pHead->imgCrc    = pResImgHead->crc;
+    pHead->imgSz     = pResImgHead->imgSz;
+    pHead->itemStart = pItem->start;
+    pHead->itemSz    = pItem->size;
+    memcpy(pHead->name, pItem->name, IH_NMLEN);
+    pHead->hcrc      = crc32(0, (unsigned char*)pHead, sizeof(*pHead));
+
+    return fbBase;
+}
+
+static inline uint64_t _logo_fb_cache_off(const AmlResImgHead_t* pResImgHead)
+{
+    return ALIGN((uint64_t)pResImgHead->imgSz, LOGO_FB_CACHE_ALIGN);
+}
+
+//0 if the cache in the part has the head pHead
+static int _logo_fb_cache_check(const char* partName, const AmlResImgHead_t* pResImgHead,
+        const LogoFbCacheHead_t* pHead)
+{
+    ALLOC_CACHE_ALIGN_BUFFER(unsigned char, headBuf, LOGO_FB_CACHE_HEAD_SZ);
+    int rc = 0;
+
+    rc = store_read_ops((unsigned char*)partName, headBuf, _logo_fb_cache_off(pResImgHead), LOGO_FB_CACHE_HEAD_SZ);
+    if (rc) {
+        debugP("Fail to read fb cache head\n");
+        return __LINE__;
+    }
+
+    return memcmp(headBuf, pHead, sizeof(*pHead)) ? __LINE__ : 0;
+}
+
+static int _logo_fb_cache_load(const char* partName, const AmlResImgHead_t* pResImgHead,
+        const AmlResItemHead_t* pItem)
+{
+    LogoFbCacheHead_t head;
+    ulong fbBase = 0;
+    int rc = 0;
+
+    fbBase = _logo_fb_cache_head(&head, pResImgHead, pItem);
+    if (!fbBase) return __LINE__;
+    if (_logo_fb_cache_check(partName, pResImgHead, &head)) return __LINE__;
+
+    //the storage dma fills the frame buffer
+    rc = store_read_ops((unsigned char*)partName, (unsigned char*)fbBase,
+            _logo_fb_cache_off(pResImgHead) + LOGO_FB_CACHE_HEAD_SZ, head.dataSz);
+    if (rc) {
+        errorP("Fail to read fb cache of pic[%s]\n", head.name);
+        memset((void*)fbBase, 0, head.dataSz);
+        flush_cache(fbBase, head.dataSz);
+        return __LINE__;
+    }
+    debugP("pic[%s] from fb cache, sz 0x%x\n", head.name, head.dataSz);
+
+    return video_display_fb();
+}
+
+//[imgread fbcache] logo bootup $loadaddr_misc, after the picture was drawn by 'bmp display'
+static int do_image_save_fb(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+    const char* const partName = argv[1];
+    unsigned char* loadaddr = 0;
+    const AmlResImgHead_t* pResImgHead = NULL;
+    const AmlResItemHead_t* pItem = NULL;
+    LogoFbCacheHead_t head;
+    unsigned char* headBuf = NULL;
+    ulong fbBase = 0;
+    uint64_t cacheOff = 0;
+    uint64_t partSz = 0;
+    int rc = 0;
+
+    if (argc < 3) return CMD_RET_USAGE;
+
+    loadaddr = (unsigned char*)simple_strtoul(argc > 3 ? argv[3] : getenv("loadaddr_misc"), NULL, 16);
+    pResImgHead = (AmlResImgHead_t*)loadaddr;
+
+    if (!img_res_read_head(partName, loadaddr)) return __LINE__;
+    pItem = img_res_find_item(pResImgHead, img_res_pic_name(argv[2]), argv[2]);
+    if (!pItem) {
+        errorP("pic[%s] not in part[%s]\n", argv[2], partName);
+        return __LINE__;
+    }
+
+    fbBase = _logo_fb_cache_head(&head, pResImgHead, pItem);
+    if (!fbBase) {
+        errorP("no frame buffer\n");
+        return __LINE__;
+    }
+    if (!_logo_fb_cache_check(partName, pResImgHead, &head)) {
+        debugP("fb cache of pic[%s] up to date\n", head.name);
+        return 0;
+    }
+
+    cacheOff = _logo_fb_cache_off(pResImgHead);
+    rc = store_get_partititon_size((unsigned char*)partName, &partSz);
+    if (rc || cacheOff + LOGO_FB_CACHE_HEAD_SZ + head.dataSz > (partSz << 9)) {
+        wrnP("no room for fb cache 0x%xB in part[%s]\n", head.dataSz, partName);
+        return __LINE__;
+    }
+
+    headBuf = malloc(LOGO_FB_CACHE_HEAD_SZ);
+    if (!headBuf) {
+        errorP("Fail to malloc fb cache head\n");
+        return __LINE__;
+    }
+
+    //invalidate the old cache while its pixels are overwritten
+    memset(headBuf, 0, LOGO_FB_CACHE_HEAD_SZ);
+    rc = store_write_ops((unsigned char*)partName, headBuf, cacheOff, LOGO_FB_CACHE_HEAD_SZ);
+    if (!rc) {
+        flush_cache(fbBase, head.dataSz);
+        rc = store_write_ops((unsigned char*)partName, (unsigned char*)fbBase,
+                cacheOff + LOGO_FB_CACHE_HEAD_SZ, head.dataSz);
+    }
+    if (!rc) {
+        memcpy(headBuf, &head, sizeof(head));
+        rc = store_write_ops((unsigned char*)partName, headBuf, cacheOff, LOGO_FB_CACHE_HEAD_SZ);
+    }
+    free(headBuf);
+    if (rc) {
+        errorP("Fail to write fb cache to part[%s] at offset 0x%llx\n", partName, cacheOff);
+        return __LINE__;
+    }
+    MsgP("fb cache of pic[%s] saved, sz 0x%x\n", head.name, head.dataSz);
+
+    return 0;
+}
+#endif// #ifdef CONFIG_AML_LOGO_FB_CACHE
+
 //[imgread pic] logo bootup $loadaddr_misc
 static int do_image_read_pic(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -429,102 +852,82 @@ static int do_image_read_pic(cmd_tbl_t *cmdtp, int flag, int argc, char * const
     unsigned char* loadaddr = 0;
     int rc = 0;
     const AmlResImgHead_t* pResImgHead = NULL;
-    //unsigned totalSz    = 0;
     uint64_t flashReadOff = 0;
-    const unsigned PreloadSz = PIC_PRELOAD_SZ;//preload 8k, 124-1 pic header, If you need pack more than 123 items,  fix this
-    unsigned itemIndex = 0;
     const AmlResItemHead_t* pItem = NULL;
     const char* picName = argv[2];
+    char env_name[IH_NMLEN*2];
+    char env_data[IH_NMLEN*2];
 
+    bootstage_mark_name(BOOTSTAGE_LOGOREAD_START, "logoread_start");
     loadaddr = (unsigned char*)simple_strtoul(argc > 3 ? argv[3] : getenv("loadaddr_misc"), NULL, 16);
 
     pResImgHead = (AmlResImgHead_t*)loadaddr;
 
+#ifdef CONFIG_AML_LOGO_FB_CACHE
+    sprintf(env_name, "%s_cached", argv[2]);
+    setenv(env_name, "0");
+#endif// #ifdef CONFIG_AML_LOGO_FB_CACHE
+
     debugP("to read pic (%s)\n", picName);
-    rc = store_read_ops((unsigned char*)partName, loadaddr, flashReadOff, PreloadSz);
-    if (rc) {
-        errorP("Fail to read 0x%xB from part[%s] at offset 0\n", PreloadSz, partName);
+    //only the header and the item table, the picture itself is read below
+    flashReadOff = img_res_read_head(partName, loadaddr);
+    if (!flashReadOff) {
         return __LINE__;
     }
-    flashReadOff = PreloadSz;
-    debugP("end read pic sz %d\n", PreloadSz);
 
-    if (img_res_check_log_header(pResImgHead)) {
-        errorP("Logo header err.\n");
-        return __LINE__;
+    picName = img_res_pic_name(picName);
+    pItem = img_res_find_item(pResImgHead, picName, argv[2]);
+    if (!pItem) {
+        return __LINE__;//fail
     }
 
-    //correct bootup for mbox
-    while (!strcmp("bootup", picName))
-    {
-            char* outputmode = getenv("outputmode");
-            if (!outputmode)break;//not env outputmode
+#ifdef CONFIG_AML_LOGO_FB_CACHE
+    if (!_logo_fb_cache_load(partName, pResImgHead, pItem)) {
+        setenv(env_name, "1");
+        return 0;
+    }
+#endif// #ifdef CONFIG_AML_LOGO_FB_CACHE
 
-            rc = !strncmp("720", outputmode, 3) || !strncmp("576", outputmode, 3) || !strncmp("480", outputmode, 3);
-            if (rc) {
-                    picName = "bootup_720";
-                    break;
-            }
+    unsigned long picLoadAddr = (unsigned long)loadaddr + (unsigned)pItem->start;
+    int         itemSz      = pItem->size;
+    int         uncompSz    = 0;
 
-            picName = "bootup_1080";
-            break;
+    if (pItem->start + itemSz > flashReadOff)
+    {
+        //emmc read can't support offset not align 512
+        rc = store_read_ops((unsigned char*)partName, (unsigned char *)((picLoadAddr>>9)<<9),
+                ((pItem->start>>9)<<9), itemSz + (picLoadAddr & 0x1ff));
+        if (rc) {
+            errorP("Fail to read pic at offset 0x%x\n", pItem->start);
+            return __LINE__;
+        }
+        debugP("pic sz 0x%x\n", itemSz);
     }
 
-    pItem = (AmlResItemHead_t*)(pResImgHead + 1);
-    for (itemIndex = 0; itemIndex < pResImgHead->imgItemNum; ++itemIndex, ++pItem)
-    {
-            if (IH_MAGIC != pItem->magic) {
-                    errorP("item magic 0x%x != 0x%x\n", pItem->magic, IH_MAGIC);
-                    return __LINE__;
-            }
-            if (!strcmp(picName, pItem->name) || !strcmp(argv[2], pItem->name))
-            {
-                    char env_name[IH_NMLEN*2];
-                    char env_data[IH_NMLEN*2];
-                    unsigned long picLoadAddr = (unsigned long)loadaddr + (unsigned)pItem->start;
-                    int         itemSz      = pItem->size;
-                    int         uncompSz    = 0;
-
-                    if (pItem->start + itemSz > flashReadOff)
-                    {
-                        //emmc read can't support offset not align 512
-                        rc = store_read_ops((unsigned char*)partName, (unsigned char *)((picLoadAddr>>9)<<9),
-                                ((pItem->start>>9)<<9), itemSz + (picLoadAddr & 0x1ff));
-                        if (rc) {
-                            errorP("Fail to read pic at offset 0x%x\n", pItem->start);
-                            return __LINE__;
-                        }
-                        debugP("pic sz 0x%x\n", itemSz);
-                    }
-
-                    //uncompress supported format
-                    unsigned long uncompLoadaddr = picLoadAddr + itemSz + 7;
-                    uncompLoadaddr &= ~(0x7U);
-                    rc = imgread_uncomp_pic((unsigned char*)picLoadAddr, itemSz, (unsigned char*)uncompLoadaddr,
-                            CONFIG_MAX_PIC_LEN, (unsigned long*)&uncompSz);
-                    if (rc) {
-                        errorP("Fail in uncomp pic,rc[%d]\n", rc);
-                        return __LINE__;
-                    }
-                    if (uncompSz) {
-                        itemSz      = uncompSz;
-                        picLoadAddr = uncompLoadaddr;
-                    }
-
-                    sprintf(env_name, "%s_offset", argv[2]);//be bootup_offset ,not bootup_720_offset
-                    sprintf(env_data, "0x%lx", picLoadAddr);
-                    setenv(env_name, env_data);
-
-                    sprintf(env_name, "%s_size", argv[2]);
-                    sprintf(env_data, "0x%x", itemSz);
-                    setenv(env_name, env_data);
-
-                    debugP("end read pic[%s]\n", picName);
-                    return 0;//success
-            }
+    //uncompress supported format
+    unsigned long uncompLoadaddr = picLoadAddr + itemSz + 7;
+    uncompLoadaddr &= ~(0x7U);
+    rc = imgread_uncomp_pic((unsigned char*)picLoadAddr, itemSz, (unsigned char*)uncompLoadaddr,
+            CONFIG_MAX_PIC_LEN, (unsigned long*)&uncompSz);
+    if (rc) {
+        errorP("Fail in uncomp pic,rc[%d]\n", rc);
+        return __LINE__;
+    }
+    if (uncompSz) {
+        itemSz      = uncompSz;
+        picLoadAddr = uncompLoadaddr;
     }
 
-    return __LINE__;//fail
+    sprintf(env_name, "%s_offset", argv[2]);//be bootup_offset ,not bootup_720_offset
+    sprintf(env_data, "0x%lx", picLoadAddr);
+    setenv(env_name, env_data);
+
+    sprintf(env_name, "%s_size", argv[2]);
+    sprintf(env_data, "0x%x", itemSz);
+    setenv(env_name, env_data);
+
+    debugP("end read pic[%s]\n", picName);
+    return 0;//success
 }
 
 static cmd_tbl_t cmd_imgread_sub[] = {
@@ -532,6 +935,9 @@ static cmd_tbl_t cmd_imgread_sub[] = {
     U_BOOT_CMD_MKENT(dtb,    4, 0, do_image_read_dtb, "", ""),
     U_BOOT_CMD_MKENT(res,    3, 0, do_image_read_res, "", ""),
     U_BOOT_CMD_MKENT(pic,    4, 0, do_image_read_pic, "", ""),
+#ifdef CONFIG_AML_LOGO_FB_CACHE
+    U_BOOT_CMD_MKENT(fbcache, 4, 0, do_image_save_fb, "", ""),
+#endif// #ifdef CONFIG_AML_LOGO_FB_CACHE
 };
 
 static int do_image_read(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
@@ -563,7 +969,10 @@ U_BOOT_CMD(
    "imgread kernel  --- Read image in fomart IMAGE_FORMAT_ANDROID\n"
    "imgread dtb     --- Read dtb in fomart IMAGE_FORMAT_ANDROID\n"
    "imgread res     --- Read image packed by 'Amlogic resource packer'\n"
-   "imgread picture --- Read one picture from Amlogic logo"
+   "imgread picture --- Read one picture from Amlogic logo\n"
+#ifdef CONFIG_AML_LOGO_FB_CACHE
+   "imgread fbcache --- Save the frame buffer drawn from one picture, for 'imgread pic' to show next time\n"
+#endif
    "    - e.g. \n"
    "        to read boot.img     from part boot     from flash: <imgread kernel boot loadaddr> \n"   //usage
    "        to read recovery.img from part recovery from flash: <imgread kernel recovery loadaddr $offset> \n"   //usage
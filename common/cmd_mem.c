@@ -22,7 +22,11 @@
 #include <inttypes.h>
 #include <watchdog.h>
 #include <asm/io.h>
+#include <div64.h>
 #include <linux/compiler.h>
+#ifdef CONFIG_CMD_MEMTEST
+#include <memtest.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -989,10 +993,57 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return 0;
 }
 
+/* mtest -a: the memtest_run() algorithms, then the word at a time ones */
+enum {
+	MTEST_QUICK = MEMTEST_ALG_COUNT,
+	MTEST_ALT,
+	MTEST_ALL,	/* every memtest_run() algorithm in turn */
+};
+
+static const char *const mtest_alg_names[] = {
+	[MEMTEST_ALG_INV]	= "inv",
+	[MEMTEST_ALG_XOR]	= "xor",
+	[MEMTEST_ALG_ADDR]	= "addr",
+	[MTEST_QUICK]		= "quick",
+	[MTEST_ALT]		= "alt",
+	[MTEST_ALL]		= "all",
+};
+
+static ulong mtest_mbps(u64 bytes, u64 us)
+{
+	ulong ms = max_t(u64, lldiv(us, 1000), 1);
+
+	return lldiv(bytes, ms) / 1000;
+}
+
+static void mtest_report(const struct memtest_stats *stats, ulong size)
+{
+	printf("Moved %lu MiB in %lu ms, %lu MB/s", (ulong)(stats->bytes >> 20),
+	       (ulong)lldiv(stats->us, 1000),
+	       mtest_mbps(stats->bytes, stats->us));
+	if (stats->write_us)
+		printf(", fill %lu MB/s",
+		       mtest_mbps(stats->write_bytes, stats->write_us));
+	if (stats->read_us)
+		printf(", verify %lu MB/s",
+		       mtest_mbps(stats->read_bytes, stats->read_us));
+	putc('\n');
+
+	if (gd->ram_size >> 10) {
+		ulong pct = lldiv((u64)(size >> 10) * 10000,
+				  gd->ram_size >> 10);
+
+		printf("Covered 0x%lx bytes, %lu.%02lu%% of ", size,
+		       pct / 100, pct % 100);
+		print_size(gd->ram_size, " DRAM\n");
+	}
+}
+
 /*
  * Perform a memory test. A more complete alternative test can be
- * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
- * interrupted by ctrl-c or by a failure of one of the sub-tests.
+ * configured using CONFIG_SYS_ALT_MEMTEST, or another algorithm picked
+ * with -a. The complete test loops until interrupted by ctrl-c or by a
+ * failure of one of the sub-tests.
  */
 static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 			char * const argv[])
@@ -1005,10 +1056,34 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 	ulong pattern;
 	int iteration;
 #if defined(CONFIG_SYS_ALT_MEMTEST)
-	const int alt_test = 1;
+	int alg = MTEST_ALT;
 #else
-	const int alt_test = 0;
+	int alg = MTEST_QUICK;
 #endif
+	int cache = -1, cache_was = -1;
+	struct memtest_stats stats;
+	int i;
+
+	while (argc > 2 && argv[1][0] == '-') {
+		if (!strcmp(argv[1], "-a")) {
+			for (alg = 0; alg < ARRAY_SIZE(mtest_alg_names); alg++)
+				if (!strcmp(argv[2], mtest_alg_names[alg]))
+					break;
+			if (alg == ARRAY_SIZE(mtest_alg_names))
+				return CMD_RET_USAGE;
+		} else if (!strcmp(argv[1], "-c")) {
+			if (!strcmp(argv[2], "on"))
+				cache = 1;
+			else if (!strcmp(argv[2], "off"))
+				cache = 0;
+			else
+				return CMD_RET_USAGE;
+		} else {
+			return CMD_RET_USAGE;
+		}
+		argc -= 2;
+		argv += 2;
+	}
 
 	if (argc > 1)
 		start = simple_strtoul(argv[1], NULL, 16);
@@ -1030,10 +1105,29 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 	else
 		iteration_limit = 0;
 
+	/* the burst algorithms work on whole cache lines */
+	if (alg < MTEST_QUICK || alg == MTEST_ALL) {
+		start = ALIGN(start, MEMTEST_LINE);
+		end &= ~(MEMTEST_LINE - 1);
+		if (end <= start) {
+			puts("Range too small\n");
+			return 1;
+		}
+	}
+
 	printf("Testing %08x ... %08x:\n", (uint)start, (uint)end);
 	debug("%s:%d: start %#08lx end %#08lx\n", __func__, __LINE__,
 	      start, end);
 
+	if (cache != -1) {
+		cache_was = dcache_status();
+		if (cache)
+			dcache_enable();
+		else
+			dcache_disable();
+	}
+	memset(&stats, 0, sizeof(stats));
+
 	buf = map_sysmem(start, end - start);
 	dummy = map_sysmem(CONFIG_SYS_MEMTEST_SCRATCH, sizeof(vu_long));
 	for (iteration = 0;
@@ -1046,11 +1140,24 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
-		if (alt_test) {
+		if (alg == MTEST_ALT) {
 			errs = mem_test_alt(buf, start, end, dummy);
-		} else {
+		} else if (alg == MTEST_QUICK) {
 			errs = mem_test_quick(buf, start, end, pattern,
 					      iteration);
+		} else {
+			for (i = 0; i < MEMTEST_ALG_COUNT; i++) {
+				if (alg != MTEST_ALL && alg != i)
+					continue;
+				if (memtest_run(i, (ulong *)buf, start,
+						end - start, pattern, iteration,
+						dcache_status(), &stats)) {
+					errs = -1UL;
+					break;
+				}
+			}
+			if (errs != -1UL)
+				errs = stats.errs;
 		}
 		if (errs == -1UL)
 			break;
@@ -1069,6 +1176,11 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 		unmap_sysmem(vdummy);
 	}
 
+	if (cache_was == 1)
+		dcache_enable();
+	else if (cache_was == 0)
+		dcache_disable();
+
 	if (errs == -1UL) {
 		/* Memory test was aborted - write a newline to finish off */
 		putc('\n');
@@ -1078,6 +1190,8 @@ static int do_mem_mtest(cmd_tbl_t *cmdtp, int flag, int argc,
 			iteration, errs);
 		ret = errs != 0;
 	}
+	if (stats.us)
+		mtest_report(&stats, end - start);
 
 	return ret;	/* not reached */
 }
@@ -1365,9 +1479,12 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_MEMTEST
 U_BOOT_CMD(
-	mtest,	5,	1,	do_mem_mtest,
+	mtest,	9,	1,	do_mem_mtest,
 	"simple RAM read/write test",
-	"[start [end [pattern [iterations]]]]"
+	"[-a alg] [-c on|off] [start [end [pattern [iterations]]]]\n"
+	"    -a: inv (moving inversions), xor (random), addr (address in\n"
+	"        address), all (these three), quick or alt (word at a time)\n"
+	"    -c: run with the data cache on or off"
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <command.h>
 #include <mmc.h>
+#include <div64.h>
 
 static int curr_device = -1;
 #ifndef CONFIG_GENERIC_MMC
@@ -339,6 +340,91 @@ static int do_mmc_write(cmd_tbl_t *cmdtp, int flag,
 
 	return (n == cnt) ? CMD_RET_SUCCESS : CMD_RET_FAILURE;
 }
+static int do_mmc_speed(cmd_tbl_t *cmdtp, int flag,
+			int argc, char * const argv[])
+{
+	struct mmc *mmc;
+	u32 blk, cnt, n;
+	ulong start, ms, rate;
+	u64 kib;
+	void *addr;
+	int write;
+
+	if (argc == 5 && !strcmp(argv[4], "write"))
+		write = 1;
+	else if (argc == 4)
+		write = 0;
+	else
+		return CMD_RET_USAGE;
+
+	addr = (void *)simple_strtoul(argv[1], NULL, 16);
+	blk = simple_strtoul(argv[2], NULL, 16);
+	cnt = simple_strtoul(argv[3], NULL, 16);
+
+	mmc = init_mmc_device(curr_device, false);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+
+	if (write && mmc_getwp(mmc) == 1) {
+		printf("Error: card is write protected!\n");
+		return CMD_RET_FAILURE;
+	}
+
+	start = get_timer(0);
+	if (write)
+		n = mmc->block_dev.block_write(curr_device, blk, cnt, addr);
+	else
+		n = mmc->block_dev.block_read(curr_device, blk, cnt, addr);
+	ms = max(get_timer(start), 1UL);
+	if (n != cnt) {
+		printf("MMC speed: %d of %d blocks done: ERROR\n", n, cnt);
+		return CMD_RET_FAILURE;
+	}
+
+	/* KiB/s, printed as MiB/s with two decimals */
+	kib = ((u64)cnt * mmc->read_bl_len * 1000) >> 10;
+	do_div(kib, ms);
+	rate = kib;
+	printf("MMC speed: %s %d blocks at %p in %lu ms, %lu.%02lu MiB/s\n",
+	       write ? "wrote" : "read", cnt, addr, ms, rate / 1024,
+	       (rate % 1024) * 100 / 1024);
+
+	return CMD_RET_SUCCESS;
+}
+#ifdef CONFIG_MMC_CMD_STATS
+static int do_mmc_cmdstat(cmd_tbl_t *cmdtp, int flag,
+			  int argc, char * const argv[])
+{
+	struct mmc *mmc;
+	ulong total = 0;
+	int i;
+
+	mmc = find_mmc_device(curr_device);
+	if (!mmc)
+		return CMD_RET_FAILURE;
+
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		memset(mmc->cmd_stats, 0, sizeof(mmc->cmd_stats));
+		return CMD_RET_SUCCESS;
+	}
+	if (argc != 1)
+		return CMD_RET_USAGE;
+
+	printf("SET_BLOCK_COUNT: %s, reliable write: %s\n",
+	       mmc->cmd23 ? "yes" : "no",
+	       !mmc->rel_wr_sectors ? "no" :
+	       mmc->rel_wr_en ? "enhanced" : "legacy");
+	for (i = 0; i < ARRAY_SIZE(mmc->cmd_stats); i++) {
+		if (!mmc->cmd_stats[i])
+			continue;
+		printf("CMD%-2d %10lu\n", i, mmc->cmd_stats[i]);
+		total += mmc->cmd_stats[i];
+	}
+	printf("total %10lu\n", total);
+
+	return CMD_RET_SUCCESS;
+}
+#endif
 static int do_mmc_erase(cmd_tbl_t *cmdtp, int flag,
 			int argc, char * const argv[])
 {
@@ -762,6 +848,10 @@ static cmd_tbl_t cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(read, 4, 1, do_mmc_read, "", ""),
 	U_BOOT_CMD_MKENT(write, 4, 0, do_mmc_write, "", ""),
 	U_BOOT_CMD_MKENT(erase, 3, 0, do_mmc_erase, "", ""),
+	U_BOOT_CMD_MKENT(speed, 5, 0, do_mmc_speed, "", ""),
+#ifdef CONFIG_MMC_CMD_STATS
+	U_BOOT_CMD_MKENT(cmdstat, 2, 0, do_mmc_cmdstat, "", ""),
+#endif
 	U_BOOT_CMD_MKENT(rescan, 1, 1, do_mmc_rescan, "", ""),
 	U_BOOT_CMD_MKENT(part, 1, 1, do_mmc_part, "", ""),
 	U_BOOT_CMD_MKENT(dev, 3, 0, do_mmc_dev, "", ""),
@@ -814,6 +904,10 @@ U_BOOT_CMD(
 	"mmc read addr blk# cnt\n"
 	"mmc write addr blk# cnt\n"
 	"mmc erase blk# cnt\n"
+	"mmc speed addr blk# cnt [write] - time a read (or write) of cnt blocks\n"
+#ifdef CONFIG_MMC_CMD_STATS
+	"mmc cmdstat [reset] - show (or clear) the commands sent, by index\n"
+#endif
 	"mmc rescan\n"
 	"mmc part - lists available partition on current mmc device\n"
 	"mmc dev [dev] [part] - show or set current mmc device [partition]\n"
@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <fs.h>
+#include <nand.h>
 #include <part.h>
 #include <sandboxblockdev.h>
 #include <asm/errno.h>
@@ -85,12 +86,26 @@ static int do_sandbox_info(cmd_tbl_t *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef CONFIG_NAND_SANDBOX
+static int do_sandbox_nand(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset")))
+		return CMD_RET_USAGE;
+	sandbox_nand_show_stats(argc == 2);
+	return 0;
+}
+#endif
+
 static cmd_tbl_t cmd_sandbox_sub[] = {
 	U_BOOT_CMD_MKENT(load, 7, 0, do_sandbox_load, "", ""),
 	U_BOOT_CMD_MKENT(ls, 3, 0, do_sandbox_ls, "", ""),
 	U_BOOT_CMD_MKENT(save, 6, 0, do_sandbox_save, "", ""),
 	U_BOOT_CMD_MKENT(bind, 3, 0, do_sandbox_bind, "", ""),
 	U_BOOT_CMD_MKENT(info, 3, 0, do_sandbox_info, "", ""),
+#ifdef CONFIG_NAND_SANDBOX
+	U_BOOT_CMD_MKENT(nand, 2, 0, do_sandbox_nand, "", ""),
+#endif
 };
 
 static int do_sandbox(cmd_tbl_t *cmdtp, int flag, int argc,
@@ -121,6 +136,9 @@ U_BOOT_CMD(
 		"save a file to host\n"
 	"sb bind <dev> [<filename>] - bind \"host\" device to file\n"
 	"sb info [<dev>]            - show device binding & info\n"
+#ifdef CONFIG_NAND_SANDBOX
+	"sb nand [reset]            - show (and clear) NAND operation counts\n"
+#endif
 	"sb commands use the \"hostfs\" device. The \"host\" device is used\n"
 	"with standard IO commands such as fatls or ext2load"
 );
@@ -38,6 +38,8 @@ static int curr_dev = -1;
 static int all_dev = 0;
 static char buffer[80];
 static int ubi_initialized;
+/* partition each attached device was attached from, by device number */
+static char attached_part[UBI_MAX_DEVICES][80];
 
 struct selected_dev {
 	char part_name[80];
@@ -453,7 +455,9 @@ static int ubi_dev_scan(struct mtd_info *info, char *ubidev,
 int ubi_part(char *part_name, const char *vid_header_offset)
 {
 	int err = 0;
-	// char mtd_dev[16];
+#ifndef CONFIFG_AML_MTDPART
+	char mtd_dev[16];
+#endif
 	struct mtd_device *dev;
 	struct part_info *part;
 	u8 pnum;
@@ -463,6 +467,29 @@ int ubi_part(char *part_name, const char *vid_header_offset)
 		return 1;
 	}
 
+	/*
+	 * Attaching scans every PEB of every partition given so far. If this
+	 * one is attached already, just select it again.
+	 */
+	if (ubi_initialized && !vid_header_offset) {
+		int i;
+
+		for (i = 0; i < all_dev; i++) {
+			if (!ubi_devices[i] || strcmp(attached_part[i], part_name))
+				continue;
+#ifdef CONFIG_CMD_UBIFS
+			if (i != curr_dev && ubifs_is_mounted())
+				cmd_ubifs_umount();
+#endif
+			curr_dev = i;
+			ubi = ubi_devices[i];
+			ubi_dev.selected = 1;
+			strcpy(ubi_dev.part_name, part_name);
+			ubi_msg("current ubi device %d\n", curr_dev);
+			return 0;
+		}
+	}
+
 #ifdef CONFIG_CMD_UBIFS
 	/*
 	 * Automatically unmount UBIFS partition when user
@@ -524,6 +551,7 @@ int ubi_part(char *part_name, const char *vid_header_offset)
 	all_dev++;
 	curr_dev = all_dev - 1;
 	ubi = ubi_devices[curr_dev];
+	strcpy(attached_part[curr_dev], part_name);
 	ubi_msg("current ubi device %d\n", curr_dev);
 	return 0;
 }
@@ -150,8 +150,11 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 	blk_start	= ALIGN(offset, mmc->write_bl_len) / mmc->write_bl_len;
 	blk_cnt		= ALIGN(size, mmc->write_bl_len) / mmc->write_bl_len;
 
+	/* The old environment survives a power cut, when the card can */
+	mmc_set_reliable_write(mmc, 1);
 	n = mmc->block_dev.block_write(CONFIG_SYS_MMC_ENV_DEV, blk_start,
 					blk_cnt, (u_char *)buffer);
+	mmc_set_reliable_write(mmc, 0);
 
 	return (n == blk_cnt) ? 0 : -1;
 }
@@ -7,6 +7,8 @@
 #include <config.h>
 #include <common.h>
 #include <fb_mmc.h>
+#include <fb_storage.h>
+#include <malloc.h>
 #include <part.h>
 #include <aboot.h>
 #include <sparse_format.h>
@@ -233,3 +235,181 @@ void fb_mmc_erase_write(const char *cmd, void *download_buffer, char *response)
 	       blks_size * info.blksz, cmd);
 	fastboot_okay("");
 }
+
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+/* Partition that streamed downloads are written to as they arrive */
+static struct {
+	block_dev_desc_t *dev_desc;
+	disk_partition_t info;
+	char part_name[32];
+	int sparse;		/* -1 until the first segment is seen */
+	lbaint_t blk;		/* next block of a raw image */
+	struct sparse_stream ss;
+	int busy;		/* req of a raw image is in flight */
+	struct blk_req req;
+} fb_stream;
+
+/*
+ * Segments are written with blk_write_submit() and left in flight, so
+ * that the eMMC programs one while USB receives the next. Wait for the
+ * write of the previous segment before its buffer is received into again.
+ */
+static int fb_stream_sync(void)
+{
+	if (fb_stream.sparse > 0)
+		return sparse_stream_sync(&fb_stream.ss);
+	if (!fb_stream.busy)
+		return 0;
+
+	fb_stream.busy = 0;
+	if (blk_write_wait(&fb_stream.req) != fb_stream.req.blkcnt) {
+		error("failed writing to device %d\n", fb_stream.dev_desc->dev);
+		fastboot_fail("failed writing to device");
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * Select the partition for streamed downloads. Returns its size in
+ * bytes, or 0 with the response set to FAIL.
+ */
+u64 fb_mmc_stream_open(const char *cmd, char *response)
+{
+	block_dev_desc_t *dev_desc;
+	int ret = -1;
+
+	/* initialize the response buffer */
+	response_str = response;
+
+	dev_desc = get_dev("mmc", CONFIG_FASTBOOT_FLASH_MMC_DEV);
+	if (!dev_desc || dev_desc->type == DEV_TYPE_UNKNOWN) {
+		error("invalid mmc device\n");
+		fastboot_fail("invalid mmc device");
+		return 0;
+	}
+
+	/* These images are checked or converted before they are written */
+	if (strcmp(cmd, "dtb") == 0) {
+		fastboot_fail("partition can't be streamed");
+		return 0;
+	}
+#ifdef CONFIG_EFI_PARTITION
+	if (strcmp(cmd, CONFIG_FASTBOOT_GPT_NAME) == 0) {
+		fastboot_fail("partition can't be streamed");
+		return 0;
+	}
+	ret = part_get_info_efi_by_name_or_alias(dev_desc, cmd, &fb_stream.info);
+#endif
+#ifdef CONFIG_AML_PARTITION
+	if (strcmp(cmd, CONFIG_FASTBOOT_MBR_NAME) == 0) {
+		fastboot_fail("partition can't be streamed");
+		return 0;
+	}
+	ret = get_partition_info_aml_by_name(dev_desc, cmd, &fb_stream.info);
+#endif
+	if (ret) {
+		error("cannot find partition: '%s'\n", cmd);
+		fastboot_fail("cannot find partition");
+		return 0;
+	}
+
+	fb_stream.dev_desc = dev_desc;
+	strncpy(fb_stream.part_name, cmd, sizeof(fb_stream.part_name) - 1);
+	fb_stream.part_name[sizeof(fb_stream.part_name) - 1] = '\0';
+	fastboot_okay("");
+
+	return (u64)fb_stream.info.size * fb_stream.info.blksz;
+}
+
+/* Start writing a new download to the partition from its beginning */
+void fb_mmc_stream_start(char *response)
+{
+	/* Finish off a download that was cut short, drop its buffers */
+	fb_stream_sync();
+	if (fb_stream.sparse > 0) {
+		free(fb_stream.ss.partial);
+		free(fb_stream.ss.fill_buf);
+	}
+
+	response_str = response;
+	fb_stream.sparse = -1;
+	fb_stream.blk = fb_stream.info.start;
+	fastboot_okay("");
+}
+
+/*
+ * Start writing the next @len bytes of the download. Every piece but the
+ * last must be a multiple of the block size. The write may still be in
+ * flight on return: @buf must stay unchanged until the next call, or
+ * fb_mmc_stream_finish().
+ */
+int fb_mmc_stream_write(void *buf, unsigned int len)
+{
+	disk_partition_t *info = &fb_stream.info;
+	lbaint_t blkcnt;
+
+	if (fb_stream_sync())
+		return -1;
+
+	if (fb_stream.sparse < 0) {
+		fb_stream.sparse = is_sparse_image(buf);
+		if (fb_stream.sparse) {
+			if (sparse_stream_init(&fb_stream.ss,
+					       fb_stream.dev_desc, info))
+				return -1;
+			fb_stream.ss.async = 1;
+		} else {
+			puts("Flashing Raw Image\n");
+		}
+	}
+
+	if (fb_stream.sparse)
+		return sparse_stream_write(&fb_stream.ss, buf, len);
+
+	blkcnt = DIV_ROUND_UP(len, info->blksz);
+	if (fb_stream.blk + blkcnt > info->start + info->size) {
+		error("too large for partition: '%s'\n", fb_stream.part_name);
+		fastboot_fail("too large for partition");
+		return -1;
+	}
+
+	if (blk_write_submit(fb_stream.dev_desc, fb_stream.blk, blkcnt, buf,
+			     &fb_stream.req)) {
+		error("failed writing to device %d\n", fb_stream.dev_desc->dev);
+		fastboot_fail("failed writing to device");
+		return -1;
+	}
+	fb_stream.busy = 1;
+	fb_stream.blk += blkcnt;
+
+	return 0;
+}
+
+/* Let the write in flight move on, called while data is received */
+void fb_mmc_stream_poll(void)
+{
+	if (fb_stream.sparse > 0)
+		sparse_stream_poll(&fb_stream.ss);
+	else if (fb_stream.busy)
+		blk_write_poll(&fb_stream.req);
+}
+
+/* The whole download was passed in, report the result */
+int fb_mmc_stream_finish(void)
+{
+	if (fb_stream.sparse > 0)
+		return sparse_stream_finish(&fb_stream.ss,
+					    fb_stream.part_name);
+	if (fb_stream_sync())
+		return -1;
+
+	if (strncmp(response_str, "FAIL", 4))
+		printf("........ wrote " LBAFU " bytes to '%s'\n",
+		       (fb_stream.blk - fb_stream.info.start) *
+		       fb_stream.info.blksz, fb_stream.part_name);
+
+	return strncmp(response_str, "FAIL", 4) ? 0 : -1;
+}
+#endif
@@ -9,6 +9,10 @@
 #include <android_image.h>
 #include <malloc.h>
 #include <errno.h>
+#include <lz4.h>
+#include <u-boot/crc.h>
+#include <asm/io.h>
+#include <asm/unaligned.h>
 static const unsigned char lzop_magic[] = {
 	0x89, 0x4c, 0x5a, 0x4f, 0x00, 0x0d, 0x0a, 0x1a, 0x0a
 };
@@ -19,6 +23,55 @@ static const unsigned char gzip_magic[] = {
 
 static char andr_tmp_str[ANDR_BOOT_ARGS_SIZE + 1];
 
+/* Image loaded by sections (see imgread), and the check that it is current */
+static struct andr_img_placed placed;
+static ulong placed_addr;
+static u32 placed_crc;
+
+#define PLACED_CRC_SZ	1024
+
+/* Forget the placed image and free the buffer holding its sections */
+static void clear_placed(void)
+{
+	free(placed.buf);
+	placed.buf = NULL;
+	placed.hdr = NULL;
+}
+
+void android_image_set_placed(ulong addr, const struct andr_img_placed *p)
+{
+	clear_placed();
+	if (!p)
+		return;
+	placed = *p;
+	placed_addr = addr;
+	placed_crc = crc32(0, map_sysmem(addr, PLACED_CRC_SZ), PLACED_CRC_SZ);
+}
+
+const struct andr_img_hdr *android_image_get_placed(ulong addr)
+{
+	if (!placed.hdr || addr != placed_addr)
+		return NULL;
+	/* anything loaded to @addr since wins */
+	if (crc32(0, map_sysmem(addr, PLACED_CRC_SZ), PLACED_CRC_SZ) !=
+	    placed_crc) {
+		clear_placed();
+		return NULL;
+	}
+
+	return placed.hdr;
+}
+
+static const struct andr_img_placed *get_placed(const struct andr_img_hdr *hdr)
+{
+	return placed.hdr && placed.hdr == hdr ? &placed : NULL;
+}
+
+int android_image_ramdisk_placed(ulong rd_data)
+{
+	return placed.hdr && placed.rd_data == rd_data;
+}
+
 /**
  * android_image_get_kernel() - processes kernel part of Android boot images
  * @hdr:	Pointer to image header, which is at the start
@@ -42,6 +95,7 @@ int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 	 * sha1 (or anything) so we don't check it. It is not obvious that the
 	 * string is null terminated so we take care of this.
 	 */
+	const struct andr_img_placed *p;
 	ulong end;
 	strncpy(andr_tmp_str, hdr->name, ANDR_BOOT_NAME_SIZE);
 	andr_tmp_str[ANDR_BOOT_NAME_SIZE] = '\0';
@@ -77,12 +131,15 @@ int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 
 	setenv("bootargs", newbootargs);
 
+	p = get_placed(hdr);
 	if (os_data) {
 		*os_data = (ulong)hdr;
 		*os_data += hdr->page_size;
+		if (p)
+			*os_data = p->kernel_data;
 	}
 	if (os_len)
-		*os_len = hdr->kernel_size;
+		*os_len = p ? p->kernel_len : hdr->kernel_size;
 
 #if defined(CONFIG_ANDROID_IMG)
 			images.ft_len = (ulong)(hdr->second_size);
@@ -92,6 +149,10 @@ int android_image_get_kernel(const struct andr_img_hdr *hdr, int verify,
 			images.rd_start = end;
 			end += ALIGN(hdr->ramdisk_size, hdr->page_size);
 			images.ft_addr = (char *)end;
+			if (p) {
+				images.rd_start = p->rd_data;
+				images.ft_addr = (char *)p->second_data;
+			}
 #endif
 
 	return 0;
@@ -104,6 +165,7 @@ int android_image_check_header(const struct andr_img_hdr *hdr)
 
 ulong android_image_get_end(const struct andr_img_hdr *hdr)
 {
+	const struct andr_img_placed *p;
 	ulong end;
 	/*
 	 * The header takes a full page, the remaining components are aligned
@@ -111,6 +173,13 @@ ulong android_image_get_end(const struct andr_img_hdr *hdr)
 	 */
 	end = (ulong)hdr;
 	end += hdr->page_size;
+	/* placed sections are not part of the blob bootm must keep */
+	p = get_placed(hdr);
+	if (p) {
+		if (p->kernel_comp != IH_COMP_NONE)
+			end += ALIGN(hdr->kernel_size, hdr->page_size);
+		return end;
+	}
 	end += ALIGN(hdr->kernel_size, hdr->page_size);
 	end += ALIGN(hdr->ramdisk_size, hdr->page_size);
 	end += ALIGN(hdr->second_size, hdr->page_size);
@@ -120,6 +189,10 @@ ulong android_image_get_end(const struct andr_img_hdr *hdr)
 
 ulong android_image_get_kload(const struct andr_img_hdr *hdr)
 {
+	/* images made for the legacy arm32 layout */
+	if (hdr->kernel_addr == 0x10008000)
+		return 0x1080000;
+
 	return hdr->kernel_addr;
 }
 
@@ -135,6 +208,8 @@ int android_image_get_ramdisk(const struct andr_img_hdr *hdr,
 	*rd_data = (unsigned long)hdr;
 	*rd_data += hdr->page_size;
 	*rd_data += ALIGN(hdr->kernel_size, hdr->page_size);
+	if (get_placed(hdr))
+		*rd_data = placed.rd_data;
 
 	*rd_len = hdr->ramdisk_size;
 	return 0;
@@ -142,8 +217,12 @@ int android_image_get_ramdisk(const struct andr_img_hdr *hdr,
 
 ulong android_image_get_comp(const struct andr_img_hdr *os_hdr)
 {
+	const struct andr_img_placed *p = get_placed(os_hdr);
 	int i;
 	unsigned char *src = (unsigned char *)os_hdr + os_hdr->page_size;
+
+	if (p)
+		return p->kernel_comp;
 	/* read magic: 9 first bytes */
 	for (i = 0; i < ARRAY_SIZE(lzop_magic); i++) {
 		if (*src++ != lzop_magic[i])
@@ -160,6 +239,11 @@ ulong android_image_get_comp(const struct andr_img_hdr *os_hdr)
 	if (i == ARRAY_SIZE(gzip_magic))
 		return IH_COMP_GZIP;
 
+	src = (unsigned char *)os_hdr + os_hdr->page_size;
+	if (get_unaligned_le32(src) == LZ4_MAGIC ||
+	    get_unaligned_le32(src) == LZ4_LEGACY_MAGIC)
+		return IH_COMP_LZ4;
+
 	return IH_COMP_NONE;
 }
 int android_image_need_move(ulong *img_addr, const struct andr_img_hdr *hdr)
@@ -167,6 +251,10 @@ int android_image_need_move(ulong *img_addr, const struct andr_img_hdr *hdr)
 	ulong kernel_load_addr = android_image_get_kload(hdr);
 	ulong img_start = *img_addr;
 	ulong val = 0;
+
+	/* sections were loaded where they can stay */
+	if (get_placed(hdr))
+		return 0;
 	if (kernel_load_addr > img_start)
 		val = kernel_load_addr - img_start;
 	else
@@ -154,6 +154,7 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_GZIP,	"gzip",		"gzip compressed",	},
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
+	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -1089,6 +1090,13 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 		initrd_high = ~0;
 	}
 
+#ifdef CONFIG_ANDROID_BOOT_IMAGE
+	/* imgread put it where it can stay */
+	if (android_image_ramdisk_placed(rd_data) &&
+	    rd_data + rd_len <= initrd_high)
+		initrd_copy_to_ram = 0;
+#endif
+
 
 #ifdef CONFIG_LOGBUFFER
 	/* Prevent initrd from overwriting logbuffer */
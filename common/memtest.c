@@ -0,0 +1,302 @@
+/*
+ * Memory test engine for mtest
+ *
+ * Memory is written and verified a cache line (MEMTEST_LINE_WORDS words)
+ * at a time with plain accesses, which the compiler turns into paired
+ * stores and loads, instead of one volatile word at a time. A line is
+ * compared as a whole and only looked at word by word when it is wrong,
+ * so that the test runs at close to memory bandwidth.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <memtest.h>
+#include <watchdog.h>
+#include <linux/compiler.h>
+
+#define MEMTEST_CHUNK_WORDS	((1UL << 20) / sizeof(ulong))
+#define MEMTEST_MAX_REPORT	16
+
+struct memtest_ctx {
+	ulong *buf;
+	ulong *end;
+	ulong start_addr;
+	int flush;
+	struct memtest_stats *stats;
+};
+
+static inline void line_write(ulong *p, const ulong *v)
+{
+	p[0] = v[0];
+	p[1] = v[1];
+	p[2] = v[2];
+	p[3] = v[3];
+	p[4] = v[4];
+	p[5] = v[5];
+	p[6] = v[6];
+	p[7] = v[7];
+}
+
+static inline ulong line_diff(const ulong *p, const ulong *e)
+{
+	return (p[0] ^ e[0]) | (p[1] ^ e[1]) | (p[2] ^ e[2]) | (p[3] ^ e[3]) |
+	       (p[4] ^ e[4]) | (p[5] ^ e[5]) | (p[6] ^ e[6]) | (p[7] ^ e[7]);
+}
+
+static inline void line_fill(ulong *v, ulong val)
+{
+	int i;
+
+	for (i = 0; i < MEMTEST_LINE_WORDS; i++)
+		v[i] = val;
+}
+
+/* A line differed from what was expected: count and report its bad words */
+static void line_errors(struct memtest_ctx *ctx, const ulong *p,
+			const ulong *e)
+{
+	ulong val;
+	int i;
+
+	for (i = 0; i < MEMTEST_LINE_WORDS; i++) {
+		val = p[i];
+		if (val == e[i])
+			continue;
+		if (ctx->stats->errs++ < MEMTEST_MAX_REPORT)
+			printf("\nMem error @ 0x%08lx: found %0*lx, expected %0*lx\n",
+			       ctx->start_addr +
+			       (ulong)(p + i - ctx->buf) * sizeof(ulong),
+			       (int)sizeof(ulong) * 2, val,
+			       (int)sizeof(ulong) * 2, e[i]);
+	}
+}
+
+/* Between chunks: keep the watchdog quiet, see whether to stop */
+static int chunk_done(void)
+{
+	WATCHDOG_RESET();
+	return ctrlc() ? -1 : 0;
+}
+
+static void pass_start(ulong *start)
+{
+	*start = timer_get_us();
+}
+
+/* Account for a pass, after making sure the next one reads from memory */
+static void pass_end(struct memtest_ctx *ctx, ulong start, int write,
+		     int read)
+{
+	struct memtest_stats *stats = ctx->stats;
+	ulong bytes = (ctx->end - ctx->buf) * sizeof(ulong);
+	ulong us;
+
+	/* the compiler must not carry what it stored over to the next pass */
+	barrier();
+	us = timer_get_us() - start;
+	if (write && !read) {
+		stats->write_bytes += bytes;
+		stats->write_us += us;
+	} else if (read && !write) {
+		stats->read_bytes += bytes;
+		stats->read_us += us;
+	}
+	if (ctx->flush)
+		flush_dcache_range((ulong)ctx->buf, (ulong)ctx->end);
+	stats->bytes += (write + read) * (u64)bytes;
+	stats->us += timer_get_us() - start;
+}
+
+static inline ulong xorshift(ulong x)
+{
+	if (sizeof(ulong) == 8) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+	} else {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+	}
+
+	return x;
+}
+
+/*
+ * Moving inversions: fill with the pattern, then going up check each line
+ * and write its complement, then going down check the complement and
+ * write the pattern back. Catches coupling between neighbouring cells in
+ * both directions.
+ */
+static int test_inv(struct memtest_ctx *ctx, ulong pattern)
+{
+	ulong e[MEMTEST_LINE_WORDS], ne[MEMTEST_LINE_WORDS];
+	ulong *p, *stop, start;
+
+	line_fill(e, pattern);
+	line_fill(ne, ~pattern);
+
+	pass_start(&start);
+	for (p = ctx->buf; p < ctx->end; ) {
+		stop = min(p + MEMTEST_CHUNK_WORDS, ctx->end);
+		for (; p < stop; p += MEMTEST_LINE_WORDS)
+			line_write(p, e);
+		if (chunk_done())
+			return -1;
+	}
+	pass_end(ctx, start, 1, 0);
+
+	pass_start(&start);
+	for (p = ctx->buf; p < ctx->end; ) {
+		stop = min(p + MEMTEST_CHUNK_WORDS, ctx->end);
+		for (; p < stop; p += MEMTEST_LINE_WORDS) {
+			if (line_diff(p, e))
+				line_errors(ctx, p, e);
+			line_write(p, ne);
+		}
+		if (chunk_done())
+			return -1;
+	}
+	pass_end(ctx, start, 1, 1);
+
+	pass_start(&start);
+	for (p = ctx->end; p > ctx->buf; ) {
+		stop = p - min((ulong)(p - ctx->buf), MEMTEST_CHUNK_WORDS);
+		while (p > stop) {
+			p -= MEMTEST_LINE_WORDS;
+			if (line_diff(p, ne))
+				line_errors(ctx, p, ne);
+			line_write(p, e);
+		}
+		if (chunk_done())
+			return -1;
+	}
+	pass_end(ctx, start, 1, 1);
+
+	return 0;
+}
+
+/*
+ * Pseudo-random data: no two neighbouring words or lines alike, so that
+ * data-dependent faults and shorts between data lines show up.
+ */
+static int test_xor(struct memtest_ctx *ctx, ulong seed)
+{
+	ulong e[MEMTEST_LINE_WORDS];
+	ulong *p, *stop, start, x;
+	int i;
+
+	pass_start(&start);
+	for (p = ctx->buf, x = seed; p < ctx->end; ) {
+		stop = min(p + MEMTEST_CHUNK_WORDS, ctx->end);
+		for (; p < stop; p += MEMTEST_LINE_WORDS) {
+			for (i = 0; i < MEMTEST_LINE_WORDS; i++) {
+				x = xorshift(x);
+				e[i] = x;
+			}
+			line_write(p, e);
+		}
+		if (chunk_done())
+			return -1;
+	}
+	pass_end(ctx, start, 1, 0);
+
+	pass_start(&start);
+	for (p = ctx->buf, x = seed; p < ctx->end; ) {
+		stop = min(p + MEMTEST_CHUNK_WORDS, ctx->end);
+		for (; p < stop; p += MEMTEST_LINE_WORDS) {
+			for (i = 0; i < MEMTEST_LINE_WORDS; i++) {
+				x = xorshift(x);
+				e[i] = x;
+			}
+			if (line_diff(p, e))
+				line_errors(ctx, p, e);
+		}
+		if (chunk_done())
+			return -1;
+	}
+	pass_end(ctx, start, 0, 1);
+
+	return 0;
+}
+
+/*
+ * Address in address: every word holds its own address, then its
+ * complement. A word written through a faulty address line lands on and
+ * shows up as another word's address.
+ */
+static int test_addr(struct memtest_ctx *ctx)
+{
+	ulong e[MEMTEST_LINE_WORDS];
+	ulong *p, *stop, start, addr, inv;
+	int i;
+
+	for (inv = 0; inv <= 1; inv++) {
+		pass_start(&start);
+		addr = ctx->start_addr;
+		for (p = ctx->buf; p < ctx->end; ) {
+			stop = min(p + MEMTEST_CHUNK_WORDS, ctx->end);
+			for (; p < stop; p += MEMTEST_LINE_WORDS) {
+				for (i = 0; i < MEMTEST_LINE_WORDS; i++) {
+					e[i] = inv ? ~addr : addr;
+					addr += sizeof(ulong);
+				}
+				line_write(p, e);
+			}
+			if (chunk_done())
+				return -1;
+		}
+		pass_end(ctx, start, 1, 0);
+
+		pass_start(&start);
+		addr = ctx->start_addr;
+		for (p = ctx->buf; p < ctx->end; ) {
+			stop = min(p + MEMTEST_CHUNK_WORDS, ctx->end);
+			for (; p < stop; p += MEMTEST_LINE_WORDS) {
+				for (i = 0; i < MEMTEST_LINE_WORDS; i++) {
+					e[i] = inv ? ~addr : addr;
+					addr += sizeof(ulong);
+				}
+				if (line_diff(p, e))
+					line_errors(ctx, p, e);
+			}
+			if (chunk_done())
+				return -1;
+		}
+		pass_end(ctx, start, 0, 1);
+	}
+
+	return 0;
+}
+
+int memtest_run(enum memtest_alg alg, ulong *buf, ulong start_addr,
+		ulong size, ulong pattern, int iteration, int flush,
+		struct memtest_stats *stats)
+{
+	struct memtest_ctx ctx;
+
+	ctx.buf = buf;
+	ctx.end = buf + size / MEMTEST_LINE * MEMTEST_LINE_WORDS;
+	ctx.start_addr = start_addr;
+	ctx.flush = flush;
+	ctx.stats = stats;
+
+	if (flush)
+		flush_dcache_range((ulong)ctx.buf, (ulong)ctx.end);
+
+	switch (alg) {
+	case MEMTEST_ALG_INV:
+		if (!pattern)
+			pattern = 1UL << (iteration % BITS_PER_LONG);
+		return test_inv(&ctx, pattern);
+	case MEMTEST_ALG_XOR:
+		if (!pattern)
+			pattern = (ulong)0x9e3779b97f4a7c15ULL * (iteration + 1);
+		return test_xor(&ctx, pattern);
+	case MEMTEST_ALG_ADDR:
+		return test_addr(&ctx);
+	default:
+		return -1;
+	}
+}
@@ -227,6 +227,7 @@ int usb_stor_scan(int mode)
 	usb_disable_asynch(1); /* asynch transfer not allowed */
 
 	for (i = 0; i < USB_MAX_STOR_DEV; i++) {
+		blkcache_invalidate(IF_TYPE_USB, i);
 		memset(&usb_dev_desc[i], 0, sizeof(block_dev_desc_t));
 		usb_dev_desc[i].if_type = IF_TYPE_USB;
 		usb_dev_desc[i].dev = i;
@@ -1134,6 +1135,7 @@ unsigned long usb_stor_write(int device, lbaint_t blknr,
 		return 0;
 
 	device &= 0xff;
+	blkcache_invalidate(IF_TYPE_USB, device);
 	/* Setup  device */
 	debug("\nusb_write: dev %d \n", device);
 	dev = NULL;
@@ -10,6 +10,7 @@
 #include <ide.h>
 #include <malloc.h>
 #include <part.h>
+#include <linux/list.h>
 
 #undef	PART_DEBUG
 
@@ -719,3 +720,277 @@ cleanup:
 	free(dup_str);
 	return ret;
 }
+
+#ifdef CONFIG_BLOCK_CACHE
+/*
+ * Block cache shared by all block devices.
+ *
+ * Small reads (partition headers, superblocks, group descriptors, inode
+ * tables and directory blocks) are kept in a bounded list of entries in
+ * LRU order. A small read that continues the previous one on the same
+ * device fetches a whole entry so the following reads hit. Reads larger
+ * than an entry go straight to the device.
+ */
+#ifndef CONFIG_BLOCK_CACHE_BLOCKS
+#define CONFIG_BLOCK_CACHE_BLOCKS	8
+#endif
+#ifndef CONFIG_BLOCK_CACHE_ENTRIES
+#define CONFIG_BLOCK_CACHE_ENTRIES	32
+#endif
+
+struct block_cache_node {
+	struct list_head lh;
+	int if_type;
+	int dev;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	unsigned long blksz;
+	char *data;
+};
+
+static LIST_HEAD(block_cache);
+
+static struct block_cache_stats _stats = {
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_BLOCKS,
+	.max_entries = CONFIG_BLOCK_CACHE_ENTRIES,
+};
+
+/* End of the last read, used to detect sequential access */
+static int last_if_type = -1;
+static int last_dev = -1;
+static lbaint_t last_end;
+
+static void cache_node_free(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	free(node->data);
+	free(node);
+	_stats.entries--;
+}
+
+static struct block_cache_node *cache_find(block_dev_desc_t *block_dev,
+					   lbaint_t start, lbaint_t blkcnt)
+{
+	struct block_cache_node *node;
+
+	list_for_each_entry(node, &block_cache, lh) {
+		if (node->if_type == block_dev->if_type &&
+		    node->dev == block_dev->dev &&
+		    node->blksz == block_dev->blksz &&
+		    node->start <= start &&
+		    node->start + node->blkcnt >= start + blkcnt) {
+			/* move to the front of the LRU list */
+			if (block_cache.next != &node->lh) {
+				list_del(&node->lh);
+				list_add(&node->lh, &block_cache);
+			}
+			return node;
+		}
+	}
+
+	return NULL;
+}
+
+unsigned long blk_dread(block_dev_desc_t *block_dev, lbaint_t start,
+			lbaint_t blkcnt, void *buffer)
+{
+	struct block_cache_node *node;
+	unsigned long blksz = block_dev->blksz;
+	lbaint_t fetch = blkcnt;
+	int sequential;
+
+	if (!blkcnt || blkcnt > _stats.max_blocks_per_entry ||
+	    !_stats.max_entries)
+		return block_dev->block_read(block_dev->dev, start, blkcnt,
+					     buffer);
+
+	sequential = block_dev->if_type == last_if_type &&
+		     block_dev->dev == last_dev && start == last_end;
+	last_if_type = block_dev->if_type;
+	last_dev = block_dev->dev;
+	last_end = start + blkcnt;
+
+	node = cache_find(block_dev, start, blkcnt);
+	if (node) {
+		memcpy(buffer, node->data + (start - node->start) * blksz,
+		       blkcnt * blksz);
+		_stats.hits++;
+		return blkcnt;
+	}
+	_stats.misses++;
+
+	if (sequential) {
+		fetch = _stats.max_blocks_per_entry;
+		if (block_dev->lba > start && start + fetch > block_dev->lba)
+			fetch = max(blkcnt, block_dev->lba - start);
+	}
+
+	/* recycle the least recently used entry once the cache is full */
+	if (_stats.entries >= _stats.max_entries)
+		cache_node_free(list_entry(block_cache.prev,
+					   struct block_cache_node, lh));
+
+	node = malloc(sizeof(*node));
+	if (!node)
+		goto uncached;
+	node->data = memalign(ARCH_DMA_MINALIGN, fetch * blksz);
+	if (!node->data) {
+		free(node);
+		goto uncached;
+	}
+
+	if (block_dev->block_read(block_dev->dev, start, fetch,
+				  node->data) != fetch) {
+		free(node->data);
+		free(node);
+		goto uncached;
+	}
+
+	node->if_type = block_dev->if_type;
+	node->dev = block_dev->dev;
+	node->start = start;
+	node->blkcnt = fetch;
+	node->blksz = blksz;
+	list_add(&node->lh, &block_cache);
+	_stats.entries++;
+	_stats.readahead += fetch - blkcnt;
+
+	memcpy(buffer, node->data, blkcnt * blksz);
+	return blkcnt;
+
+uncached:
+	return block_dev->block_read(block_dev->dev, start, blkcnt, buffer);
+}
+
+unsigned long blk_dwrite(block_dev_desc_t *block_dev, lbaint_t start,
+			 lbaint_t blkcnt, const void *buffer)
+{
+	blkcache_invalidate(block_dev->if_type, block_dev->dev);
+
+	return block_dev->block_write(block_dev->dev, start, blkcnt, buffer);
+}
+
+void blkcache_invalidate(int if_type, int dev)
+{
+	struct block_cache_node *node, *tmp;
+
+	list_for_each_entry_safe(node, tmp, &block_cache, lh) {
+		if (node->if_type == if_type && node->dev == dev)
+			cache_node_free(node);
+	}
+	if (last_if_type == if_type && last_dev == dev)
+		last_if_type = -1;
+}
+
+void blkcache_configure(unsigned blocks, unsigned entries)
+{
+	struct block_cache_node *node, *tmp;
+
+	list_for_each_entry_safe(node, tmp, &block_cache, lh)
+		cache_node_free(node);
+	last_if_type = -1;
+
+	_stats.max_blocks_per_entry = blocks;
+	_stats.max_entries = entries;
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.readahead = 0;
+}
+
+void blkcache_stats(struct block_cache_stats *stats)
+{
+	memcpy(stats, &_stats, sizeof(*stats));
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.readahead = 0;
+}
+#endif /* CONFIG_BLOCK_CACHE */
+
+#ifdef CONFIG_BLOCK_ASYNC
+int blk_read_submit(block_dev_desc_t *block_dev, lbaint_t start,
+		    lbaint_t blkcnt, void *buffer, struct blk_req *req)
+{
+	int ret;
+
+	req->block_dev = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buffer;
+	req->done = 0;
+	req->state = BLK_REQ_BUSY;
+
+	if (blkcnt && block_dev->block_read_submit) {
+		ret = block_dev->block_read_submit(req);
+		if (ret)
+			req->state = BLK_REQ_DONE;
+		return ret;
+	}
+
+	/* Devices without asynchronous reads finish the read right here */
+	req->done = blk_dread(block_dev, start, blkcnt, buffer);
+	req->state = BLK_REQ_DONE;
+
+	return 0;
+}
+
+int blk_read_poll(struct blk_req *req)
+{
+	if (req->state == BLK_REQ_BUSY &&
+	    req->block_dev->block_read_poll(req))
+		req->state = BLK_REQ_DONE;
+
+	return req->state == BLK_REQ_DONE;
+}
+
+unsigned long blk_read_wait(struct blk_req *req)
+{
+	while (!blk_read_poll(req))
+		;
+
+	return req->done;
+}
+
+int blk_write_submit(block_dev_desc_t *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, const void *buffer, struct blk_req *req)
+{
+	int ret;
+
+	req->block_dev = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = (void *)buffer;
+	req->done = 0;
+	req->state = BLK_REQ_BUSY;
+
+	if (blkcnt && block_dev->block_write_submit) {
+		blkcache_invalidate(block_dev->if_type, block_dev->dev);
+		ret = block_dev->block_write_submit(req);
+		if (ret)
+			req->state = BLK_REQ_DONE;
+		return ret;
+	}
+
+	/* Devices without asynchronous writes finish the write right here */
+	req->done = blk_dwrite(block_dev, start, blkcnt, buffer);
+	req->state = BLK_REQ_DONE;
+
+	return 0;
+}
+
+int blk_write_poll(struct blk_req *req)
+{
+	if (req->state == BLK_REQ_BUSY &&
+	    req->block_dev->block_write_poll(req))
+		req->state = BLK_REQ_DONE;
+
+	return req->state == BLK_REQ_DONE;
+}
+
+unsigned long blk_write_wait(struct blk_req *req)
+{
+	while (!blk_write_poll(req))
+		;
+
+	return req->done;
+}
+#endif /* CONFIG_BLOCK_ASYNC */
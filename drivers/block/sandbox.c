@@ -22,13 +22,10 @@ static struct host_block_dev *find_host_device(int dev)
 	return NULL;
 }
 
-static unsigned long host_block_read(int dev, unsigned long start,
-				     lbaint_t blkcnt, void *buffer)
+static unsigned long host_read(struct host_block_dev *host_dev,
+			       unsigned long start, lbaint_t blkcnt,
+			       void *buffer)
 {
-	struct host_block_dev *host_dev = find_host_device(dev);
-
-	if (!host_dev)
-		return -1;
 	if (os_lseek(host_dev->fd,
 		     start * host_dev->blk_dev.blksz,
 		     OS_SEEK_SET) == -1) {
@@ -42,10 +39,23 @@ static unsigned long host_block_read(int dev, unsigned long start,
 	return -1;
 }
 
-static unsigned long host_block_write(int dev, unsigned long start,
-				      lbaint_t blkcnt, const void *buffer)
+static unsigned long host_block_read(int dev, unsigned long start,
+				     lbaint_t blkcnt, void *buffer)
 {
 	struct host_block_dev *host_dev = find_host_device(dev);
+
+	if (!host_dev)
+		return -1;
+	if (host_dev->delay_us)
+		udelay(host_dev->delay_us);
+
+	return host_read(host_dev, start, blkcnt, buffer);
+}
+
+static unsigned long host_write(struct host_block_dev *host_dev,
+				unsigned long start, lbaint_t blkcnt,
+				const void *buffer)
+{
 	if (os_lseek(host_dev->fd,
 		     start * host_dev->blk_dev.blksz,
 		     OS_SEEK_SET) == -1) {
@@ -59,12 +69,62 @@ static unsigned long host_block_write(int dev, unsigned long start,
 	return -1;
 }
 
+static unsigned long host_block_write(int dev, unsigned long start,
+				      lbaint_t blkcnt, const void *buffer)
+{
+	struct host_block_dev *host_dev = find_host_device(dev);
+
+	blkcache_invalidate(IF_TYPE_HOST, dev);
+	if (host_dev->delay_us)
+		udelay(host_dev->delay_us);
+
+	return host_write(host_dev, start, blkcnt, buffer);
+}
+
+#ifdef CONFIG_BLOCK_ASYNC
+static int host_block_submit(struct blk_req *req)
+{
+	struct host_block_dev *host_dev = find_host_device(req->block_dev->dev);
+
+	if (!host_dev)
+		return -ENODEV;
+	host_dev->ready_us = timer_get_us() + host_dev->delay_us;
+
+	return 0;
+}
+
+/* The data only arrives when the read finishes */
+static int host_block_read_poll(struct blk_req *req)
+{
+	struct host_block_dev *host_dev = find_host_device(req->block_dev->dev);
+
+	if ((long)(timer_get_us() - host_dev->ready_us) < 0)
+		return 0;
+	req->done = host_read(host_dev, req->start, req->blkcnt, req->buffer);
+
+	return 1;
+}
+
+/* Likewise the data is only taken from the buffer at the end */
+static int host_block_write_poll(struct blk_req *req)
+{
+	struct host_block_dev *host_dev = find_host_device(req->block_dev->dev);
+
+	if ((long)(timer_get_us() - host_dev->ready_us) < 0)
+		return 0;
+	req->done = host_write(host_dev, req->start, req->blkcnt, req->buffer);
+
+	return 1;
+}
+#endif
+
 int host_dev_bind(int dev, char *filename)
 {
 	struct host_block_dev *host_dev = find_host_device(dev);
 
 	if (!host_dev)
 		return -1;
+	blkcache_invalidate(IF_TYPE_HOST, dev);
 	if (host_dev->blk_dev.priv) {
 		os_close(host_dev->fd);
 		host_dev->blk_dev.priv = NULL;
@@ -92,6 +152,12 @@ int host_dev_bind(int dev, char *filename)
 	blk_dev->lba = os_lseek(host_dev->fd, 0, OS_SEEK_END) / blk_dev->blksz;
 	blk_dev->block_read = host_block_read;
 	blk_dev->block_write = host_block_write;
+#ifdef CONFIG_BLOCK_ASYNC
+	blk_dev->block_read_submit = host_block_submit;
+	blk_dev->block_read_poll = host_block_read_poll;
+	blk_dev->block_write_submit = host_block_submit;
+	blk_dev->block_write_poll = host_block_write_poll;
+#endif
 	blk_dev->dev = dev;
 	blk_dev->part_type = PART_TYPE_UNKNOWN;
 	init_part(blk_dev);
@@ -99,6 +165,17 @@ int host_dev_bind(int dev, char *filename)
 	return 0;
 }
 
+int host_dev_set_delay(int dev, ulong delay_us)
+{
+	struct host_block_dev *host_dev = find_host_device(dev);
+
+	if (!host_dev)
+		return -1;
+	host_dev->delay_us = delay_us;
+
+	return 0;
+}
+
 int host_get_dev_err(int dev, block_dev_desc_t **blk_devp)
 {
 	struct host_block_dev *host_dev = find_host_device(dev);
@@ -17,6 +17,7 @@
 
 /* System Headers */
 #include <common.h>
+#include <video.h>
 #include <video_fb.h>
 #include <stdio_dev.h>
 #include <malloc.h>
@@ -653,9 +654,61 @@ int video_display_bitmap(ulong bmp_image, int x, int y)
 		    pheight * pwidth * info->vl_bpix / 8);
 
 #endif
+	bootstage_mark_name(BOOTSTAGE_LOGO_SHOWN, "logo_shown");
 	return (0);
 }
 
+static int video_osd_index(void)
+{
+	char *layer_str = getenv("display_layer");
+
+	if (layer_str && strcmp(layer_str, "osd0") == 0)
+		return 0;
+	else if (layer_str && strcmp(layer_str, "osd1") == 0)
+		return 1;
+	return -1;
+}
+
+ulong video_get_fb(ulong *base, unsigned *width, unsigned *height,
+		   unsigned *format)
+{
+	vidinfo_t *info = NULL;
+#if defined CONFIG_AML_VOUT
+	info = vout_get_current_vinfo();
+#endif
+
+	if (!info || !info->vd_base)
+		return 0;
+
+	*base = (ulong)info->vd_base;
+#ifdef CONFIG_OSD_SCALE_ENABLE
+	*width = fb_gdev.fb_width;
+	*height = fb_gdev.fb_height;
+#else
+	*width = info->vl_col;
+	*height = info->vl_row;
+#endif
+	*format = (fb_gdev.gdfIndex << 8) | NBITS(info->vl_bpix);
+
+	return *width * *height * NBITS(info->vl_bpix) / 8;
+}
+
+int video_display_fb(void)
+{
+	ulong base, size;
+	unsigned width, height, format;
+
+	size = video_get_fb(&base, &width, &height, &format);
+	if (!size)
+		return 1;
+
+	flush_cache(base, size);
+	osd_enable_hw(video_osd_index(), 1);
+	bootstage_mark_name(BOOTSTAGE_LOGO_SHOWN, "logo_shown");
+
+	return 0;
+}
+
 #ifdef CONFIG_OSD_SCALE_ENABLE
 int video_scale_bitmap(void)
 {
@@ -20,6 +20,7 @@
 */
 
 #include <common.h>
+#include <errno.h>
 #include <malloc.h>
 //#include <asm/dma-mapping.h>
 #include <asm/io.h>
@@ -278,23 +279,96 @@ static int sd_inand_staff_init(struct mmc *mmc)
  */
 
 /*
- * Sends a command out on the bus. Takes the mmc pointer,
+ * Blocks per descriptor: cmd_cfg.length is 9 bits wide, so longer
+ * transfers are split over a chain of descriptors.
+ */
+#define AML_SD_DESC_BLOCKS	256
+/* Largest transfer per command, also the size of the bounce buffer */
+#define AML_SD_MAX_BLOCKS	2048
+
+/* Data of the command in flight on each port, kept until it finishes */
+static struct aml_sd_xfer {
+        /*
+         * Only used for buffers the controller can't work on directly.
+         * It is allocated on first use and kept, rather than on every
+         * command.
+         */
+        void *bounce_buf;
+        int bounced;
+        u32 buffer;             /* DMA address, 0 for the ping buffer */
+        u32 data_size;
+} aml_sd_xfer[SDIO_PORT_C + 1];
+
+static int aml_sd_dma_aligned(const void *buf, unsigned size)
+{
+        return !(((unsigned long)buf | size) & (ARCH_DMA_MINALIGN - 1));
+}
+
+static void *aml_sd_get_bounce(struct aml_sd_xfer *xfer)
+{
+        if (!xfer->bounce_buf)
+                xfer->bounce_buf = memalign(ARCH_DMA_MINALIGN,
+                                AML_SD_MAX_BLOCKS * 512);
+        if (!xfer->bounce_buf)
+                printf("emmc/sd: no memory for bounce buffer\n");
+
+        return xfer->bounce_buf;
+}
+
+/*
+ * Split a transfer of more than AML_SD_DESC_BLOCKS blocks into a chain
+ * of descriptors. The first one issues the command, the others only move
+ * data, continuing from where the previous one stopped.
+ */
+static int aml_sd_build_chain(struct sd_emmc_desc_info *desc,
+                              struct mmc_data *data, unsigned long buffer)
+{
+        struct cmd_cfg *cfg;
+        u32 left = data->blocks;
+        int n = 0;
+
+        while (left) {
+                u32 blocks = min(left, (u32)AML_SD_DESC_BLOCKS);
+
+                if (n) {
+                        desc[n] = desc[0];
+                        cfg = (struct cmd_cfg *)&desc[n].cmd_info;
+                        cfg->no_cmd = 1;
+                        cfg->no_resp = 1;
+                        desc[n].resp_addr = 0;
+                }
+                cfg = (struct cmd_cfg *)&desc[n].cmd_info;
+                cfg->length = blocks;
+                cfg->end_of_chain = 0;
+                desc[n].data_addr = buffer;
+
+                buffer += blocks * data->blocksize;
+                left -= blocks;
+                n++;
+        }
+        cfg->end_of_chain = 1;
+
+        return n;
+}
+
+/*
+ * Starts a command on the bus. Takes the mmc pointer,
  * a command pointer, and an optional data pointer.
  */
-int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
+static int aml_sd_start_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
-        int ret = SD_NO_ERROR;
         //u32 vconf;
         u32 buffer = 0;
         u32 resp_buffer;
         u32 vstart = 0;
-        u32 status_irq = 0;
         //u32 inalign = 0;
-        u32 *write_buffer = NULL;
-        struct sd_emmc_status *status_irq_reg = (void *)&status_irq;
+        u32 data_size = 0;
+        int desc_num = 1;
+        void *bounce = NULL;
         struct sd_emmc_start *desc_start = (struct sd_emmc_start*)&vstart;
         //struct sd_emmc_config* sd_emmc_cfg = (struct sd_emmc_config*)&vconf;
         struct aml_card_sd_info *aml_priv = mmc->priv;
+        struct aml_sd_xfer *xfer = &aml_sd_xfer[aml_priv->sd_emmc_port];
         struct sd_emmc_global_regs *sd_emmc_reg = aml_priv->sd_emmc_reg;
         struct cmd_cfg *des_cmd_cur = NULL;
         struct sd_emmc_desc_info *desc_cur = (struct sd_emmc_desc_info*)aml_priv->desc_buf;
@@ -330,18 +404,34 @@ int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
                 des_cmd_cur->no_resp = 1;
 
         if (data) {
+                data_size = data->blocks * data->blocksize;
                 des_cmd_cur->data_io = 1; // cmd has data read or write
                 if (data->flags == MMC_DATA_READ) {
                         des_cmd_cur->data_wr = 0;  //read data from sd/emmc
-                        buffer = (unsigned long)data->dest;//dma_map_single((void*)data->dest,data->blocks*data->blocksize,DMA_FROM_DEVICE);
-                        invalidate_dcache_range((unsigned long)data->dest, (unsigned long)(data->dest+data->blocks*data->blocksize));
+                        if (data_size < 0x200) {
+                                /* read through the ping buffer below */
+                        } else if (aml_sd_dma_aligned(data->dest, data_size)) {
+                                buffer = (unsigned long)data->dest;
+                        } else {
+                                bounce = aml_sd_get_bounce(xfer);
+                                if (!bounce)
+                                        return SD_ERROR_NO_MEMORY;
+                                buffer = (unsigned long)bounce;
+                        }
+                        if (buffer)
+                                invalidate_dcache_range(buffer, buffer + data_size);
                 }else{
                         des_cmd_cur->data_wr = 1;
-                        //buffer = (unsigned long)data->src;//dma_map_single((void*)data->src,data->blocks*data->blocksize,DMA_TO_DEVICE);//(char *)data->src;
-                        write_buffer = (u32 *)malloc(128*1024);
-                        memset(write_buffer, 0 ,128*1024);
-                        memcpy(write_buffer, (u32 *)data->src, data->blocks*data->blocksize);
-                        flush_dcache_range((unsigned)(long)write_buffer,(unsigned long)(write_buffer+data->blocks*data->blocksize));
+                        if (aml_sd_dma_aligned(data->src, data_size)) {
+                                buffer = (unsigned long)data->src;
+                        } else {
+                                bounce = aml_sd_get_bounce(xfer);
+                                if (!bounce)
+                                        return SD_ERROR_NO_MEMORY;
+                                memcpy(bounce, data->src, data_size);
+                                buffer = (unsigned long)bounce;
+                        }
+                        flush_dcache_range(buffer, buffer + data_size);
                 }
 
                 if (data->blocks > 1) {
@@ -352,10 +442,7 @@ int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
                         des_cmd_cur->length = data->blocksize;
                 }
                 des_cmd_cur->data_num = 0;
-                if (des_cmd_cur->data_wr == 1)
-                        desc_cur->data_addr = (unsigned long)write_buffer;
-                else
-                        desc_cur->data_addr = buffer;
+                desc_cur->data_addr = buffer;
                 desc_cur->data_addr &= ~(1<<0);   //DDR
 
         }
@@ -373,28 +460,49 @@ int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 
         des_cmd_cur->end_of_chain = 1; //the end flag of descriptor chain
 
+        if (data && data->blocks > AML_SD_DESC_BLOCKS)
+                desc_num = aml_sd_build_chain(desc_cur, data, buffer);
+
         sd_emmc_reg->gstatus = NEWSD_IRQ_ALL;
 
-        invalidate_dcache_range((unsigned long)aml_priv->desc_buf,
-                        (unsigned long)(aml_priv->desc_buf+NEWSD_MAX_DESC_MUN*(sizeof(struct sd_emmc_desc_info))));
         //start transfer cmd
-        desc_start->init = 0;
-        desc_start->busy = 1;
-        desc_start->addr = (unsigned long)aml_priv->desc_buf >> 2;
-#if 0
-        sd_emmc_reg->gstart = vstart;
-#else
-        sd_emmc_reg->gcmd_cfg = desc_cur->cmd_info;
-        sd_emmc_reg->gcmd_dat = desc_cur->data_addr;
-        sd_emmc_reg->gcmd_arg = desc_cur->cmd_arg;
-#endif
-    //waiting end of chain
-        //mmc->refix = 0;
-        while (1) {
-                status_irq = sd_emmc_reg->gstatus;
-                if (status_irq_reg->end_of_chain)
-                        break;
+        if (desc_num > 1) {
+                /* the controller fetches the chain from memory */
+                flush_dcache_range((unsigned long)aml_priv->desc_buf,
+                                (unsigned long)(aml_priv->desc_buf +
+                                desc_num * sizeof(struct sd_emmc_desc_info)));
+                desc_start->init = 0;
+                desc_start->busy = 1;
+                desc_start->addr = (unsigned long)aml_priv->desc_buf >> 2;
+                sd_emmc_reg->gstart = vstart;
+        } else {
+                sd_emmc_reg->gcmd_cfg = desc_cur->cmd_info;
+                sd_emmc_reg->gcmd_dat = desc_cur->data_addr;
+                sd_emmc_reg->gcmd_arg = desc_cur->cmd_arg;
         }
+
+        xfer->bounced = bounce != NULL;
+        xfer->buffer = buffer;
+        xfer->data_size = data_size;
+
+        return SD_NO_ERROR;
+}
+
+/*
+ * Completes the command started by aml_sd_start_cmd(), once the
+ * controller reports the end of the chain in @status_irq.
+ */
+static int aml_sd_finish_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+                             struct mmc_data *data, u32 status_irq)
+{
+        int ret = SD_NO_ERROR;
+        struct sd_emmc_status *status_irq_reg = (void *)&status_irq;
+        struct aml_card_sd_info *aml_priv = mmc->priv;
+        struct aml_sd_xfer *xfer = &aml_sd_xfer[aml_priv->sd_emmc_port];
+        struct sd_emmc_global_regs *sd_emmc_reg = aml_priv->sd_emmc_reg;
+        u32 buffer = xfer->buffer;
+        u32 data_size = xfer->data_size;
+
         if (status_irq_reg->rxd_err) {
                 ret |= SD_EMMC_RXD_ERROR;
                 if (!mmc->refix)
@@ -431,9 +539,14 @@ int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
                     printf("emmc/sd descripter timeout, cmd%d, status=0x%x\n",
                         cmd->cmdidx, status_irq);
         }
-        if (data) {
-                if ((data->blocks*data->blocksize <0x200) && (data->flags == MMC_DATA_READ)) {
-                        memcpy(data->dest, (const void *)sd_emmc_reg->gping,data->blocks*data->blocksize);
+        if (data && (data->flags == MMC_DATA_READ)) {
+                if (data_size < 0x200) {
+                        memcpy(data->dest, (const void *)sd_emmc_reg->gping, data_size);
+                } else {
+                        /* drop lines the CPU may have pulled in meanwhile */
+                        invalidate_dcache_range(buffer, buffer + data_size);
+                        if (xfer->bounced)
+                                memcpy(data->dest, xfer->bounce_buf, data_size);
                 }
         }
         /*we get response [0]:bit0~31
@@ -462,10 +575,6 @@ int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
         sd_debug("cmd->response[1]=0x%x;\n",cmd->response[1]);
         sd_debug("cmd->response[2]=0x%x;\n",cmd->response[2]);
         sd_debug("cmd->response[3]=0x%x;\n",cmd->response[3]);
-        if (des_cmd_cur->data_wr == 1) {
-                free(write_buffer);
-                write_buffer = NULL;
-        }
         if (ret) {
                 if (status_irq_reg->resp_timeout)
                         return TIMEOUT;
@@ -476,6 +585,48 @@ int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
         return SD_NO_ERROR;
 }
 
+/*
+ * Sends a command out on the bus. Takes the mmc pointer,
+ * a command pointer, and an optional data pointer.
+ */
+int aml_sd_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
+{
+        struct aml_card_sd_info *aml_priv = mmc->priv;
+        struct sd_emmc_global_regs *sd_emmc_reg = aml_priv->sd_emmc_reg;
+        u32 status_irq = 0;
+        struct sd_emmc_status *status_irq_reg = (void *)&status_irq;
+        int ret;
+
+        ret = aml_sd_start_cmd(mmc, cmd, data);
+        if (ret)
+                return ret;
+
+    //waiting end of chain
+        //mmc->refix = 0;
+        while (1) {
+                status_irq = sd_emmc_reg->gstatus;
+                if (status_irq_reg->end_of_chain)
+                        break;
+        }
+
+        return aml_sd_finish_cmd(mmc, cmd, data, status_irq);
+}
+
+#ifdef CONFIG_BLOCK_ASYNC
+static int aml_sd_send_cmd_poll(struct mmc *mmc, struct mmc_cmd *cmd,
+                                struct mmc_data *data)
+{
+        struct aml_card_sd_info *aml_priv = mmc->priv;
+        u32 status_irq = aml_priv->sd_emmc_reg->gstatus;
+        struct sd_emmc_status *status_irq_reg = (void *)&status_irq;
+
+        if (!status_irq_reg->end_of_chain)
+                return -EBUSY;
+
+        return aml_sd_finish_cmd(mmc, cmd, data, status_irq);
+}
+#endif
+
 int aml_sd_init(struct mmc *mmc)
 {
 	struct aml_card_sd_info *sdio=mmc->priv;
@@ -757,6 +908,10 @@ int aml_sd_calibration(struct mmc *mmc)
 
 static const struct mmc_ops aml_sd_emmc_ops = {
 	.send_cmd	= aml_sd_send_cmd,
+#ifdef CONFIG_BLOCK_ASYNC
+	.send_cmd_start	= aml_sd_start_cmd,
+	.send_cmd_poll	= aml_sd_send_cmd_poll,
+#endif
 	.set_ios	= aml_sd_cfg_swth,
 	.init		= aml_sd_init,
 //	.getcd		= ,
@@ -779,6 +934,7 @@ void sd_emmc_register(struct aml_card_sd_info * aml_priv)
 
 	cfg->voltages = MMC_VDD_33_34|MMC_VDD_32_33|MMC_VDD_31_32|MMC_VDD_165_195;
 	cfg->host_caps = MMC_MODE_8BIT|MMC_MODE_4BIT | MMC_MODE_HS_52MHz | MMC_MODE_HS |
+			     MMC_MODE_CMD23 |
 #if CONFIG_EMMC_DDR52_EN
 			     MMC_MODE_HC | MMC_MODE_DDR_52MHz;
 #else
@@ -787,7 +943,7 @@ void sd_emmc_register(struct aml_card_sd_info * aml_priv)
 	cfg->f_min = 400000;
 	cfg->f_max = 40000000;
 	cfg->part_type = PART_TYPE_AML;
-	cfg->b_max = 256;
+	cfg->b_max = AML_SD_MAX_BLOCKS;
 	mmc_create(cfg,aml_priv);
 }
 
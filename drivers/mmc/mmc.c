@@ -138,6 +138,7 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 #else
 	ret = mmc->cfg->ops->send_cmd(mmc, cmd, data);
 #endif
+	mmc_count_cmd(mmc, cmd);
 	return ret;
 }
 
@@ -194,17 +195,48 @@ int mmc_send_status(struct mmc *mmc, int timeout)
 int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
+	int err;
 
 	if (mmc->ddr_mode)
 		return 0;
 
+	/* The card keeps the block length until it is reset */
+	if (mmc->cur_blocklen == len)
+		return 0;
+
 	cmd.cmdidx = MMC_CMD_SET_BLOCKLEN;
 	cmd.resp_type = MMC_RSP_R1;
 	cmd.cmdarg = len;
 
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	mmc->cur_blocklen = err ? 0 : len;
+
+	return err;
+}
+
+int mmc_set_blockcount(struct mmc *mmc, unsigned int blockcount,
+		       bool is_rel_write)
+{
+	struct mmc_cmd cmd = {0};
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blockcount & MMC_CMD23_MAX_BLOCKS;
+	if (is_rel_write)
+		cmd.cmdarg |= MMC_CMD23_ARG_REL_WR;
+	cmd.resp_type = MMC_RSP_R1;
+
 	return mmc_send_cmd(mmc, &cmd, NULL);
 }
 
+int mmc_set_reliable_write(struct mmc *mmc, int enable)
+{
+	if (enable && (!mmc->cmd23 || !mmc->rel_wr_sectors))
+		return -EOPNOTSUPP;
+	mmc->reliable_write = enable;
+
+	return 0;
+}
+
 struct mmc *find_mmc_device(int dev_num)
 {
 	struct mmc *m;
@@ -230,7 +262,13 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int ret = 0, err = 0, err_flag = 0, retries = 0;
+	int sbc = mmc_use_sbc(mmc, blkcnt);
 __RETRY:
+	if (sbc && mmc_set_blockcount(mmc, blkcnt, false)) {
+		ret = COMM_ERR;
+		goto __ERROR;
+	}
+
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
 	else
@@ -250,7 +288,8 @@ __RETRY:
 
 	ret = mmc_send_cmd(mmc, &cmd, &data);
 
-	if (blkcnt > 1) {
+	/* A pre-defined count ends by itself unless the transfer failed */
+	if (blkcnt > 1 && (!sbc || ret)) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -261,6 +300,7 @@ __RETRY:
 #endif
 		}
 	}
+__ERROR:
 	if (ret || err) {
 		if (err_flag == 0) {
 			err_flag = 1;
@@ -314,6 +354,98 @@ static ulong mmc_bread(int dev_num, lbaint_t start, lbaint_t blkcnt, void *dst)
 	return blkcnt;
 }
 
+#ifdef CONFIG_BLOCK_ASYNC
+/* Start reading the next chunk of at most b_max blocks of @req */
+static int mmc_read_start(struct mmc *mmc, struct blk_req *req)
+{
+	struct mmc_cmd *cmd = &mmc->async_cmd;
+	struct mmc_data *data = &mmc->async_data;
+	lbaint_t start = req->start + req->done;
+	lbaint_t cnt = req->blkcnt - req->done;
+
+	if (cnt > mmc->cfg->b_max)
+		cnt = mmc->cfg->b_max;
+
+	if (mmc_use_sbc(mmc, cnt) && mmc_set_blockcount(mmc, cnt, false))
+		return COMM_ERR;
+
+	if (cnt > 1)
+		cmd->cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+	else
+		cmd->cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+
+	if (mmc->high_capacity)
+		cmd->cmdarg = start;
+	else
+		cmd->cmdarg = start * mmc->read_bl_len;
+
+	cmd->resp_type = MMC_RSP_R1;
+
+	data->dest = req->buffer + req->done * mmc->read_bl_len;
+	data->blocks = cnt;
+	data->blocksize = mmc->read_bl_len;
+	data->flags = MMC_DATA_READ;
+
+	mmc_count_cmd(mmc, cmd);
+	return mmc->cfg->ops->send_cmd_start(mmc, cmd, data);
+}
+
+static int mmc_bread_submit(struct blk_req *req)
+{
+	struct mmc *mmc = find_mmc_device(req->block_dev->dev);
+
+	if (!mmc)
+		return -ENODEV;
+
+	if ((req->start + req->blkcnt) > mmc->block_dev.lba) {
+		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+			req->start + req->blkcnt, mmc->block_dev.lba);
+		return -EINVAL;
+	}
+	if (!emmckey_is_access_range_legal(mmc, req->start, req->blkcnt))
+		return -EACCES;
+
+	if (mmc_set_blocklen(mmc, mmc->read_bl_len))
+		return -EIO;
+
+	return mmc_read_start(mmc, req) ? -EIO : 0;
+}
+
+static int mmc_bread_poll(struct blk_req *req)
+{
+	struct mmc *mmc = find_mmc_device(req->block_dev->dev);
+	struct mmc_data *data = &mmc->async_data;
+	struct mmc_cmd cmd;
+	lbaint_t start = req->start + req->done;
+	int ret;
+
+	ret = mmc->cfg->ops->send_cmd_poll(mmc, &mmc->async_cmd, data);
+	if (ret == -EBUSY)
+		return 0;
+
+	if (data->blocks > 1 && (!mmc_use_sbc(mmc, data->blocks) || ret)) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+			printf("mmc fail to send stop cmd\n");
+			ret = -EIO;
+		}
+	}
+
+	/* Retry a failed chunk the synchronous way, which knows how to */
+	if (ret && mmc_read_blocks(mmc, data->dest, start, data->blocks) !=
+	    data->blocks)
+		return 1;
+
+	req->done += data->blocks;
+	if (req->done < req->blkcnt && !mmc_read_start(mmc, req))
+		return 0;
+
+	return 1;
+}
+#endif
+
 static int mmc_go_idle(struct mmc *mmc)
 {
 	struct mmc_cmd cmd;
@@ -668,6 +800,9 @@ int mmc_switch_part(int dev_num, unsigned int part_num)
 	if (!mmc)
 		return -1;
 
+	/* the cached blocks belong to the previous hardware partition */
+	blkcache_invalidate(IF_TYPE_MMC, dev_num);
+
 	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_PART_CONF,
 			 (mmc->part_config & ~PART_ACCESS_MASK)
 			 | (part_num & PART_ACCESS_MASK));
@@ -1053,6 +1188,7 @@ static int mmc_startup(struct mmc *mmc)
 	 * For SD, its erase group is always one sector
 	 */
 	mmc->erase_grp_size = 1;
+	mmc->erased_zero = 0;
 	mmc->part_config = MMCPART_NOAVAILABLE;
 	if (!IS_SD(mmc) && (mmc->version >= MMC_VERSION_4)) {
 		/* check  ext_csd version and capacity */
@@ -1102,6 +1238,18 @@ static int mmc_startup(struct mmc *mmc)
 		mmc->dev_lifetime_est_typ_b
 			= ext_csd[EXT_CSD_DEV_LIFETIME_EST_TYP_B];
 
+		/* what erased blocks read back as */
+		mmc->erased_zero = !err && !ext_csd[EXT_CSD_ERASED_MEM_CONT];
+
+		/* reliable write, from eMMC 4.3 on */
+		mmc->rel_wr_sectors = 0;
+		mmc->rel_wr_en = 0;
+		if (!err && ext_csd[EXT_CSD_REV] >= 3)
+			mmc->rel_wr_sectors = ext_csd[EXT_CSD_REL_WR_SEC_C];
+		if (!err && ext_csd[EXT_CSD_REV] >= 5)
+			mmc->rel_wr_en = !!(ext_csd[EXT_CSD_WR_REL_PARAM] &
+					    EXT_CSD_WR_REL_PARAM_EN);
+
 		/*
 		 * Host needs to enable ERASE_GRP_DEF bit if device is
 		 * partitioned. This bit will be lost every time after a reset
@@ -1303,6 +1451,17 @@ static int mmc_startup(struct mmc *mmc)
 		mmc->write_bl_len = MMC_MAX_BLOCK_LEN;
 	}
 
+	/*
+	 * SET_BLOCK_COUNT saves the STOP after every multi-block transfer.
+	 * All MMC cards from v3.1 have it, SD cards say so in the SCR.
+	 */
+	if (mmc->cfg->host_caps & MMC_MODE_CMD23) {
+		if (IS_SD(mmc))
+			mmc->cmd23 = !!(mmc->scr[0] & SD_SCR_CMD23);
+		else
+			mmc->cmd23 = mmc->version >= MMC_VERSION_3;
+	}
+
 	/* fill in device description */
 	mmc->block_dev.lun = 0;
 	mmc->block_dev.type = 0;
@@ -1391,6 +1550,16 @@ struct mmc *mmc_create(const struct mmc_config *cfg, void *priv)
 	mmc->block_dev.block_read = mmc_bread;
 	mmc->block_dev.block_write = mmc_bwrite;
 	mmc->block_dev.block_erase = mmc_berase;
+#ifdef CONFIG_BLOCK_ASYNC
+	if (cfg->ops->send_cmd_start && cfg->ops->send_cmd_poll) {
+		mmc->block_dev.block_read_submit = mmc_bread_submit;
+		mmc->block_dev.block_read_poll = mmc_bread_poll;
+#ifndef CONFIG_SPL_BUILD
+		mmc->block_dev.block_write_submit = mmc_bwrite_submit;
+		mmc->block_dev.block_write_poll = mmc_bwrite_poll;
+#endif
+	}
+#endif
 
 	/* setup initial part type */
 	mmc->block_dev.part_type = mmc->cfg->part_type;
@@ -1449,6 +1618,8 @@ int mmc_start_init(struct mmc *mmc)
 		return err;
 
 	mmc->ddr_mode = 0;
+	mmc->cur_blocklen = 0;
+	mmc->cmd23 = 0;
 	mmc_set_bus_width(mmc, 1);
 	mmc_set_clock(mmc, 1);
 
@@ -1583,6 +1754,9 @@ int mmc_init(struct mmc *mmc)
 	if (mmc->has_init)
 		return 0;
 
+	/* the card may have been replaced since the last init */
+	blkcache_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
+
 	start = get_timer(0);
 #ifdef CONFIG_KVIM2
 	mmc_bus_init();
@@ -1812,6 +1986,9 @@ int mmc_set_part_conf(struct mmc *mmc, u8 ack, u8 part_num, u8 access)
 
 	if (err)
 		return err;
+
+	/* the access bits may have selected another hardware partition */
+	blkcache_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
 	return 0;
 }
 
@@ -1860,24 +2037,31 @@ int mmc_key_write(unsigned char *buf, unsigned int size, uint32_t *actual_lenth)
 	ulong start, start_blk, blkcnt, ret;
 	unsigned char * temp_buf = buf;
 	int i = 2, dev = EMMC_DTB_DEV;
+	struct mmc *mmc = find_mmc_device(dev);
 	struct partitions * part = NULL;
 	struct virtual_partition *vpart = NULL;
 	vpart = aml_get_virtual_partition_by_name(MMC_KEY_NAME);
 	part = aml_get_partition_by_name(MMC_RESERVED_NAME);
 
+	if (!mmc)
+		return 1;
 	start = part->offset + vpart->offset;
 	start_blk = (start / MMC_BLOCK_SIZE);
 	blkcnt = (size / MMC_BLOCK_SIZE);
 	info_disprotect |= DISPROTECT_KEY;
+	/* keep a copy intact if power fails, when the card can */
+	mmc_set_reliable_write(mmc, 1);
 	do {
 		ret = mmc_bwrite(dev, start_blk, blkcnt, temp_buf);
 		if (ret != blkcnt) {
 			printf("[%s] %d, mmc_bwrite error\n",
 				__func__, __LINE__);
+			mmc_set_reliable_write(mmc, 0);
 			return 1;
 		}
 		start_blk += MMC_KEY_SIZE / MMC_BLOCK_SIZE;
 	} while (--i);
+	mmc_set_reliable_write(mmc, 0);
 	info_disprotect &= ~DISPROTECT_KEY;
 	return 0;
 }
@@ -16,6 +16,21 @@ extern int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data);
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+extern int mmc_set_blockcount(struct mmc *mmc, unsigned int blockcount,
+			      bool is_rel_write);
+
+static inline void mmc_count_cmd(struct mmc *mmc, struct mmc_cmd *cmd)
+{
+#ifdef CONFIG_MMC_CMD_STATS
+	mmc->cmd_stats[cmd->cmdidx % ARRAY_SIZE(mmc->cmd_stats)]++;
+#endif
+}
+
+/* Whether a transfer of @blkcnt blocks is announced with SET_BLOCK_COUNT */
+static inline int mmc_use_sbc(struct mmc *mmc, lbaint_t blkcnt)
+{
+	return mmc->cmd23 && blkcnt > 1 && blkcnt <= MMC_CMD23_MAX_BLOCKS;
+}
 
 #ifndef CONFIG_SPL_BUILD
 
@@ -24,6 +39,11 @@ extern unsigned long mmc_berase(int dev_num, lbaint_t start, lbaint_t blkcnt);
 extern ulong mmc_bwrite(int dev_num, lbaint_t start, lbaint_t blkcnt,
 		const void *src);
 
+#ifdef CONFIG_BLOCK_ASYNC
+extern int mmc_bwrite_submit(struct blk_req *req);
+extern int mmc_bwrite_poll(struct blk_req *req);
+#endif
+
 #else /* CONFIG_SPL_BUILD */
 
 /* SPL will never write or erase, declare dummies to reduce code size. */
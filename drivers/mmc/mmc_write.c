@@ -10,12 +10,14 @@
 #include <config.h>
 #include <common.h>
 #include <part.h>
+#include <errno.h>
 #include "mmc_private.h"
 
 extern bool emmckey_is_access_range_legal(struct mmc *mmc,
 		ulong start, lbaint_t blkcnt);
 
-static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
+static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt,
+			 uint arg)
 {
 	struct mmc_cmd cmd;
 	ulong end;
@@ -27,7 +29,7 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
 		end = (start + blkcnt - 1) * mmc->write_bl_len;
 		start *= mmc->write_bl_len;
 	}
-	printf("start = %lu,end = %lu\n",start,end);
+	debug("start = %lu,end = %lu\n", start, end);
 	if (IS_SD(mmc)) {
 		start_cmd = SD_CMD_ERASE_WR_BLK_START;
 		end_cmd = SD_CMD_ERASE_WR_BLK_END;
@@ -52,7 +54,7 @@ static ulong mmc_erase_t(struct mmc *mmc, ulong start, lbaint_t blkcnt)
 		goto err_out;
 
 	cmd.cmdidx = MMC_CMD_ERASE;
-	cmd.cmdarg = SECURE_ERASE;
+	cmd.cmdarg = arg;
 	cmd.resp_type = MMC_RSP_R1b;
 
 	err = mmc_send_cmd(mmc, &cmd, NULL);
@@ -79,6 +81,8 @@ unsigned long mmc_berase(int dev_num, lbaint_t start, lbaint_t blkcnt)
 	if (!emmckey_is_access_range_legal(mmc, start, blkcnt))
 		return blkcnt;
 
+	blkcache_invalidate(IF_TYPE_MMC, dev_num);
+
 	if (blkcnt == 0) {
 		blkcnt = mmc->capacity/512 - (mmc->capacity/512)% mmc->erase_grp_size; // erase whole
 		printf("blkcnt = %lu\n",blkcnt);
@@ -94,7 +98,7 @@ unsigned long mmc_berase(int dev_num, lbaint_t start, lbaint_t blkcnt)
 	while (blk < blkcnt) {
 		blk_r = ((blkcnt - blk) < mmc->erase_grp_size) ?
 			mmc->erase_grp_size : (blkcnt - blk);
-		err = mmc_erase_t(mmc, start + blk, blk_r);
+		err = mmc_erase_t(mmc, start + blk, blk_r, SECURE_ERASE);
 		if (err)
 			break;
 
@@ -108,12 +112,36 @@ unsigned long mmc_berase(int dev_num, lbaint_t start, lbaint_t blkcnt)
 	return 0;
 }
 
+int mmc_erase_groups(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+		     uint arg)
+{
+	int timeout = 1000;
+	int err;
+
+	if (!blkcnt || !mmc->erase_grp_size ||
+	    (start % mmc->erase_grp_size) || (blkcnt % mmc->erase_grp_size))
+		return -EINVAL;
+	if (!emmckey_is_access_range_legal(mmc, start, blkcnt))
+		return -EACCES;
+
+	blkcache_invalidate(IF_TYPE_MMC, mmc->block_dev.dev);
+
+	err = mmc_erase_t(mmc, start, blkcnt, arg);
+	if (err)
+		return err;
+
+	/* Waiting for the ready status */
+	return mmc_send_status(mmc, timeout);
+}
+
 static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 		lbaint_t blkcnt, const void *src)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout = 1000;
+	int rel = mmc->reliable_write;
+	int sbc = rel || mmc_use_sbc(mmc, blkcnt);
 	int ret;
 
 	if ((start + blkcnt) > mmc->block_dev.lba) {
@@ -124,11 +152,16 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
+	else if (blkcnt == 1 && !rel)
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
 	else
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
 
+	if (sbc && mmc_set_blockcount(mmc, blkcnt, rel)) {
+		printf("mmc fail to set block count\n");
+		return 0;
+	}
+
 	if (mmc->high_capacity)
 		cmd.cmdarg = start;
 	else
@@ -145,9 +178,11 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	if (ret)
 		printf("mmc write failed\n");
 	/* SPI multiblock writes terminate using a special
-	 * token, not a STOP_TRANSMISSION request.
+	 * token, not a STOP_TRANSMISSION request, and writes with
+	 * a pre-defined block count need none unless they failed.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) &&
+	    cmd.cmdidx == MMC_CMD_WRITE_MULTIPLE_BLOCK && (!sbc || ret)) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -166,6 +201,23 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	return blkcnt;
 }
 
+/*
+ * Without enhanced reliable write, a reliable write is either a single
+ * block or REL_WR_SEC_C blocks at an aligned address.
+ */
+static lbaint_t mmc_rel_wr_blocks(struct mmc *mmc, lbaint_t start,
+				  lbaint_t blkcnt)
+{
+	ulong rel = mmc->rel_wr_sectors;
+
+	if (!mmc->reliable_write || mmc->rel_wr_en)
+		return blkcnt;
+	if ((ulong)start % rel || blkcnt < rel)
+		return 1;
+
+	return rel;
+}
+
 ulong mmc_bwrite(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src)
 {
 	lbaint_t cur, blocks_todo = blkcnt;
@@ -177,12 +229,15 @@ ulong mmc_bwrite(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src)
 	if (!emmckey_is_access_range_legal(mmc, start, blkcnt))
 		return 0;
 
+	blkcache_invalidate(IF_TYPE_MMC, dev_num);
+
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
+		cur = mmc_rel_wr_blocks(mmc, start, cur);
 		if (mmc_write_blocks(mmc, start, cur, src) != cur)
 			return 0;
 		blocks_todo -= cur;
@@ -192,3 +247,149 @@ ulong mmc_bwrite(int dev_num, lbaint_t start, lbaint_t blkcnt, const void *src)
 
 	return blkcnt;
 }
+
+#ifdef CONFIG_BLOCK_ASYNC
+/* Start writing the next chunk of at most b_max blocks of @req */
+static int mmc_write_start(struct mmc *mmc, struct blk_req *req)
+{
+	struct mmc_cmd *cmd = &mmc->async_cmd;
+	struct mmc_data *data = &mmc->async_data;
+	lbaint_t start = req->start + req->done;
+	lbaint_t cnt = req->blkcnt - req->done;
+	int rel = mmc->reliable_write;
+
+	if (cnt > mmc->cfg->b_max)
+		cnt = mmc->cfg->b_max;
+	cnt = mmc_rel_wr_blocks(mmc, start, cnt);
+
+	if ((rel || mmc_use_sbc(mmc, cnt)) &&
+	    mmc_set_blockcount(mmc, cnt, rel))
+		return COMM_ERR;
+
+	if (cnt == 1 && !rel)
+		cmd->cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
+	else
+		cmd->cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
+
+	if (mmc->high_capacity)
+		cmd->cmdarg = start;
+	else
+		cmd->cmdarg = start * mmc->write_bl_len;
+
+	cmd->resp_type = MMC_RSP_R1;
+
+	data->src = req->buffer + req->done * mmc->write_bl_len;
+	data->blocks = cnt;
+	data->blocksize = mmc->write_bl_len;
+	data->flags = MMC_DATA_WRITE;
+
+	mmc->async_prg = 0;
+	mmc_count_cmd(mmc, cmd);
+	return mmc->cfg->ops->send_cmd_start(mmc, cmd, data);
+}
+
+/* Ask once whether the card is done programming: 1 if so, 0 if not yet */
+static int mmc_write_ready(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_SEND_STATUS;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+	if (!mmc_host_is_spi(mmc))
+		cmd.cmdarg = mmc->rca << 16;
+
+	if (mmc_send_cmd(mmc, &cmd, NULL))
+		return -EIO;
+	if ((cmd.response[0] & MMC_STATUS_RDY_FOR_DATA) &&
+	    (cmd.response[0] & MMC_STATUS_CURR_STATE) != MMC_STATE_PRG)
+		return 1;
+	if (cmd.response[0] & MMC_STATUS_MASK) {
+		printf("Status Error: 0x%08X\n", cmd.response[0]);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int mmc_bwrite_submit(struct blk_req *req)
+{
+	struct mmc *mmc = find_mmc_device(req->block_dev->dev);
+
+	if (!mmc)
+		return -ENODEV;
+
+	if ((req->start + req->blkcnt) > mmc->block_dev.lba) {
+		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+		       req->start + req->blkcnt, mmc->block_dev.lba);
+		return -EINVAL;
+	}
+	if (!emmckey_is_access_range_legal(mmc, req->start, req->blkcnt))
+		return -EACCES;
+
+	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
+		return -EIO;
+
+	return mmc_write_start(mmc, req) ? -EIO : 0;
+}
+
+/*
+ * Unlike mmc_write_blocks() the card is not waited for once the data
+ * is sent: each poll asks whether it is still programming.
+ */
+int mmc_bwrite_poll(struct blk_req *req)
+{
+	struct mmc *mmc = find_mmc_device(req->block_dev->dev);
+	struct mmc_cmd *cmd = &mmc->async_cmd;
+	struct mmc_data *data = &mmc->async_data;
+	struct mmc_cmd stop;
+	lbaint_t start = req->start + req->done;
+	int sbc;
+	int ret, err = 0;
+
+	if (!mmc->async_prg) {
+		err = mmc->cfg->ops->send_cmd_poll(mmc, cmd, data);
+		if (err == -EBUSY)
+			return 0;
+
+		sbc = mmc->reliable_write || mmc_use_sbc(mmc, data->blocks);
+		if (!mmc_host_is_spi(mmc) &&
+		    cmd->cmdidx == MMC_CMD_WRITE_MULTIPLE_BLOCK &&
+		    (!sbc || err)) {
+			stop.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+			stop.cmdarg = 0;
+			stop.resp_type = MMC_RSP_R1b;
+			if (mmc_send_cmd(mmc, &stop, NULL)) {
+				printf("mmc fail to send stop cmd\n");
+				err = -EIO;
+			}
+		}
+		if (!err) {
+			mmc->async_prg = 1;
+			mmc->async_timer = get_timer(0);
+		}
+	}
+
+	if (mmc->async_prg) {
+		ret = mmc_write_ready(mmc);
+		if (!ret && get_timer(mmc->async_timer) < 1000)
+			return 0;
+		if (!ret)
+			printf("Timeout waiting card ready\n");
+		if (ret != 1)
+			err = -EIO;
+		mmc->async_prg = 0;
+	}
+
+	/* Retry a failed chunk the synchronous way, which knows how to */
+	if (err && mmc_write_blocks(mmc, start, data->blocks, data->src) !=
+	    data->blocks)
+		return 1;
+
+	req->done += data->blocks;
+	if (req->done < req->blkcnt && !mmc_write_start(mmc, req))
+		return 0;
+
+	return 1;
+}
+#endif
@@ -0,0 +1,545 @@
+/*
+ * Sandbox NAND flash, backed by a host file
+ *
+ * The file holds each page followed by its OOB area, pages * (page + oob)
+ * bytes in all; a new or short file is padded out with erased pages.
+ * The chip takes the large page command set from nand_base, programs can
+ * only clear bits, and ECC is done in software. Array and bus times are
+ * spent for real: the ready line stays low for tR/tPROG/tBERS after each
+ * operation and data transfers take tbus per byte, so UBI attach and
+ * UBIFS mount times measured in sandbox follow those of a real part.
+ *
+ *   --nand <file>[,<key>=<value>...]
+ *
+ *   size=<MiB>		chip size (128)
+ *   page=<bytes>	page size, 2048 or more (2048)
+ *   oob=<bytes>	OOB size (64)
+ *   block=<KiB>	erase block size (128)
+ *   bad=<n>[:<n>...]	factory bad blocks; marked, and fail to erase
+ *   flip=<n>		flip one bit in every n-th page read (0, never)
+ *   tr=<us>		page read into the data register (25)
+ *   tprog=<us>		page program (250)
+ *   tbers=<us>		block erase (2000)
+ *   tbus=<ns>		each byte moved over the bus (25)
+ *
+ * "sb nand" shows what the chip was asked to do and the time it took.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <nand.h>
+#include <os.h>
+#include <asm/getopt.h>
+#include <asm/state.h>
+
+#define SBNAND_MAX_BAD		16
+
+/* Micron maker ID; the device ID only has to match sbnand_ids */
+#define SBNAND_MFR_ID		NAND_MFR_MICRON
+#define SBNAND_DEV_ID		0x5b
+
+enum sbnand_mode {
+	SBNAND_DATA,
+	SBNAND_ID,
+	SBNAND_STATUS,
+};
+
+struct sbnand_stats {
+	ulong reads;
+	ulong programs;
+	ulong erases;
+	ulong flips;
+	u64 bus_bytes;
+	u64 array_us;
+	u64 bus_us;
+};
+
+struct sbnand_priv {
+	int fd;
+	u32 chipsize_mb;
+	u32 pagesize;
+	u32 oobsize;
+	u32 blocksize;
+	u32 bad[SBNAND_MAX_BAD];
+	int nbad;
+	u32 flip;
+	u32 t_r;
+	u32 t_prog;
+	u32 t_bers;
+	u32 t_bus_ns;
+
+	u8 *reg;		/* data register, page + oob */
+	u32 pos;
+	int page;
+	enum sbnand_mode mode;
+	u8 status;
+	ulong ready_at;		/* timer_get_us() when R/B# goes high */
+	u32 reads_since_flip;
+	u32 seed;
+	struct sbnand_stats stats;
+};
+
+static struct sbnand_priv sbnand;
+
+static struct nand_ecclayout sbnand_layout;
+
+static struct nand_flash_dev sbnand_ids[] = {
+	EXTENDED_ID_NAND("Sandbox NAND", SBNAND_DEV_ID, 0, 0),
+	{ NULL }
+};
+
+static int sandbox_cmdline_cb_nand(struct sandbox_state *state,
+				   const char *arg)
+{
+	state->nand_spec = arg;
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(nand, 1, "NAND backed by <file>[,<key>=<value>...]");
+
+static void sbnand_spin(ulong us)
+{
+	ulong start = timer_get_us();
+
+	while (timer_get_us() - start < us)
+		;
+}
+
+static void sbnand_busy(struct sbnand_priv *priv, ulong us)
+{
+	priv->ready_at = timer_get_us() + us;
+	priv->stats.array_us += us;
+}
+
+static void sbnand_bus(struct sbnand_priv *priv, int len)
+{
+	ulong us = (ulong)len * priv->t_bus_ns / 1000;
+
+	priv->stats.bus_bytes += len;
+	priv->stats.bus_us += us;
+	sbnand_spin(us);
+}
+
+static int sbnand_is_bad(struct sbnand_priv *priv, u32 block)
+{
+	int i;
+
+	for (i = 0; i < priv->nbad; i++)
+		if (priv->bad[i] == block)
+			return 1;
+	return 0;
+}
+
+static int sbnand_raw_size(struct sbnand_priv *priv)
+{
+	return priv->pagesize + priv->oobsize;
+}
+
+static void sbnand_load(struct sbnand_priv *priv, int page)
+{
+	int size = sbnand_raw_size(priv);
+	ssize_t got = 0;
+
+	if (os_lseek(priv->fd, (off_t)page * size, OS_SEEK_SET) >= 0)
+		got = os_read(priv->fd, priv->reg, size);
+	if (got < 0)
+		got = 0;
+	memset(priv->reg + got, 0xff, size - got);
+}
+
+static int sbnand_store(struct sbnand_priv *priv, int page, const u8 *buf)
+{
+	int size = sbnand_raw_size(priv);
+
+	if (os_lseek(priv->fd, (off_t)page * size, OS_SEEK_SET) < 0 ||
+	    os_write(priv->fd, buf, size) != size)
+		return -EIO;
+	return 0;
+}
+
+/* Read disturb: flip one data bit, the stored page stays intact */
+static void sbnand_disturb(struct sbnand_priv *priv)
+{
+	u32 bit;
+
+	if (!priv->flip || ++priv->reads_since_flip < priv->flip)
+		return;
+	priv->reads_since_flip = 0;
+
+	priv->seed ^= priv->seed << 13;
+	priv->seed ^= priv->seed >> 17;
+	priv->seed ^= priv->seed << 5;
+	bit = priv->seed % (priv->pagesize * 8);
+	priv->reg[bit / 8] ^= 1 << (bit % 8);
+	priv->stats.flips++;
+}
+
+static void sbnand_program(struct sbnand_priv *priv)
+{
+	int size = sbnand_raw_size(priv);
+	u8 *cur = malloc(size);
+	int i;
+
+	priv->stats.programs++;
+	sbnand_busy(priv, priv->t_prog);
+
+	if (!cur) {
+		priv->status |= NAND_STATUS_FAIL;
+		return;
+	}
+	/* Programming can only turn ones into zeroes */
+	memcpy(cur, priv->reg, size);
+	sbnand_load(priv, priv->page);
+	for (i = 0; i < size; i++)
+		cur[i] &= priv->reg[i];
+	if (sbnand_store(priv, priv->page, cur))
+		priv->status |= NAND_STATUS_FAIL;
+	free(cur);
+}
+
+static void sbnand_erase(struct sbnand_priv *priv)
+{
+	int ppb = priv->blocksize / priv->pagesize;
+	int first = priv->page & ~(ppb - 1);
+	int i;
+
+	priv->stats.erases++;
+	sbnand_busy(priv, priv->t_bers);
+
+	if (sbnand_is_bad(priv, first / ppb)) {
+		priv->status |= NAND_STATUS_FAIL;
+		return;
+	}
+	memset(priv->reg, 0xff, sbnand_raw_size(priv));
+	for (i = 0; i < ppb; i++) {
+		if (sbnand_store(priv, first + i, priv->reg)) {
+			priv->status |= NAND_STATUS_FAIL;
+			return;
+		}
+	}
+}
+
+static void sbnand_cmdfunc(struct mtd_info *mtd, unsigned command,
+			   int column, int page_addr)
+{
+	struct sbnand_priv *priv = &sbnand;
+
+	switch (command) {
+	case NAND_CMD_RESET:
+		priv->mode = SBNAND_DATA;
+		priv->status = 0;
+		sbnand_busy(priv, 5);
+		break;
+	case NAND_CMD_READID:
+		priv->mode = SBNAND_ID;
+		priv->pos = 0;
+		break;
+	case NAND_CMD_STATUS:
+		priv->mode = SBNAND_STATUS;
+		break;
+	case NAND_CMD_READOOB:
+		column += priv->pagesize;
+		/* fall through */
+	case NAND_CMD_READ0:
+		priv->mode = SBNAND_DATA;
+		priv->page = page_addr;
+		priv->pos = column;
+		priv->stats.reads++;
+		sbnand_load(priv, page_addr);
+		sbnand_disturb(priv);
+		/* nand_base reads the register right after this returns */
+		sbnand_busy(priv, priv->t_r);
+		sbnand_spin(priv->t_r);
+		break;
+	case NAND_CMD_RNDOUT:
+	case NAND_CMD_RNDIN:
+		priv->mode = SBNAND_DATA;
+		priv->pos = column;
+		break;
+	case NAND_CMD_SEQIN:
+		priv->mode = SBNAND_DATA;
+		priv->page = page_addr;
+		priv->pos = column;
+		priv->status = 0;
+		memset(priv->reg, 0xff, sbnand_raw_size(priv));
+		break;
+	case NAND_CMD_PAGEPROG:
+		sbnand_program(priv);
+		break;
+	case NAND_CMD_ERASE1:
+		priv->page = page_addr;
+		priv->status = 0;
+		break;
+	case NAND_CMD_ERASE2:
+		sbnand_erase(priv);
+		break;
+	default:
+		debug("%s: command %02x ignored\n", __func__, command);
+		break;
+	}
+}
+
+static int sbnand_dev_ready(struct mtd_info *mtd)
+{
+	return (long)(timer_get_us() - sbnand.ready_at) >= 0;
+}
+
+static uint8_t sbnand_read_byte(struct mtd_info *mtd)
+{
+	struct sbnand_priv *priv = &sbnand;
+	u8 id[] = { SBNAND_MFR_ID, SBNAND_DEV_ID };
+
+	switch (priv->mode) {
+	case SBNAND_ID:
+		return priv->pos < sizeof(id) ? id[priv->pos++] : 0;
+	case SBNAND_STATUS:
+		return priv->status | NAND_STATUS_WP |
+			(sbnand_dev_ready(mtd) ? NAND_STATUS_READY : 0);
+	default:
+		if (priv->pos >= sbnand_raw_size(priv))
+			return 0xff;
+		return priv->reg[priv->pos++];
+	}
+}
+
+static void sbnand_read_buf(struct mtd_info *mtd, uint8_t *buf, int len)
+{
+	struct sbnand_priv *priv = &sbnand;
+
+	len = min_t(int, len, sbnand_raw_size(priv) - priv->pos);
+	memcpy(buf, priv->reg + priv->pos, len);
+	priv->pos += len;
+	sbnand_bus(priv, len);
+}
+
+static void sbnand_write_buf(struct mtd_info *mtd, const uint8_t *buf,
+			     int len)
+{
+	struct sbnand_priv *priv = &sbnand;
+
+	len = min_t(int, len, sbnand_raw_size(priv) - priv->pos);
+	memcpy(priv->reg + priv->pos, buf, len);
+	priv->pos += len;
+	sbnand_bus(priv, len);
+}
+
+static void sbnand_select_chip(struct mtd_info *mtd, int chipnr)
+{
+}
+
+static int sbnand_init_size(struct mtd_info *mtd, struct nand_chip *chip,
+			    u8 *id_data)
+{
+	struct sbnand_priv *priv = &sbnand;
+
+	chip->bits_per_cell = 1;
+	chip->chipsize = (u64)priv->chipsize_mb << 20;
+	mtd->writesize = priv->pagesize;
+	mtd->oobsize = priv->oobsize;
+	mtd->erasesize = priv->blocksize;
+
+	return 0;
+}
+
+static int sbnand_parse(struct sbnand_priv *priv, char *spec,
+			const char **fname)
+{
+	char *opt, *val;
+
+	priv->chipsize_mb = 128;
+	priv->pagesize = 2048;
+	priv->oobsize = 64;
+	priv->blocksize = 128 << 10;
+	priv->t_r = 25;
+	priv->t_prog = 250;
+	priv->t_bers = 2000;
+	priv->t_bus_ns = 25;
+
+	*fname = strsep(&spec, ",");
+	while ((opt = strsep(&spec, ","))) {
+		val = strchr(opt, '=');
+		if (!val)
+			return -EINVAL;
+		*val++ = '\0';
+
+		if (!strcmp(opt, "size"))
+			priv->chipsize_mb = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "page"))
+			priv->pagesize = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "oob"))
+			priv->oobsize = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "block"))
+			priv->blocksize = simple_strtoul(val, NULL, 0) << 10;
+		else if (!strcmp(opt, "flip"))
+			priv->flip = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "tr"))
+			priv->t_r = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "tprog"))
+			priv->t_prog = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "tbers"))
+			priv->t_bers = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "tbus"))
+			priv->t_bus_ns = simple_strtoul(val, NULL, 0);
+		else if (!strcmp(opt, "bad"))
+			while (*val && priv->nbad < SBNAND_MAX_BAD) {
+				priv->bad[priv->nbad++] =
+					simple_strtoul(val, &val, 0);
+				if (*val == ':')
+					val++;
+			}
+		else
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int sbnand_check_geometry(struct sbnand_priv *priv)
+{
+	int eccbytes = priv->pagesize / 256 * 3;
+
+	if (priv->pagesize < 2048 || !is_power_of_2(priv->pagesize) ||
+	    !is_power_of_2(priv->blocksize) ||
+	    priv->blocksize < priv->pagesize ||
+	    !is_power_of_2(priv->chipsize_mb) ||
+	    ((u64)priv->chipsize_mb << 20) < priv->blocksize)
+		return -EINVAL;
+	/* the bad block marker and the ECC bytes have to fit */
+	if (priv->oobsize < eccbytes + 2 ||
+	    eccbytes > MTD_MAX_ECCPOS_ENTRIES_LARGE)
+		return -EINVAL;
+
+	return 0;
+}
+
+/* ECC at the end of the OOB area, the rest after the marker is free */
+static void sbnand_setup_layout(struct sbnand_priv *priv)
+{
+	int eccbytes = priv->pagesize / 256 * 3;
+	int i;
+
+	sbnand_layout.eccbytes = eccbytes;
+	for (i = 0; i < eccbytes; i++)
+		sbnand_layout.eccpos[i] = priv->oobsize - eccbytes + i;
+	sbnand_layout.oobfree[0].offset = 2;
+	sbnand_layout.oobfree[0].length = priv->oobsize - eccbytes - 2;
+}
+
+/* Pad the file to the full chip with erased pages */
+static int sbnand_fill(struct sbnand_priv *priv)
+{
+	int pages = ((u64)priv->chipsize_mb << 20) / priv->pagesize;
+	int size = sbnand_raw_size(priv);
+	off_t end = os_lseek(priv->fd, 0, OS_SEEK_END);
+	int page;
+
+	if (end < 0)
+		return -EIO;
+	memset(priv->reg, 0xff, size);
+	for (page = (end + size - 1) / size; page < pages; page++)
+		if (sbnand_store(priv, page, priv->reg))
+			return -EIO;
+
+	return 0;
+}
+
+/* Factory bad blocks carry a zero marker in their first two pages */
+static void sbnand_mark_bad(struct sbnand_priv *priv)
+{
+	int ppb = priv->blocksize / priv->pagesize;
+	int i, j;
+
+	for (i = 0; i < priv->nbad; i++) {
+		for (j = 0; j < 2; j++) {
+			priv->page = priv->bad[i] * ppb + j;
+			memset(priv->reg, 0xff, sbnand_raw_size(priv));
+			priv->reg[priv->pagesize] = 0;
+			sbnand_program(priv);
+		}
+	}
+	memset(&priv->stats, '\0', sizeof(priv->stats));
+}
+
+void sandbox_nand_show_stats(int reset)
+{
+	struct sbnand_stats *st = &sbnand.stats;
+
+	printf("page reads:     %lu\n", st->reads);
+	printf("page programs:  %lu\n", st->programs);
+	printf("block erases:   %lu\n", st->erases);
+	printf("bits flipped:   %lu\n", st->flips);
+	printf("bus bytes:      %llu\n", st->bus_bytes);
+	printf("array busy:     %llu us\n", st->array_us);
+	printf("bus busy:       %llu us\n", st->bus_us);
+
+	if (reset)
+		memset(st, '\0', sizeof(*st));
+}
+
+static int sbnand_init(void)
+{
+	struct sandbox_state *state = state_get_current();
+	struct sbnand_priv *priv = &sbnand;
+	static struct nand_chip chip;
+	struct mtd_info *mtd = &nand_info[0];
+	const char *fname;
+	char *spec;
+	int ret;
+
+	if (!state->nand_spec)
+		return 0;
+
+	spec = strdup(state->nand_spec);
+	if (!spec)
+		return -ENOMEM;
+	if (sbnand_parse(priv, spec, &fname) ||
+	    sbnand_check_geometry(priv)) {
+		printf("sandbox nand: bad --nand %s\n", state->nand_spec);
+		return -EINVAL;
+	}
+
+	priv->reg = malloc(sbnand_raw_size(priv));
+	if (!priv->reg)
+		return -ENOMEM;
+	priv->fd = os_open(fname, OS_O_RDWR | OS_O_CREAT);
+	if (priv->fd < 0) {
+		printf("sandbox nand: cannot open %s\n", fname);
+		free(priv->reg);
+		return -EIO;
+	}
+	if (sbnand_fill(priv)) {
+		printf("sandbox nand: cannot write %s\n", fname);
+		os_close(priv->fd);
+		free(priv->reg);
+		return -EIO;
+	}
+	priv->seed = 0x5eed;
+	sbnand_mark_bad(priv);
+	sbnand_setup_layout(priv);
+
+	chip.cmdfunc = sbnand_cmdfunc;
+	chip.dev_ready = sbnand_dev_ready;
+	chip.read_byte = sbnand_read_byte;
+	chip.read_buf = sbnand_read_buf;
+	chip.write_buf = sbnand_write_buf;
+	chip.select_chip = sbnand_select_chip;
+	chip.init_size = sbnand_init_size;
+	chip.ecc.mode = NAND_ECC_SOFT;
+	chip.ecc.layout = &sbnand_layout;
+	mtd->priv = &chip;
+
+	ret = nand_scan_ident(mtd, 1, sbnand_ids);
+	if (!ret)
+		ret = nand_scan_tail(mtd);
+	if (!ret)
+		ret = nand_register(0);
+
+	return ret;
+}
+
+void board_nand_init(void)
+{
+	if (sbnand_init())
+		puts("sandbox nand: not available\n");
+}
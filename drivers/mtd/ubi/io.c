@@ -92,6 +92,10 @@ static int self_check_vid_hdr(const struct ubi_device *ubi, int pnum,
 			      const struct ubi_vid_hdr *vid_hdr);
 static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
 			    int offset, int len);
+static int check_ec_hdr(const struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose);
+static int check_vid_hdr(const struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err, int verbose);
 
 /**
  * ubi_io_read - read data from a physical eraseblock.
@@ -722,8 +726,7 @@ bad:
 int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		       struct ubi_ec_hdr *ec_hdr, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
+	int read_err;
 
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
@@ -744,6 +747,25 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		 */
 	}
 
+	return check_ec_hdr(ubi, pnum, ec_hdr, read_err, verbose);
+}
+
+/**
+ * check_ec_hdr - check an erase counter header that has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @ec_hdr: the erase counter header
+ * @read_err: what reading it returned
+ * @verbose: be verbose if the header is corrupted or was not found
+ *
+ * Returns the same codes as 'ubi_io_read_ec_hdr()'.
+ */
+static int check_ec_hdr(const struct ubi_device *ubi, int pnum,
+			struct ubi_ec_hdr *ec_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
 	magic = be32_to_cpu(ec_hdr->magic);
 	if (magic != UBI_EC_HDR_MAGIC) {
 		if (mtd_is_eccerr(read_err))
@@ -992,8 +1014,7 @@ bad:
 int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 			struct ubi_vid_hdr *vid_hdr, int verbose)
 {
-	int err, read_err;
-	uint32_t crc, magic, hdr_crc;
+	int read_err;
 	void *p;
 
 	dbg_io("read VID header from PEB %d", pnum);
@@ -1005,6 +1026,25 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 		return read_err;
 
+	return check_vid_hdr(ubi, pnum, vid_hdr, read_err, verbose);
+}
+
+/**
+ * check_vid_hdr - check a volume identifier header that has been read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock the header was read from
+ * @vid_hdr: the volume identifier header
+ * @read_err: what reading it returned
+ * @verbose: be verbose if the header is corrupted or was not found
+ *
+ * Returns the same codes as 'ubi_io_read_ec_hdr()'.
+ */
+static int check_vid_hdr(const struct ubi_device *ubi, int pnum,
+			 struct ubi_vid_hdr *vid_hdr, int read_err, int verbose)
+{
+	int err;
+	uint32_t crc, magic, hdr_crc;
+
 	magic = be32_to_cpu(vid_hdr->magic);
 	if (magic != UBI_VID_HDR_MAGIC) {
 		if (mtd_is_eccerr(read_err))
@@ -1058,6 +1098,59 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	return read_err ? UBI_IO_BITFLIPS : 0;
 }
 
+/**
+ * ubi_io_read_hdrs - read both headers of a PEB with a single MTD read.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock number to read from
+ * @ec_hdr: where to store the erase counter header
+ * @vid_hdr: where to store the volume identifier header
+ * @verbose: be verbose if a header is corrupted or wasn't found
+ * @vid_err: the VID header result is stored here
+ *
+ * Attaching by scanning needs both headers of every PEB. They sit at the
+ * start of the PEB, so one read fetches them and the flash driver can stream
+ * the pages back to back instead of being asked twice.
+ *
+ * Returns what 'ubi_io_read_ec_hdr()' would. Unless that is negative,
+ * %UBI_IO_FF or %UBI_IO_FF_BITFLIPS, @vid_err holds what
+ * 'ubi_io_read_vid_hdr()' would return. If the combined read reports
+ * bit-flips or an error, the headers are read again one by one so that
+ * they are charged to the right header.
+ */
+int ubi_io_read_hdrs(struct ubi_device *ubi, int pnum,
+		     struct ubi_ec_hdr *ec_hdr, struct ubi_vid_hdr *vid_hdr,
+		     int verbose, int *vid_err)
+{
+	int err, len = ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize;
+	void *p = (char *)vid_hdr - ubi->vid_hdr_shift;
+
+	dbg_io("read EC and VID headers from PEB %d", pnum);
+	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+
+	mutex_lock(&ubi->buf_mutex);
+	err = ubi_io_read(ubi, ubi->peb_buf, pnum, 0, len);
+	if (!err) {
+		memcpy(ec_hdr, ubi->peb_buf, UBI_EC_HDR_SIZE);
+		memcpy(p, ubi->peb_buf + ubi->vid_hdr_aloffset,
+		       ubi->vid_hdr_alsize);
+	}
+	mutex_unlock(&ubi->buf_mutex);
+
+	if (err) {
+		err = ubi_io_read_ec_hdr(ubi, pnum, ec_hdr, verbose);
+		if (err < 0 || err == UBI_IO_FF || err == UBI_IO_FF_BITFLIPS)
+			return err;
+		*vid_err = ubi_io_read_vid_hdr(ubi, pnum, vid_hdr, verbose);
+		return err;
+	}
+
+	err = check_ec_hdr(ubi, pnum, ec_hdr, 0, verbose);
+	if (err < 0 || err == UBI_IO_FF || err == UBI_IO_FF_BITFLIPS)
+		return err;
+	*vid_err = check_vid_hdr(ubi, pnum, vid_hdr, 0, verbose);
+	return err;
+}
+
 /**
  * ubi_io_write_vid_hdr - write a volume identifier header.
  * @ubi: UBI device description object
@@ -722,6 +722,112 @@ exit_0:
 }
 
 
+/* block by block, as boot loads kernel and logo, bad blocks skipped */
+static int nand_read_speed_test(struct amlnand_phydev *phydev,
+	unsigned char *buf, uint64_t len, ulong *ms)
+{
+	struct phydev_ops *devops = &(phydev->ops);
+	uint64_t addr, readlen = 0;
+	ulong start;
+	int ret = 0;
+
+	start = get_timer(0);
+	for (addr = 0; readlen < len && addr < phydev->size;
+		addr += phydev->erasesize) {
+		memset(devops, 0x0, sizeof(struct phydev_ops));
+		devops->addr = addr;
+		devops->len = phydev->erasesize;
+		devops->mode = NAND_HW_ECC;
+		ret = phydev->block_isbad(phydev);
+		if (ret > 0)
+			continue;
+		else if (ret < 0)
+			return ret;
+
+		devops->datbuf = buf + readlen;
+		ret = phydev->read(phydev);
+		if (ret == -EUCLEAN)
+			ret = 0;
+		if (ret) {
+			aml_nand_msg("nand read failed at %llx", addr);
+			return ret;
+		}
+		readlen += phydev->erasesize;
+	}
+	*ms = max(get_timer(start), 1UL);
+
+	return 0;
+}
+
+//nand_test  5 read throughput with and without cache read
+static int amlnand_test5(void)
+{
+	struct amlnand_phydev *phydev = NULL;
+	struct amlnand_chip *aml_chip;
+	unsigned char *data_buf = NULL;
+	uint64_t read_len;
+	u32 option, crc[2];
+	ulong ms[2];
+	int i, ret = 0;
+
+	list_for_each_entry(phydev, &nphy_dev_list, list) {
+		if (!strncmp(phydev->name, NAND_BOOT_NAME,
+			strlen((const char *)NAND_BOOT_NAME)))
+			continue;
+		aml_chip = (struct amlnand_chip *)phydev->priv;
+		option = aml_chip->flash.option;
+
+		read_len = min_t(uint64_t, phydev->size, 8 * phydev->erasesize);
+		data_buf = aml_nand_malloc(read_len);
+		if (!data_buf) {
+			aml_nand_msg("malloc failed");
+			return -1;
+		}
+
+		/* per page reads first, then cache read if the chip has it */
+		for (i = 0; i < 2; i++) {
+			if (i == 0)
+				aml_chip->flash.option &= ~NAND_CACHE_READ_MODE;
+			else if (option & NAND_CACHE_READ_MODE)
+				aml_chip->flash.option = option;
+			else
+				break;
+			ret = nand_read_speed_test(phydev, data_buf, read_len,
+				&ms[i]);
+			aml_chip->flash.option = option;
+			if (ret < 0) {
+				aml_nand_msg("nand test 5 : read failed");
+				goto exit_0;
+			}
+			crc[i] = crc32(0, data_buf, read_len);
+			aml_nand_msg("nand test 5 : %s %s: %llu KiB in %lu ms, %lu KiB/s",
+				phydev->name,
+				i ? "cache read" : "page read",
+				read_len >> 10,
+				ms[i],
+				(ulong)(read_len >> 10) * 1000 / ms[i]);
+		}
+		if (i == 1)
+			aml_nand_msg("nand test 5 : %s has no cache read",
+				aml_chip->flash.name);
+		else if (crc[0] != crc[1]) {
+			aml_nand_msg("nand test 5 : %s data differs",
+				phydev->name);
+			ret = -NAND_READ_FAILED;
+			goto exit_0;
+		}
+
+		kfree(data_buf);
+		data_buf = NULL;
+	}
+
+exit_0:
+	if (data_buf)
+		kfree(data_buf);
+
+	return ret;
+}
+
 int do_amlnand_test(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 {
 	int ret = 0;
@@ -773,6 +879,14 @@ int do_amlnand_test(cmd_tbl_t * cmdtp, int flag, int argc, char * const argv[])
 		}else
 			aml_nand_msg("amlnand_test4: READ all page  every block test OK");
 
+		return 0;
+	}else if (strncmp(cmd, "5", 1) == 0){
+		ret = amlnand_test5();
+		if (ret < 0) {
+			aml_nand_msg("amlnand_test5: read throughput test failed");
+		}else
+			aml_nand_msg("amlnand_test5: read throughput test OK");
+
 		return 0;
 	}else{
 			goto usage;
@@ -791,7 +905,7 @@ U_BOOT_CMD(amlnf_test, CONFIG_SYS_MAXARGS, 1, do_amlnand_test,
 	"amlnf_test  2 Endurance test, E/W/R 10 block 3000 times  \n"
 	"amlnf_test  3 write and read random pages of every block test \n"
 	"amlnf_test  4 READ all page every block   \n"
-	"amlnf_test  5 ...... \n"
+	"amlnf_test  5 read throughput, page read vs cache read \n"
 	"amlnf_test  8 exit sync \n"
 );
 
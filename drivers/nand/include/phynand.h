@@ -177,6 +177,8 @@ union nand_core_clk_t {
 #define	NAND_CTRL_NONE_RB		(1<<1)
 #define	NAND_CTRL_INTERLEAVING_MODE	(1<<2)
 #define	NAND_MULTI_PLANE_MODE		(1<<3)
+/* chip takes 31h/3Fh cache reads, set in the id table */
+#define	NAND_CACHE_READ_MODE		(1<<14)
 
 
 /***nand controller ECC options***/
@@ -340,6 +342,8 @@ union nand_core_clk_t {
 #define	NAND_CMD_SET_FEATURES		0xEF
 #define	NAND_CMD_GET_FEATURES		0xEE
 #define	NAND_CMD_READSTART		0x30
+#define	NAND_CMD_READCACHESEQ		0x31
+#define	NAND_CMD_READCACHEEND		0x3F
 #define	NAND_CMD_RNDOUTSTART		0xE0
 #define	NAND_CMD_CACHEDPROG		0x15
 
@@ -631,6 +635,8 @@ struct chip_operation {
 	int (*test_block_reserved)(struct amlnand_chip *aml_chip, int tst_blk);
 	/***basic data operation and included oob data****/
 	int (*read_page)(struct amlnand_chip *aml_chip);
+	/* sequential pages by cache read, returns pages done, 0 if unsupported */
+	int (*read_pages)(struct amlnand_chip *aml_chip, u32 pages);
 	int (*write_page)(struct amlnand_chip *aml_chip);
 
 	int (*block_isbad)(struct amlnand_chip *aml_chip);
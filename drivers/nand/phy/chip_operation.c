@@ -930,6 +930,146 @@ error_exit0:
 	return ret;
 }
 
+/*
+ * send a read command and wait until the cache register can be
+ * read out, tWB and R/B as _read_page_single_plane does.
+ */
+static int cache_read_cmd(struct amlnand_chip *aml_chip, u8 chipnr, u8 cmd)
+{
+	struct hw_controller *controller = &(aml_chip->controller);
+	int ret;
+
+	controller->cmd_ctrl(controller, cmd, NAND_CTRL_CLE);
+	NFC_SEND_CMD_IDLE(controller, NAND_TWB_TIME_CYCLE);
+	if (check_cmdfifo_size(controller)) {
+		aml_nand_msg("check cmdfifo size timeout");
+		BUG();
+	}
+	ret = controller->quene_rb(controller, chipnr);
+	if (ret) {
+		aml_nand_msg("quene rb busy here");
+		return ret;
+	}
+	/* status polling left the chip in status output */
+	if (controller->option & NAND_CTRL_NONE_RB) {
+		controller->cmd_ctrl(controller, NAND_CMD_READ0, NAND_CTRL_CLE);
+		NFC_SEND_CMD_IDLE(controller, NAND_TWB_TIME_CYCLE);
+	}
+	return 0;
+}
+
+/************************************************************
+ * read_pages, read up to @pages consecutive pages from
+ * ops_para->page_addr into ops_para->data_buf with cache read:
+ * 00h-30h loads the first page, then every 31h moves it to the
+ * cache register and starts loading the next one, so the array
+ * read of page N+1 runs while page N goes through DMA and BCH.
+ * 3Fh ends the sequence without loading another page.
+ *
+ * only hw ecc, single plane and single chip data reads of chips
+ * flagged NAND_CACHE_READ_MODE in the id table are handled, and
+ * the sequence never crosses a block. returns the number of pages
+ * read, 0 leaves everything to read_page. a page needing read
+ * retry stops the sequence, it is re-read through read_page.
+ *************************************************************/
+static int read_pages(struct amlnand_chip *aml_chip, u32 pages)
+{
+	struct hw_controller *controller = &(aml_chip->controller);
+	struct nand_flash *flash = &(aml_chip->flash);
+	struct chip_ops_para *ops_para = &(aml_chip->ops_para);
+	u32 page_addr = ops_para->page_addr;
+	u32 pages_per_blk, page_size, user_byte_num, i;
+	u8 chipnr = ops_para->chipnr;
+	u8 *buf = ops_para->data_buf;
+	int ret;
+
+	if (!(flash->option & NAND_CACHE_READ_MODE)
+		|| (ops_para->option & (DEV_SLC_MODE | DEV_ECC_SOFT_MODE
+			| DEV_MULTI_PLANE_MODE | DEV_MULTI_CHIP_MODE))
+		|| (controller->bch_mode == NAND_ECC_NONE)
+		|| (!ops_para->data_buf) || (ops_para->oob_buf)
+		|| (page_addr >= controller->internal_page_nums))
+		return 0;
+
+	pages_per_blk =
+		1 << (controller->block_shift - controller->page_shift);
+	pages = min_t(u32, pages,
+		pages_per_blk - (page_addr & (pages_per_blk - 1)));
+	pages = min_t(u32, pages, controller->internal_page_nums - page_addr);
+	if (pages < 2)
+		return 0;
+
+	user_byte_num = controller->ecc_steps * controller->user_mode;
+	page_size = controller->ecc_steps * controller->ecc_unit;
+
+	ret = controller->quene_rb(controller, chipnr);
+	if (ret) {
+		aml_nand_msg("quene rb busy here");
+		return ret;
+	}
+
+	controller->cmd_ctrl(controller, NAND_CMD_READ0, NAND_CTRL_CLE);
+	controller->cmd_ctrl(controller, 0x0, NAND_CTRL_ALE);
+	controller->cmd_ctrl(controller, 0x0, NAND_CTRL_ALE);
+	controller->cmd_ctrl(controller, page_addr, NAND_CTRL_ALE);
+	controller->cmd_ctrl(controller, page_addr>>8, NAND_CTRL_ALE);
+	controller->cmd_ctrl(controller, page_addr>>16, NAND_CTRL_ALE);
+	ret = cache_read_cmd(aml_chip, chipnr, NAND_CMD_READSTART);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < pages; i++) {
+		ret = cache_read_cmd(aml_chip, chipnr, (i + 1 < pages) ?
+			NAND_CMD_READCACHESEQ : NAND_CMD_READCACHEEND);
+		if (ret)
+			return ret;
+
+		/* transfer random seed. */
+		controller->page_addr = page_addr + i;
+		ret = controller->dma_read(controller,
+			page_size,
+			controller->bch_mode);
+		if (ret) {
+			aml_nand_msg("dma error here");
+			BUG();
+			return ret;
+		}
+
+		controller->get_usr_byte(controller,
+			controller->oob_buf,
+			user_byte_num);
+		ret = controller->hwecc_correct(controller,
+			page_size,
+			controller->oob_buf);
+		if (ret == NAND_ECC_FAILURE) {
+			if (controller->zero_cnt >= controller->ecc_max) {
+				/* the next page is loading, let it finish */
+				if ((i + 1 < pages) && cache_read_cmd(aml_chip,
+					chipnr, NAND_CMD_READCACHEEND))
+					return -NAND_BUSY_FAILURE;
+				return i;
+			}
+			memset(buf, 0xff, page_size);
+		} else {
+			if ((controller->ecc_cnt_cur > controller->ecc_cnt_limit)
+				&& (flash->new_type == 0)) {
+				aml_nand_dbg("detect bitflip page:%d, chip:%d",
+					page_addr + i,
+					chipnr);
+				ops_para->bit_flip++;
+			}
+			memcpy(buf, controller->data_buf, page_size);
+		}
+		buf += flash->pagesize;
+	}
+
+	if (check_cmdfifo_size(controller)) {
+		aml_nand_msg("check cmdfifo size timeout");
+		BUG();
+	}
+	return pages;
+}
+
 /************************************************************
  * write_page, all parameters saved in aml_chip->ops_para.
  * support read way of hwecc/raw, data/oob only, data+oob
@@ -2517,6 +2657,9 @@ int amlnand_init_operation(struct amlnand_chip *aml_chip)
 	if (!operation->read_page)
 		operation->read_page = read_page;
 
+	if (!operation->read_pages)
+		operation->read_pages = read_pages;
+
 	if (!operation->write_page)
 		operation->write_page = write_page;
 
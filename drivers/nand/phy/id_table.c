@@ -33,7 +33,7 @@ struct nand_flash flash_ids_mlc[] = {
 		20,
 		25,
 		0,
-		0},
+		NAND_CACHE_READ_MODE},
 	{"TOSHIBA 256MB SLC TC58BVG0S3HBAI6",
 		{NAND_MFR_TOSHIBA, 0xDA, 0x90, 0x15, 0xF6},
 		2048,
@@ -44,7 +44,7 @@ struct nand_flash flash_ids_mlc[] = {
 		20,
 		25,
 		0,
-		0},
+		NAND_CACHE_READ_MODE},
 /***for MLC nand***/
 	{"A revision NAND 2GiB H27UAG8T2A",
 		{NAND_MFR_HYNIX, 0xd5, 0x94, 0x25, 0x44, 0x41},
@@ -168,7 +168,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		5,
 		MICRON_20NM,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"D revision NAND 4GiB MT29F32G08CBADA",
 		{NAND_MFR_MICRON, 0x44, 0x44, 0x4B, 0xA9},
 		8192,
@@ -180,7 +180,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		5,
 		MICRON_20NM,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"1 Generation NAND 8GiB JS29F64G08ACMF1",
 		{NAND_MFR_INTEL, 0x88, 0x24, 0x4b, 0xA9, 0x84},
 		8192,
@@ -223,7 +223,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		0,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"A revision NAND 16GiB MT29F128G-A",
 		{NAND_MFR_MICRON, 0xd9, 0xd5, 0x3e, 0x88},
 		4096,
@@ -235,7 +235,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		0,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"B revision NAND 4GiB MT29F32G-B",
 		{NAND_MFR_MICRON, 0x68, 0x04, 0x46, 0x89},
 		4096,
@@ -247,7 +247,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		4,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"B revision NAND 8GiB MT29F64G-B",
 		{NAND_MFR_MICRON, 0x88, 0x05, 0xc6, 0x89},
 		4096,
@@ -259,7 +259,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		4,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"C revision NAND 4GiB MT29F32G-C",
 		{NAND_MFR_MICRON, 0x68, 0x04, 0x4a, 0xa9},
 		4096,
@@ -271,7 +271,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		5,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"C revision NAND 8GiB MT29F64G-C",
 		{NAND_MFR_MICRON, 0x88, 0x04, 0x4b, 0xa9},
 		8192,
@@ -283,7 +283,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		5,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 	{"C revision NAND 32GiB MT29F256G-C",
 		{NAND_MFR_MICRON, 0xa8, 0x05, 0xcb, 0xa9},
 		8192,
@@ -295,7 +295,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		5,
 		0,
-		NAND_MULTI_PLANE_MODE},
+		NAND_MULTI_PLANE_MODE | NAND_CACHE_READ_MODE},
 
 	{"1 Generation NAND 4GiB JS29F32G08AA-1",
 		{NAND_MFR_INTEL, 0x68, 0x04, 0x46, 0xA9},
@@ -405,7 +405,7 @@ struct nand_flash flash_ids_mlc[] = {
 		15,
 		0,
 		0,
-		0},
+		NAND_CACHE_READ_MODE},
 #if (AML_CFG_NEW_NAND_SUPPORT)
 	{"F serials NAND 4GiB TC58NVG5D2HTA00",
 		{NAND_MFR_TOSHIBA, 0xD7, 0x94, 0x32, 0x76, 0x56},
@@ -192,6 +192,24 @@ static int nand_read(struct amlnand_phydev *phydev)
 			ops_para->page_addr =
 				(int)(addr >> phydev->writesize_shift);
 
+		/* the rest of this block in one cache read sequence */
+		ret = operation->read_pages(aml_chip,
+			(len - readlen + phydev->writesize - 1)
+			>> phydev->writesize_shift);
+		if (ret < 0) {
+			aml_nand_msg("phy read failed at devops->addr: %llx",
+				devops->addr);
+			break;
+		} else if (ret > 0) {
+			addr += (u64)ret << phydev->writesize_shift;
+			ops_para->data_buf += ret * phydev->writesize;
+			readlen += (u64)ret << phydev->writesize_shift;
+			ret = 0;
+			if (readlen >= len)
+				break;
+			continue;
+		}
+
 		//printf("%s() page %x\n", __func__, ops_para->page_addr);
 		ret = operation->read_page(aml_chip);
 		if ((ops_para->ecc_err) || (ret < 0)) {
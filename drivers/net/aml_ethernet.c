@@ -75,6 +75,17 @@ static unsigned int  g_mdc_clock_range=ETH_MAC_4_GMII_Addr_CR_100_150;
 static int g_mac_mode = MAC_MODE_RGMII;
 
 static int g_debug = 0;
+
+/* Ring counters, see "ethstat" */
+static struct {
+	unsigned long rx_polls;		/* calls to aml_eth_rx() */
+	unsigned long rx_busy_polls;	/* calls that found frames */
+	unsigned long rx_frames;
+	unsigned long rx_errors;
+	unsigned long rx_max_batch;	/* most frames taken in one call */
+	unsigned long tx_frames;
+	unsigned long tx_ring_full;	/* sends that waited for a descriptor */
+} g_eth_stats;
 //#define ET_DEBUG
 /*
 M6TV
@@ -724,10 +735,16 @@ static void aml_eth_halt(struct eth_device * net_current)
 	return;
 }
 
+/*
+ * Queue a frame on the TX ring and return without waiting for it to go out;
+ * only a full ring makes us wait for the DMA. The descriptor buffers are
+ * allocated and mapped once in aml_ethernet_init().
+ */
 static int aml_eth_send(struct eth_device *net_current, void *packet, int length)
 {
 	unsigned int mask;
 	unsigned int status;
+	unsigned int tmo;
 
 	if (!g_nInitialized) {
 		return -1;
@@ -761,17 +778,19 @@ static int aml_eth_send(struct eth_device *net_current, void *packet, int length
 		goto err;
 	}
 
-	if (pTx->tdes0 & TDES0_OWN) {
-#if 1
-		volatile unsigned long Cdma, Dstatus, status;
-		Cdma = aml_eth_readl(ETH_DMA_18_Curr_Host_Tr_Descriptor);
-		Dstatus = aml_eth_readl(Cdma);
-		status = aml_eth_readl(ETH_DMA_5_Status);
-		printf("Current DMA=0x%x, Dstatus=0x%x\n", (unsigned int)Cdma, (unsigned int)Dstatus);
-		printf("Current status=0x%x\n", (unsigned int)status);
-		printf("no buffer to send\n");
-#endif
-		goto err;
+	/* ring full: wait for the DMA to finish the oldest frame */
+	if (pTx->tdes0 & TDES0_OWN)
+		g_eth_stats.tx_ring_full++;
+	for (tmo = 0; pTx->tdes0 & TDES0_OWN; tmo++) {
+		if (tmo >= 500000) {
+			GetDMAStatus(&mask, &status);
+			printf("Current DMA=0x%x, status=0x%x\n",
+			       (unsigned int)aml_eth_readl(ETH_DMA_18_Curr_Host_Tr_Descriptor), status);
+			printf("no buffer to send\n");
+			goto err;
+		}
+		udelay(1);
+		_dcache_inv_range_for_net((unsigned long)pTx, (unsigned long)(pTx + 1) - 1);
 	}
 
 	if (!(unsigned char*)(unsigned long)pTx->tdes2) {
@@ -779,7 +798,6 @@ static int aml_eth_send(struct eth_device *net_current, void *packet, int length
 	}
 	g_current_tx = (struct _tx_desc*)(unsigned long)pTx->tdes3;
 	memcpy((unsigned char*)(unsigned long)pTx->tdes2, (unsigned char*)packet, length);
-	//pTx->tdes1 &= DescEndOfRing;
 	_dcache_flush_range_for_net((unsigned long)pTx->tdes2, (unsigned long)pTx->tdes2 + length - 1);
 	pTx->tdes1 = ((length << TDES1_TBS1_P) & TDES1_TBS1_MASK) | TDES1_FS | TDES1_LS | TDES1_TCH | TDES1_IC;
 	pTx->tdes0 = TDES0_OWN;
@@ -792,35 +810,13 @@ static int aml_eth_send(struct eth_device *net_current, void *packet, int length
 		DMATXStart();
 	}
 
-#ifdef ET_DEBUG
-	printf("Transfer starting...\n");
-	GetDMAStatus(&mask, &status);
-	printf("Current status=%x\n", status);
-#endif
-
-	/* wait for transfer to succeed */
-	//unsigned tmo = get_timer (0) + 5 * CONFIG_SYS_HZ;		//5S time out
-	unsigned tmo = 0;
-	do {
-		udelay(100);
-		GetDMAStatus(&mask, &status);
-		if (tmo++ >= 50000) {
-			printf("\ntransmission error %#x\n", status);
-			break;
-		}
-	} while (!((status & ETH_DMA_5_Status_NIS) && (status & ETH_DMA_5_Status_TI)));
-
-	if (status & ETH_DMA_5_Status_NIS) {
-		if (status & ETH_DMA_5_Status_TI) {
-			aml_eth_writel(ETH_DMA_5_Status_NIS | ETH_DMA_5_Status_TI, ETH_DMA_5_Status);
-		}
-		if (status & ETH_DMA_5_Status_TU) {
-			aml_eth_writel(ETH_DMA_5_Status_NIS | ETH_DMA_5_Status_TU, ETH_DMA_5_Status);
-		}
-	}
+	/* ack frames sent so far; nothing waits on the flags */
+	if (status & (ETH_DMA_5_Status_TI | ETH_DMA_5_Status_TU))
+		aml_eth_writel(ETH_DMA_5_Status_NIS | ETH_DMA_5_Status_TI | ETH_DMA_5_Status_TU, ETH_DMA_5_Status);
+	g_eth_stats.tx_frames++;
 
 #ifdef ET_DEBUG
-	//test
+	printf("Transfer starting...\n");
 	GetDMAStatus(&mask, &status);
 	printf("Current status=%x\n", status);
 #endif
@@ -830,7 +826,9 @@ err:
 }
 
 /*
- * each time receive a whole packet
+ * Take every frame the DMA has finished with in one go. Frames are passed
+ * to NetReceive() straight from their DMA buffer, and the descriptor is
+ * only given back to the DMA once the stack is done with it.
  */
 static int aml_eth_rx(struct eth_device * net_current)
 {
@@ -839,6 +837,7 @@ static int aml_eth_rx(struct eth_device * net_current)
 	int rxnum = 0;
 	int len = 0;
 	struct _rx_desc* pRx;
+	unsigned char *buf;
 
 	if (!g_nInitialized) {
 		return -1;
@@ -846,40 +845,50 @@ static int aml_eth_rx(struct eth_device * net_current)
 
 	netdev_chk();
 
-	/* Check packet ready or not */
 	GetDMAStatus(&mask, &status);
-	if (!((status & ETH_DMA_5_Status_NIS) && (status & ETH_DMA_5_Status_RI))) {
-		return 0;
-	}
-	aml_eth_writel(ETH_DMA_5_Status_NIS | ETH_DMA_5_Status_RI, ETH_DMA_5_Status);	//clear the int flag
+	if (status & ETH_DMA_5_Status_RI)
+		aml_eth_writel(ETH_DMA_5_Status_NIS | ETH_DMA_5_Status_RI, ETH_DMA_5_Status);	//clear the int flag
 
 	if (!g_current_rx) {
 		g_current_rx = gS->rx;
 	}
 	pRx = g_current_rx;
 	_dcache_inv_range_for_net((unsigned long)pRx, (unsigned long)(pRx + 1) - 1);
-	while (!(pRx->rdes0 & RDES0_OWN)) {
+	while (!(pRx->rdes0 & RDES0_OWN) && rxnum < gS->rx_len) {
 		len = (pRx->rdes0 & RDES0_FL_MASK) >> RDES0_FL_P;
-		if (14 >= len) {
-			printf("err len=%d\n", len);
-			goto NEXT_BUF;
-		}
-		// pbuf_header(pb, -sizeof(short));
-		_dcache_inv_range_for_net((unsigned long)pRx->rdes2, (unsigned long)pRx->rdes2 + len - 1);
-
-		if (!memcpy((unsigned char*)NetRxPackets[0], (unsigned char*)(unsigned long)pRx->rdes2, len)) {
-			printf("memcp error\n");
-			goto NEXT_BUF;
+		buf = (unsigned char *)(unsigned long)pRx->rdes2;
+		if ((pRx->rdes0 & (RDES0_ES | RDES0_FS | RDES0_LS)) != (RDES0_FS | RDES0_LS) ||
+		    len <= 14 || len > gS->buffer_len) {
+			printf("err len=%d, rdes0=0x%x\n", len, pRx->rdes0);
+			g_eth_stats.rx_errors++;
+			len = 0;
+		} else {
+			_dcache_inv_range_for_net((unsigned long)buf, (unsigned long)buf + len - 1);
+			eth_rx_dump(buf, len);
+			NetReceive(buf, len);
+			/* the stack may reply in place (ARP) */
+			_dcache_flush_range_for_net((unsigned long)buf, (unsigned long)buf + len - 1);
 		}
-NEXT_BUF:
 		pRx->rdes0 = RDES0_OWN;
 		_dcache_flush_range_for_net((unsigned long)pRx, (unsigned long)(pRx + 1) - 1);
-		pRx = (struct _rx_desc*)(unsigned long)g_current_rx->rdes3;
+		pRx = (struct _rx_desc*)(unsigned long)pRx->rdes3;
 		_dcache_inv_range_for_net((unsigned long)pRx, (unsigned long)(pRx + 1) - 1);
-		g_current_rx = pRx;
 		rxnum++;
-		NetReceive(NetRxPackets[0], len);
-		eth_rx_dump((unsigned char *)NetRxPackets[0], len);
+	}
+	g_current_rx = pRx;
+
+	g_eth_stats.rx_polls++;
+	if (!rxnum)
+		return 0;
+	g_eth_stats.rx_busy_polls++;
+	g_eth_stats.rx_frames += rxnum;
+	if (rxnum > g_eth_stats.rx_max_batch)
+		g_eth_stats.rx_max_batch = rxnum;
+
+	/* the DMA stops when it runs out of descriptors; restart it */
+	if (status & ETH_DMA_5_Status_RU) {
+		aml_eth_writel(ETH_DMA_5_Status_AIS | ETH_DMA_5_Status_RU, ETH_DMA_5_Status);
+		aml_eth_writel(1, ETH_DMA_2_Re_Poll_Demand);
 	}
 
 	return len;
@@ -1331,6 +1340,28 @@ static int do_ethdbg(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	return 0;
 }
 
+static int do_ethstat(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	if (argc == 2 && !strcmp(argv[1], "reset")) {
+		memset(&g_eth_stats, 0, sizeof(g_eth_stats));
+		return 0;
+	}
+	if (argc != 1) {
+		return cmd_usage(cmdtp);
+	}
+
+	printf("rx: %lu frames, %lu errors, %lu of %lu polls busy, max %lu per poll",
+	       g_eth_stats.rx_frames, g_eth_stats.rx_errors,
+	       g_eth_stats.rx_busy_polls, g_eth_stats.rx_polls,
+	       g_eth_stats.rx_max_batch);
+	if (g_eth_stats.rx_busy_polls)
+		printf(", avg %lu", g_eth_stats.rx_frames / g_eth_stats.rx_busy_polls);
+	printf("\ntx: %lu frames, %lu waits for a free descriptor\n",
+	       g_eth_stats.tx_frames, g_eth_stats.tx_ring_full);
+
+	return 0;
+}
+
 static int  do_netspeed(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	int speed=100;
@@ -1491,3 +1522,9 @@ U_BOOT_CMD(
 		"       4         - ethernet TX/RX debug\n"
 	  );
 
+U_BOOT_CMD(
+		ethstat, 2, 1, do_ethstat,
+		"show ethernet ring counters",
+		"             - show rx/tx frame and poll counters\n"
+		"        reset        - clear the counters\n"
+	  );
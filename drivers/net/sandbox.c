@@ -0,0 +1,259 @@
+/*
+ * Sandbox Ethernet device
+ *
+ * Frames are exchanged with a peer on the host over UDP, one frame per
+ * datagram, or read from a pcap capture and fed to the network stack.
+ * Received frames can be held back and dropped on purpose, so transfer
+ * protocols can be measured under latency and loss.
+ *
+ *   --eth <ip>:<port>	peer that plays the network (see test/net/)
+ *   --eth_pcap <file>	replay an Ethernet capture instead; sent
+ *			frames are discarded
+ *
+ * Environment, read each time the device is brought up:
+ *   ethdelay		milliseconds each received frame is held back
+ *   ethloss		percentage of frames dropped in each direction
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <net.h>
+#include <netdev.h>
+#include <os.h>
+#include <asm/eth-udp-os.h>
+#include <asm/getopt.h>
+#include <asm/state.h>
+
+/* Received frames waiting out the delay */
+#define SBETH_QUEUE	128
+
+#define PCAP_MAGIC		0xa1b2c3d4
+#define PCAP_MAGIC_SWAPPED	0xd4c3b2a1
+#define PCAP_LINKTYPE_ETHERNET	1
+
+struct pcap_file_hdr {
+	u32 magic;
+	u16 version_major;
+	u16 version_minor;
+	s32 thiszone;
+	u32 sigfigs;
+	u32 snaplen;
+	u32 linktype;
+};
+
+struct pcap_rec_hdr {
+	u32 ts_sec;
+	u32 ts_usec;
+	u32 incl_len;
+	u32 orig_len;
+};
+
+struct sbeth_frame {
+	ulong due;		/* timer_get_us() when it may be delivered */
+	int len;
+	uchar data[PKTSIZE_ALIGN];
+};
+
+struct sbeth_priv {
+	struct eth_sandbox_udp_priv udp;
+	int pcap_fd;
+	int pcap_swapped;
+	ulong delay_us;
+	unsigned int loss;	/* percent */
+	u32 seed;
+	struct sbeth_frame queue[SBETH_QUEUE];
+	int head;
+	int count;
+};
+
+static int sandbox_cmdline_cb_eth(struct sandbox_state *state,
+				  const char *arg)
+{
+	state->eth_peer = arg;
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(eth, 1, "exchange eth frames with <ip>:<port> over UDP");
+
+static int sandbox_cmdline_cb_eth_pcap(struct sandbox_state *state,
+				       const char *arg)
+{
+	state->eth_pcap = arg;
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(eth_pcap, 1, "replay a pcap file as eth input");
+
+/* Deterministic, so a lossy run can be repeated exactly */
+static int sbeth_lose(struct sbeth_priv *priv)
+{
+	if (!priv->loss)
+		return 0;
+
+	priv->seed ^= priv->seed << 13;
+	priv->seed ^= priv->seed >> 17;
+	priv->seed ^= priv->seed << 5;
+
+	return priv->seed % 100 < priv->loss;
+}
+
+static int sbeth_pcap_open(struct sbeth_priv *priv, const char *fname)
+{
+	struct pcap_file_hdr hdr;
+
+	priv->pcap_fd = os_open(fname, OS_O_RDONLY);
+	if (priv->pcap_fd < 0) {
+		printf("sandbox eth: cannot open %s\n", fname);
+		return -1;
+	}
+	if (os_read(priv->pcap_fd, &hdr, sizeof(hdr)) != sizeof(hdr))
+		goto bad;
+
+	priv->pcap_swapped = hdr.magic == PCAP_MAGIC_SWAPPED;
+	if (hdr.magic != PCAP_MAGIC && !priv->pcap_swapped)
+		goto bad;
+	if (priv->pcap_swapped)
+		hdr.linktype = swab32(hdr.linktype);
+	if (hdr.linktype != PCAP_LINKTYPE_ETHERNET)
+		goto bad;
+
+	return 0;
+
+bad:
+	printf("sandbox eth: %s is not an Ethernet pcap file\n", fname);
+	os_close(priv->pcap_fd);
+	priv->pcap_fd = -1;
+	return -1;
+}
+
+/* Next frame of the capture, 0 at its end */
+static int sbeth_pcap_read(struct sbeth_priv *priv, uchar *buf)
+{
+	struct pcap_rec_hdr rec;
+	u32 len;
+
+	while (os_read(priv->pcap_fd, &rec, sizeof(rec)) == sizeof(rec)) {
+		len = priv->pcap_swapped ? swab32(rec.incl_len) : rec.incl_len;
+		if (len <= PKTSIZE_ALIGN)
+			return os_read(priv->pcap_fd, buf, len) == len ? len : 0;
+		/* truncated jumbo frames are of no use */
+		if (os_lseek(priv->pcap_fd, len, OS_SEEK_CUR) < 0)
+			break;
+	}
+
+	return 0;
+}
+
+static int sbeth_init(struct eth_device *dev, bd_t *bis)
+{
+	struct sbeth_priv *priv = dev->priv;
+	struct sandbox_state *state = state_get_current();
+
+	priv->delay_us = getenv_ulong("ethdelay", 10, 0) * 1000;
+	priv->loss = min(getenv_ulong("ethloss", 10, 0), 100UL);
+	priv->seed = 0x5eed;
+	priv->head = 0;
+	priv->count = 0;
+
+	if (state->eth_pcap)
+		return sbeth_pcap_open(priv, state->eth_pcap);
+	if (state->eth_peer)
+		return sandbox_eth_udp_os_init(state->eth_peer, &priv->udp);
+
+	puts("sandbox eth: no --eth or --eth_pcap given\n");
+	return -1;
+}
+
+static int sbeth_send(struct eth_device *dev, void *packet, int length)
+{
+	struct sbeth_priv *priv = dev->priv;
+
+	if (priv->pcap_fd >= 0 || sbeth_lose(priv))
+		return 0;
+
+	return sandbox_eth_udp_os_send(packet, length, &priv->udp);
+}
+
+/* Move frames from the host into the delay queue */
+static void sbeth_fill_queue(struct sbeth_priv *priv)
+{
+	struct sbeth_frame *frame;
+	int len;
+
+	while (priv->count < SBETH_QUEUE) {
+		frame = &priv->queue[(priv->head + priv->count) % SBETH_QUEUE];
+		if (priv->pcap_fd >= 0)
+			len = sbeth_pcap_read(priv, frame->data);
+		else
+			len = sandbox_eth_udp_os_recv(frame->data,
+						      sizeof(frame->data),
+						      &priv->udp);
+		if (len <= 0)
+			break;
+		if (sbeth_lose(priv))
+			continue;
+		frame->len = len;
+		frame->due = timer_get_us() + priv->delay_us;
+		priv->count++;
+	}
+}
+
+static int sbeth_recv(struct eth_device *dev)
+{
+	struct sbeth_priv *priv = dev->priv;
+	struct sbeth_frame *frame;
+
+	sbeth_fill_queue(priv);
+
+	while (priv->count) {
+		frame = &priv->queue[priv->head];
+		if ((long)(timer_get_us() - frame->due) < 0)
+			break;
+		priv->head = (priv->head + 1) % SBETH_QUEUE;
+		priv->count--;
+		NetReceive(frame->data, frame->len);
+	}
+
+	return 0;
+}
+
+static void sbeth_halt(struct eth_device *dev)
+{
+	struct sbeth_priv *priv = dev->priv;
+
+	if (priv->pcap_fd >= 0) {
+		os_close(priv->pcap_fd);
+		priv->pcap_fd = -1;
+	}
+	sandbox_eth_udp_os_halt(&priv->udp);
+}
+
+int sandbox_eth_initialize(bd_t *bis)
+{
+	struct eth_device *dev;
+	struct sbeth_priv *priv;
+	/* locally administered, used when ethaddr is not set */
+	static const uchar default_addr[6] = { 0x02, 0x00, 0x11, 0x22,
+					       0x33, 0x44 };
+
+	dev = calloc(1, sizeof(*dev));
+	priv = calloc(1, sizeof(*priv));
+	if (!dev || !priv) {
+		free(dev);
+		free(priv);
+		return -ENOMEM;
+	}
+	priv->udp.sd = -1;
+	priv->pcap_fd = -1;
+
+	strcpy(dev->name, "sbeth");
+	memcpy(dev->enetaddr, default_addr, sizeof(default_addr));
+	dev->init = sbeth_init;
+	dev->send = sbeth_send;
+	dev->recv = sbeth_recv;
+	dev->halt = sbeth_halt;
+	dev->priv = priv;
+
+	return eth_register(dev);
+}
@@ -64,6 +64,27 @@ static struct f_fastboot *fastboot_func;
 static unsigned int download_size;
 static unsigned int download_bytes;
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+#ifndef CONFIG_FASTBOOT_STREAM_SEG_SIZE
+#define CONFIG_FASTBOOT_STREAM_SEG_SIZE	0x800000
+#endif
+
+/*
+ * After "oem stream <partition>" downloads are written to that partition
+ * while they are received. Data cycles through two segments at the start
+ * of the download buffer: the writer starts an asynchronous block write
+ * of a full segment and returns, so the eMMC programs it by DMA while
+ * the other segment is received. Its write is only waited for once that
+ * segment is full in turn.
+ */
+static char stream_part[32];
+static unsigned int stream_max;		/* largest download accepted */
+static int stream_active;		/* current download is streamed */
+static int stream_error;		/* writer failed, drop the rest */
+static unsigned int stream_seg_bytes;	/* bytes in the current segment */
+static char stream_response[RESPONSE_LEN];
+#endif
+
 static struct usb_endpoint_descriptor fs_ep_in = {
 	.bLength            = USB_DT_ENDPOINT_SIZE,
 	.bDescriptorType    = USB_DT_ENDPOINT,
@@ -143,6 +164,15 @@ unsigned int ddr_size_usable(unsigned int addr_start)
 
 static void rx_handler_command(struct usb_ep *ep, struct usb_request *req);
 
+static unsigned int download_size_max(void)
+{
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	if (stream_part[0])
+		return stream_max;
+#endif
+	return ddr_size_usable(CONFIG_USB_FASTBOOT_BUF_ADDR);
+}
+
 static void fastboot_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	int status = req->status;
@@ -421,7 +451,7 @@ static void cb_getvar(struct usb_ep *ep, struct usb_request *req)
 		!strcmp_l1("max-download-size", cmd)) {
 		char str_num[12];
 
-		sprintf(str_num, "0x%08x", ddr_size_usable(CONFIG_USB_FASTBOOT_BUF_ADDR));
+		sprintf(str_num, "0x%08x", download_size_max());
 		strncat(response, str_num, chars_left);
 	} else if (!strcmp_l1("serialno", cmd)) {
 		//s = getenv("serial");
@@ -476,14 +506,45 @@ static void cb_getvar(struct usb_ep *ep, struct usb_request *req)
 
 static unsigned int rx_bytes_expected(void)
 {
-	int rx_remain = download_size - download_bytes;
-	if (rx_remain < 0)
+	unsigned int rx_remain;
+
+	/* Streamed downloads may be larger than 2 GiB */
+	if (download_bytes >= download_size)
 		return 0;
+	rx_remain = download_size - download_bytes;
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	/* Never let one transfer straddle two segments */
+	if (stream_active) {
+		unsigned int seg_room = CONFIG_FASTBOOT_STREAM_SEG_SIZE -
+			stream_seg_bytes % CONFIG_FASTBOOT_STREAM_SEG_SIZE;
+
+		if (rx_remain > seg_room)
+			rx_remain = seg_room;
+	}
+#endif
 	if (rx_remain > EP_BUFFER_SIZE)
 		return EP_BUFFER_SIZE;
 	return rx_remain;
 }
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+static void *stream_seg_addr(unsigned int offset)
+{
+	offset %= 2 * CONFIG_FASTBOOT_STREAM_SEG_SIZE;
+	return (void *)CONFIG_USB_FASTBOOT_BUF_ADDR + offset;
+}
+
+/* Hand the segment that was just completed to the writer */
+static void stream_flush_seg(void)
+{
+	void *seg = stream_seg_addr(download_bytes - stream_seg_bytes);
+
+	if (!stream_error && fb_mmc_stream_write(seg, stream_seg_bytes))
+		stream_error = 1;
+	stream_seg_bytes = 0;
+}
+#endif
+
 #define BYTES_PER_DOT	0x20000
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
@@ -501,6 +562,14 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	if (buffer_size < transfer_size)
 		transfer_size = buffer_size;
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	if (stream_active) {
+		memcpy(stream_seg_addr(download_bytes), buffer, transfer_size);
+		stream_seg_bytes += transfer_size;
+		/* keep the write of the other segment going */
+		fb_mmc_stream_poll();
+	} else
+#endif
 	memcpy((void *)CONFIG_USB_FASTBOOT_BUF_ADDR + download_bytes,
 	       buffer, transfer_size);
 
@@ -525,6 +594,15 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 		req->length = EP_BUFFER_SIZE;
 
 		sprintf(response, "OKAY");
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+		if (stream_active) {
+			stream_flush_seg();
+			if (!stream_error)
+				stream_error = fb_mmc_stream_finish();
+			if (stream_error)
+				strcpy(response, stream_response);
+		}
+#endif
 		fastboot_tx_write_str(response);
 
 		printf("\ndownloading of %d bytes finished\n", download_bytes);
@@ -536,6 +614,12 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 
 	req->actual = 0;
 	usb_ep_queue(ep, req, 0);
+
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	/* The next segment is already being received */
+	if (stream_active && stream_seg_bytes == CONFIG_FASTBOOT_STREAM_SEG_SIZE)
+		stream_flush_seg();
+#endif
 }
 
 static void cb_download(struct usb_ep *ep, struct usb_request *req)
@@ -553,10 +637,17 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 
 	if (0 == download_size) {
 		sprintf(response, "FAILdata invalid size");
-	} else if (download_size > ddr_size_usable(CONFIG_USB_FASTBOOT_BUF_ADDR)) {
+	} else if (download_size > download_size_max()) {
 		download_size = 0;
 		sprintf(response, "FAILdata too large");
 	} else {
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+		stream_active = stream_part[0] != '\0';
+		stream_error = 0;
+		stream_seg_bytes = 0;
+		if (stream_active)
+			fb_mmc_stream_start(stream_response);
+#endif
 		sprintf(response, "DATA%08x", download_size);
 		req->complete = rx_handler_dl_image;
 		req->length = rx_bytes_expected();
@@ -612,6 +703,20 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 		return;
 	}
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	/* The image was already written while it was downloaded */
+	if (stream_part[0]) {
+		if (strcmp(cmd, stream_part))
+			fastboot_tx_write_str("FAILstreaming to other partition");
+		else if (!stream_active)
+			fastboot_tx_write_str("FAILno image streamed");
+		else
+			fastboot_tx_write_str(stream_response);
+		stream_active = 0;
+		return;
+	}
+#endif
+
 	//strcpy(response, "FAILno flash device defined");
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
 	fb_mmc_flash_write(cmd, (void *)CONFIG_USB_FASTBOOT_BUF_ADDR,
@@ -622,6 +727,40 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 }
 #endif
 
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+/*
+ * "oem stream <partition>" makes the following downloads go straight to
+ * <partition>, "oem stream" alone goes back to buffering in DDR.
+ */
+static void cb_oem_stream(struct usb_ep *ep, struct usb_request *req)
+{
+	char *cmd = req->buf;
+	char response[RESPONSE_LEN];
+	u64 size;
+
+	printf("cmd is %s\n", cmd);
+
+	cmd += strlen("oem stream");
+	while (*cmd == ':' || *cmd == ' ')
+		cmd++;
+	stream_part[0] = '\0';
+	stream_active = 0;
+	if (!*cmd) {
+		fastboot_tx_write_str("OKAY");
+		return;
+	}
+
+	size = fb_mmc_stream_open(cmd, response);
+	if (size) {
+		strncpy(stream_part, cmd, sizeof(stream_part) - 1);
+		stream_part[sizeof(stream_part) - 1] = '\0';
+		/* Downloads are limited by the protocol's 32 bit size */
+		stream_max = min_t(u64, size, 0xffffffff);
+	}
+	fastboot_tx_write_str(response);
+}
+#endif
+
 static void cb_set_active(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmd = req->buf;
@@ -723,6 +862,12 @@ static const struct cmd_dispatch_info cmd_dispatch_info[] = {
 		.cmd = "flash",
 		.cb = cb_flash,
 	},
+#endif
+#ifdef CONFIG_FASTBOOT_FLASH_STREAM
+	{
+		.cmd = "oem stream",
+		.cb = cb_oem_stream,
+	},
 #endif
 	{
 		.cmd = "update",
@@ -15,6 +15,10 @@
 #include <asm/arch/secure_apb.h>
 #include <asm/arch/bl31_apis.h>
 #include <asm/io.h>
+#include <mmc.h>
+#include <emmc_partitions.h>
+
+extern int find_dev_num_by_partition_name (char *name);
 
 extern unsigned int get_multi_dt_entry(unsigned long fdt_addr);
 int is_optimus_storage_inited(void);
@@ -244,6 +248,63 @@ u32 optimus_cb_simg_write_media(const unsigned destAddrInSec, const unsigned dat
     return dataSzInBy;
 }
 
+//Erase unit of current partition in sectors, 0 if zero fills can't be erased
+//Only eMMC with partition offset aligned to erase group, and erasing to zeros, supported now
+unsigned optimus_cb_simg_erase_unit(void)
+{
+#ifdef CONFIG_AML_SD_EMMC
+    char* partName = (char*)OptimusImgBurnInfo.partName;
+    struct partitions* part = NULL;
+    struct mmc* mmc = NULL;
+
+    if (EMMC_BOOT_FLAG != device_boot_flag && SPI_EMMC_FLAG != device_boot_flag) return 0;
+
+    part = find_mmc_partition_by_name(partName);
+    mmc  = find_mmc_device(find_dev_num_by_partition_name(partName));
+    if (!part || !mmc || !mmc->erase_grp_size) return 0;
+    if (!mmc->erased_zero) return 0;//erased blocks read back 0xff, zeros must be written
+    if ((part->offset >> 9) % mmc->erase_grp_size) return 0;
+
+    return mmc->erase_grp_size;
+#else
+    return 0;
+#endif//#ifdef CONFIG_AML_SD_EMMC
+}
+
+//erase @sizeInSec sectors from @destAddrInSec of current partition, both aligned to optimus_cb_simg_erase_unit()
+//return 0 if ok
+int optimus_cb_simg_erase_media(const unsigned destAddrInSec, const unsigned sizeInSec)
+{
+#ifdef CONFIG_AML_SD_EMMC
+    char* partName = (char*)OptimusImgBurnInfo.partName;
+    struct partitions* part = find_mmc_partition_by_name(partName);
+    struct mmc* mmc = find_mmc_device(find_dev_num_by_partition_name(partName));
+    const unsigned long partOffInSec = part ? (unsigned long)(part->offset >> 9) : 0;
+    int ret = 0;
+
+    if (!part || !mmc) {
+        DWN_ERR("Fail to find mmc for part %s\n", partName);
+        return __LINE__;
+    }
+    if (((u64)destAddrInSec + sizeInSec) << 9 > part->size) {
+        DWN_ERR("erase range 0x%x+0x%x sectors exceed part %s\n", destAddrInSec, sizeInSec, partName);
+        return __LINE__;
+    }
+
+    DWN_DBG("erase 0x%x sectors at 0x%lx\n", sizeInSec, partOffInSec + destAddrInSec);
+    ret = mmc_erase_groups(mmc, partOffInSec + destAddrInSec, sizeInSec, MMC_ERASE_ARG);
+    if (ret) {
+        DWN_ERR("Fail to erase media, ret = %d\n", ret);
+        return __LINE__;
+    }
+    platform_busy_increase_un_reported_size(sizeInSec << 9);
+
+    return 0;
+#else
+    return __LINE__;
+#endif//#ifdef CONFIG_AML_SD_EMMC
+}
+
 //return value: the data size disposed
 static u32 optimus_download_sparse_image(struct ImgBurnInfo* pDownInfo, u32 dataSz, const u8* data)
 {
@@ -135,6 +135,8 @@ unsigned v2_key_burn(const char* keyName, const u8* keyVal, const unsigned keyVa
 int optimus_simg_probe(const u8* source, const u32 length);
 int optimus_simg_parser_init(const u8* source);
 u32 optimus_cb_simg_write_media(const unsigned destAddrInSec, const unsigned dataSzInBy, const char* data);
+unsigned optimus_cb_simg_erase_unit(void);
+int optimus_cb_simg_erase_media(const unsigned destAddrInSec, const unsigned sizeInSec);
 int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedDataLen, const u32 flashAddrInSec);
 int optimus_sparse_get_chunk_data(u8** head, u32* headSz, u32* dataSz, u64* dataOffset);
 int optimus_sparse_back_info_probe(void);
@@ -43,8 +43,180 @@ static struct
     u32      backChunkNum;      //chunk number backed
     u64      chunkOffset;
 
+    //adjacent FILL chunks of same value are merged and written once, flushed when the run ends
+    u32      pendFillAddr;      //flash start Addr of pending FILL run, in sector
+    u32      pendFillSecs;      //length of pending FILL run, in sector, 0 if none
+    u32      pendFillVal;
+
+    //adjacent RAW chunks are moved together in the packet buffer and written once, flushed before the packet is returned
+    char*    rawRunBuf;
+    u32      rawRunAddr;        //flash start Addr of pending RAW run, in sector
+    u32      rawRunLen;         //length of pending RAW run, in byte, 0 if none
+
 }_spPacketStates;
 
+//write @fillVal pattern to [flashAddr, flashAddr + nSec)
+static int _simg_fill_pattern(u32 flashAddr, u32 nSec, const unsigned fillVal)
+{
+    unsigned* pFillValBuf = (unsigned*)OPTIMUS_SPARSE_IMG_FILL_VAL_BUF;
+    const unsigned FillBufSz = OPTIMUS_SPARSE_IMG_FILL_BUF_SZ;
+    static unsigned _filledBufValidLen = 0;
+    const unsigned thisFilledLen = ((u64)nSec << 9) > FillBufSz ? FillBufSz : (nSec << 9);
+
+    if (fillVal != *pFillValBuf && _filledBufValidLen) {
+        _filledBufValidLen = 0;
+    }
+    if (_filledBufValidLen < thisFilledLen) {
+        int i = _filledBufValidLen>>2;
+        unsigned* temBuf = pFillValBuf + i;
+
+        while (i++ < (thisFilledLen>>2)) *temBuf++ = fillVal;
+        _filledBufValidLen = thisFilledLen;
+    }
+
+    while (nSec)
+    {
+        const unsigned thisWriteLen = ((u64)nSec << 9) > thisFilledLen ? thisFilledLen : (nSec << 9);
+        unsigned actualWrLen = 0;
+
+        actualWrLen = optimus_cb_simg_write_media(flashAddr, thisWriteLen, (char*)pFillValBuf);
+        if (actualWrLen != thisWriteLen) {
+            sperr("FILL_CHUNK:Want write 0x%x Bytes, but 0x%x\n", thisWriteLen, actualWrLen);
+            return -__LINE__;
+        }
+
+        flashAddr += thisWriteLen >> 9;
+        nSec      -= thisWriteLen >> 9;
+    }
+
+    return 0;
+}
+
+//write the pending FILL run, erase instead of writing zeros for the part aligned to erase unit
+static int _simg_flush_fill(void)
+{
+    u32 flashAddr = _spPacketStates.pendFillAddr;
+    u32 nSec      = _spPacketStates.pendFillSecs;
+    const unsigned fillVal = _spPacketStates.pendFillVal;
+    const unsigned eraseUnit = fillVal ? 0 : optimus_cb_simg_erase_unit();
+    int ret = 0;
+
+    if (!nSec) return 0;
+    _spPacketStates.pendFillSecs = 0;
+    DWN_DBG("CHUNK_TYPE_FILL 0x%x, 0x%x sectors at 0x%x\n", fillVal, nSec, flashAddr);
+
+    if (eraseUnit)
+    {
+        const u32 eraseStart = (flashAddr + eraseUnit - 1) / eraseUnit * eraseUnit;
+        const u32 eraseEnd   = (flashAddr + nSec) / eraseUnit * eraseUnit;
+
+        if (eraseEnd > eraseStart)
+        {
+            ret = _simg_fill_pattern(flashAddr, eraseStart - flashAddr, fillVal);
+            if (ret) return ret;
+
+            ret = optimus_cb_simg_erase_media(eraseStart, eraseEnd - eraseStart);
+            if (ret) {
+                sperr("FILL_CHUNK:Fail to erase 0x%x sectors at 0x%x\n", eraseEnd - eraseStart, eraseStart);
+                return -__LINE__;
+            }
+
+            nSec     -= eraseEnd - flashAddr;
+            flashAddr = eraseEnd;
+        }
+    }
+
+    return _simg_fill_pattern(flashAddr, nSec, fillVal);
+}
+
+//queue a FILL chunk, return <0 if fail to flush previous run
+static int _simg_queue_fill(const u32 flashAddr, const u32 nSec, const unsigned fillVal)
+{
+    int _NeedFillAsNotErasedYet = 0;
+    int ret = 0;
+
+    switch (device_boot_flag) {
+        case EMMC_BOOT_FLAG:
+        case SPI_EMMC_FLAG:
+            _NeedFillAsNotErasedYet = (fillVal != 0);
+            break;
+
+        case NAND_BOOT_FLAG:
+        case SPI_NAND_FLAG:
+            _NeedFillAsNotErasedYet = (fillVal != 0XFFFFFFFFU);
+            break;
+        default:
+            _NeedFillAsNotErasedYet = 1;
+            break;
+    }
+    //for, emmc, if fillVal is 0, then _NeedFillAsNotErasedYet = false if "disk_inital > 0"
+    if (!_NeedFillAsNotErasedYet)_NeedFillAsNotErasedYet = (is_optimus_storage_inited()>>16) == 0;// == 0 means 'disk_inital 0'
+    if (!_NeedFillAsNotErasedYet) return 0;
+
+    if (_spPacketStates.pendFillSecs && fillVal == _spPacketStates.pendFillVal
+            && _spPacketStates.pendFillAddr + _spPacketStates.pendFillSecs == flashAddr)
+    {
+        _spPacketStates.pendFillSecs += nSec;
+        return 0;
+    }
+
+    ret = _simg_flush_fill();
+    _spPacketStates.pendFillAddr = flashAddr;
+    _spPacketStates.pendFillSecs = nSec;
+    _spPacketStates.pendFillVal  = fillVal;
+
+    return ret;
+}
+
+//write the pending RAW run
+static int _simg_flush_raw(void)
+{
+    const unsigned wantWrLen = _spPacketStates.rawRunLen;
+    unsigned thisWriteLen = 0;
+
+    if (!wantWrLen) return 0;
+    _spPacketStates.rawRunLen = 0;
+
+    thisWriteLen = optimus_cb_simg_write_media(_spPacketStates.rawRunAddr, wantWrLen, _spPacketStates.rawRunBuf);
+    if (thisWriteLen != wantWrLen) {
+        sperr("Fail to write to flash, want to write %dB, but %dB\n", wantWrLen, thisWriteLen);
+        return -__LINE__;
+    }
+
+    return 0;
+}
+
+//queue RAW data of a chunk, return <0 if fail to flush previous run
+//Only parsed chunk headers lie between the pending run and @data when they are adjacent in flash,
+//so the shorter of the two is moved over them to make the run contiguous in the packet buffer
+static int _simg_queue_raw(const u32 flashAddr, char* data, const u32 dataLen)
+{
+    const u32 runLen = _spPacketStates.rawRunLen;
+    int ret = 0;
+
+    if (!dataLen) return 0;
+
+    if (runLen && _spPacketStates.rawRunAddr + (runLen >> 9) == flashAddr)
+    {
+        if (runLen <= dataLen) {
+            memmove(data - runLen, _spPacketStates.rawRunBuf, runLen);
+            _spPacketStates.rawRunBuf = data - runLen;
+        }
+        else {
+            memmove(_spPacketStates.rawRunBuf + runLen, data, dataLen);
+        }
+        _spPacketStates.rawRunLen += dataLen;
+        return 0;
+    }
+
+    ret = _simg_flush_raw();
+    _spPacketStates.rawRunBuf  = data;
+    _spPacketStates.rawRunAddr = flashAddr;
+    _spPacketStates.rawRunLen  = dataLen;
+
+    return ret;
+}
+
 //0 is not sparse packet header, else is sparse packet_header
 int optimus_simg_probe(const u8* source, const u32 length)
 {
@@ -113,7 +285,6 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
         //const chunk_header_t* pLastLongChunk = backChunkHead - 1;////
         //const unsigned leftLongChunk_dataLen = pLastLongChunk->total_sz;
         const unsigned leftLongChunk_flashAddr = _spPacketStates.nextFlashAddr4LastLongChunk;
-        unsigned writeLen = 0;
         unsigned thisWriteLen = 0;
 
         thisWriteLen = notWrBackSz4LongChunk >= pktLen ? pktLen : notWrBackSz4LongChunk;
@@ -125,9 +296,8 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
         }
         spmsg("notWrBackSz4LongChunk 0x%08x, thisWriteLen 0x%08x, flashAddr 0x%08xSec\n", notWrBackSz4LongChunk, thisWriteLen, leftLongChunk_flashAddr);
 
-        writeLen = optimus_cb_simg_write_media(leftLongChunk_flashAddr, thisWriteLen, simgPktHead);
-        if (thisWriteLen != writeLen) {
-            sperr("Want to write left chunk sz 0x%x, but only 0x%x\n", thisWriteLen, writeLen);
+        //start the RAW run with the rest of the long chunk, following RAW chunks are merged into it
+        if (_simg_queue_raw(leftLongChunk_flashAddr, simgPktHead, thisWriteLen)) {
             return -__LINE__;
         }
 
@@ -137,6 +307,9 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
         if (notWrBackSz4LongChunk >= pktLen) //packet data ended
         {
             _spPacketStates.nextFlashAddr4LastLongChunk += thisWriteLen>>9;//address needed next write time
+            if (_simg_flush_raw()) {
+                return -__LINE__;
+            }
             *unParsedDataLen = unParsedBufLen;
             return 0;//the long chunk not disposed all yet!
         }
@@ -150,12 +323,14 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
     {
         //chunk data for ext4, but maybe empty in sparse, that is why called sparse format
         const unsigned chunkDataLen = pChunk->chunk_sz * _spPacketStates.sparseBlkSz;
+        const unsigned chunkTotalSz = pChunk->total_sz;
         unsigned thisWriteLen = 0;
 
         if (CHUNK_HEAD_SIZE > unParsedBufLen) {//total size not enough for CHUNK_HEAD_SIZE yet!!
             spmsg("unParsedBufLen 0x%x < head sz 0x%zx\n", unParsedBufLen, CHUNK_HEAD_SIZE);
             break;
         }
+        memcpy(backChunkHead, pChunk, CHUNK_HEAD_SIZE);//back up verify chunk info, merging RAW run may move data over the header
 
         switch (pChunk->chunk_type)
         {
@@ -180,14 +355,11 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
                             unParseChunkDataLen, chunkDataLen, wantWrLen, _spPacketStates.notWrBackSz4LongChunk);
                 }
 
-                if (wantWrLen)
-                {
-                    thisWriteLen = optimus_cb_simg_write_media(flashAddrStart, wantWrLen, (char*)pChunk + CHUNK_HEAD_SIZE);
-                    if (thisWriteLen != wantWrLen) {
-                        sperr("Fail to write to flash, want to write %dB, but %dB\n", wantWrLen, thisWriteLen);
-                        return -__LINE__;
-                    }
+                //merged run keeps the 64K aligned size of a long chunk part, the rest is written with next packet
+                if (_simg_queue_raw(flashAddrStart, (char*)pChunk + CHUNK_HEAD_SIZE, wantWrLen)) {
+                    return -__LINE__;
                 }
+                thisWriteLen = wantWrLen;
             }
             break;
 
@@ -204,71 +376,21 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
 
         case CHUNK_TYPE_FILL:
             {
-                    const unsigned fillVal = *(unsigned*)(pChunk + 1);
-                    unsigned LeftDataLen   = chunkDataLen;
-                    unsigned temp_flashAddrStart = flashAddrStart;
-                    unsigned* pFillValBuf = (unsigned*)OPTIMUS_SPARSE_IMG_FILL_VAL_BUF;
-                    const unsigned FillBufSz = OPTIMUS_SPARSE_IMG_FILL_BUF_SZ;
-                    static unsigned _filledBufValidLen = 0;
-                    const unsigned thisChunkFilledLen = min(chunkDataLen, FillBufSz);
-                    int _NeedFillAsNotErasedYet = 0;
-
-                    spdbg("CHUNK_TYPE_FILL,fillVal=0x%8x, chunkDataLen=0x%8x, thisChunkFilledLen=0x%x\n",
-                                    fillVal, chunkDataLen, thisChunkFilledLen);
-                    if (CHUNK_HEAD_SIZE + 4 != pChunk->total_sz) {
-                            sperr("error FILL chunk\n");
-                            return -__LINE__;
-                    }
-                    switch (device_boot_flag) {
-                            case EMMC_BOOT_FLAG:
-                            case SPI_EMMC_FLAG:
-                                    _NeedFillAsNotErasedYet = (fillVal != 0);
-                                    break;
-
-                            case NAND_BOOT_FLAG:
-                            case SPI_NAND_FLAG:
-                                    _NeedFillAsNotErasedYet = (fillVal != 0XFFFFFFFFU);
-                                    break;
-                            default:
-                                    _NeedFillAsNotErasedYet = 1;
-                                    break;
-                    }
-                    //for, emmc, if fillVal is 0, then _NeedFillAsNotErasedYet = false if "disk_inital > 0"
-                    if (!_NeedFillAsNotErasedYet)_NeedFillAsNotErasedYet = (is_optimus_storage_inited()>>16) == 0;// == 0 means 'disk_inital 0'
-
-                    if (_NeedFillAsNotErasedYet)
-                    {
-                            if (!_filledBufValidLen) {
-                                    DWN_MSG("CHUNK_TYPE_FILL\n");
-                            }
-                            if (fillVal != *pFillValBuf && _filledBufValidLen) {
-                                    _filledBufValidLen = 0;
-                            }
-                            if (_filledBufValidLen < thisChunkFilledLen) {
-                                    int i = _filledBufValidLen>>2;
-                                    unsigned* temBuf = pFillValBuf + i;
-
-                                    while (i++ < (thisChunkFilledLen>>2)) *temBuf++ = fillVal;
-                                    _filledBufValidLen = thisChunkFilledLen;
-                            }
-
-                            DWN_DBG("LeftDataLen to fill:0x%x\n", LeftDataLen);
-                            do {
-                                    unsigned actualWrLen = 0;
-
-                                    thisWriteLen = min(LeftDataLen, thisChunkFilledLen);
-
-                                    actualWrLen = optimus_cb_simg_write_media(temp_flashAddrStart, thisWriteLen, (char*)pFillValBuf);
-                                    if (actualWrLen != thisWriteLen) {
-                                            sperr("FILL_CHUNK:Want write 0x%x Bytes, but 0x%x\n", thisWriteLen, actualWrLen);
-                                            break;
-                                    }
-
-                                    temp_flashAddrStart += thisWriteLen >> 9;
-                                    LeftDataLen -= thisWriteLen;
-                            }while(LeftDataLen);
-                    }
-                    thisWriteLen = 4;///////////
+                const unsigned fillVal = *(unsigned*)(pChunk + 1);
+
+                spdbg("CHUNK_TYPE_FILL,fillVal=0x%8x, chunkDataLen=0x%8x\n", fillVal, chunkDataLen);
+                if (CHUNK_HEAD_SIZE + 4 != pChunk->total_sz) {
+                    sperr("error FILL chunk\n");
+                    return -__LINE__;
+                }
+                if (CHUNK_HEAD_SIZE + 4 > unParsedBufLen) {//fill value not received yet
+                    spmsg("unParsedBufLen 0x%x < fill chunk sz\n", unParsedBufLen);
+                    goto _parse_end;
+                }
+                if (_simg_queue_fill(flashAddrStart, chunkDataLen >> 9, fillVal)) {
+                    return -__LINE__;
+                }
+                thisWriteLen = 4;
             }
             break;
         case CHUNK_TYPE_CRC32:
@@ -282,14 +404,22 @@ int optimus_simg_to_media(char* simgPktHead, const u32 pktLen, u32* unParsedData
         /////update for next chunk
         unParsedBufLen                  -= CHUNK_HEAD_SIZE + thisWriteLen;
         flashAddrStart                  += chunkDataLen>>9;
-        memcpy(backChunkHead, pChunk, CHUNK_HEAD_SIZE);//back up verify chunk info
         spdbg("index %d ,tp 0x%x\n", _spPacketStates.backChunkNum, backChunkHead->chunk_type);
         ++_spPacketStates.backChunkNum;
         ++backChunkHead;
 
-        pChunk                           =  (chunk_header_t*)((u64)pChunk + pChunk->total_sz);
+        pChunk                           =  (chunk_header_t*)((u64)pChunk + chunkTotalSz);
     }
 
+_parse_end:
+    //packet buffer is reused after return, so write back the RAW run now
+    if (_simg_flush_raw()) {
+        return -__LINE__;
+    }
+    //all chunks parsed, so write back the last FILL run
+    if (!_spPacketStates.leftChunkNum && _simg_flush_fill()) {
+        return -__LINE__;
+    }
     spmsg("leftChunkNum %d, bak num %d\n", _spPacketStates.leftChunkNum, _spPacketStates.backChunkNum);
 
     _spPacketStates.pktHeadLen      = 0;//>0 only when first time
@@ -81,28 +81,22 @@ void put_ext4(uint64_t off, void *buf, uint32_t size)
 
 	if (remainder) {
 		if (fs->dev_desc->block_read) {
-			fs->dev_desc->block_read(fs->dev_desc->dev,
-						 startblock, 1, sec_buf);
+			blk_dread(fs->dev_desc, startblock, 1, sec_buf);
 			temp_ptr = sec_buf;
 			memcpy((temp_ptr + remainder),
 			       (unsigned char *)buf, size);
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock, 1, sec_buf);
+			blk_dwrite(fs->dev_desc, startblock, 1, sec_buf);
 		}
 	} else {
 		if (size >> log2blksz != 0) {
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock,
-						  size >> log2blksz,
-						  (unsigned long *)buf);
+			blk_dwrite(fs->dev_desc, startblock,
+				   size >> log2blksz, (unsigned long *)buf);
 		} else {
-			fs->dev_desc->block_read(fs->dev_desc->dev,
-						 startblock, 1, sec_buf);
+			blk_dread(fs->dev_desc, startblock, 1, sec_buf);
 			temp_ptr = sec_buf;
 			memcpy(temp_ptr, buf, size);
-			fs->dev_desc->block_write(fs->dev_desc->dev,
-						  startblock, 1,
-						  (unsigned long *)sec_buf);
+			blk_dwrite(fs->dev_desc, startblock, 1,
+				   (unsigned long *)sec_buf);
 		}
 	}
 }
@@ -1840,6 +1834,171 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	return blknr;
 }
 
+/*
+ * Decoded extent runs of the file currently being read. ext4fs_read_file()
+ * maps a whole physically contiguous run per lookup instead of walking the
+ * extent tree again for every logical block.
+ */
+#ifndef CONFIG_EXT4_EXTENT_CACHE_RUNS
+#define CONFIG_EXT4_EXTENT_CACHE_RUNS	512
+#endif
+
+struct ext4_extent_run {
+	uint32_t lblk;
+	uint32_t len;
+	uint64_t pblk;
+};
+
+struct ext4_extent_cache {
+	struct ext2_data *data;
+	int ino;
+	int nr_runs;
+	int last;
+	struct ext4_extent_run run[CONFIG_EXT4_EXTENT_CACHE_RUNS];
+};
+
+static struct ext4_extent_cache *ext4fs_extent_cache;
+
+static void ext4fs_extent_cache_reset(struct ext2fs_node *node)
+{
+	ext4fs_extent_cache->data = node->data;
+	ext4fs_extent_cache->ino = node->ino;
+	ext4fs_extent_cache->nr_runs = 0;
+	ext4fs_extent_cache->last = 0;
+}
+
+static struct ext4_extent_run *ext4fs_extent_cache_lookup(uint32_t fileblock)
+{
+	struct ext4_extent_cache *cache = ext4fs_extent_cache;
+	struct ext4_extent_run *run;
+	int i, n;
+
+	/* Sequential reads hit the last used run or the one after it */
+	for (n = 0, i = cache->last; n < cache->nr_runs; n++) {
+		run = &cache->run[i];
+		if (fileblock >= run->lblk && fileblock - run->lblk < run->len) {
+			cache->last = i;
+			return run;
+		}
+		if (++i == cache->nr_runs)
+			i = 0;
+	}
+
+	return NULL;
+}
+
+/**
+ * ext4fs_read_extent_run() - Map a run of file blocks to disk blocks
+ *
+ * @node:	File being read
+ * @fileblock:	First logical block of the run
+ * @blknr:	Returns the first filesystem block of the run, 0 for a hole
+ * @count:	Returns the number of logical blocks mapped contiguously
+ * @return 0 on success, -ve on error
+ */
+int ext4fs_read_extent_run(struct ext2fs_node *node, uint32_t fileblock,
+			   uint64_t *blknr, uint32_t *count)
+{
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent_run *run;
+	struct ext4_extent *extent;
+	int log2_blksz;
+	int entries;
+	int i;
+	char *buf;
+
+	if (!(le32_to_cpu(node->inode.flags) & EXT4_EXTENTS_FL)) {
+		long int ret = read_allocated_block(&node->inode, fileblock);
+
+		if (ret < 0)
+			return -1;
+		*blknr = ret;
+		*count = 1;
+		return 0;
+	}
+
+	if (!ext4fs_extent_cache) {
+		ext4fs_extent_cache = malloc(sizeof(*ext4fs_extent_cache));
+		if (!ext4fs_extent_cache)
+			return -ENOMEM;
+		ext4fs_extent_cache_reset(node);
+	}
+	if (ext4fs_extent_cache->data != node->data ||
+	    ext4fs_extent_cache->ino != node->ino)
+		ext4fs_extent_cache_reset(node);
+
+	run = ext4fs_extent_cache_lookup(fileblock);
+	if (run) {
+		*blknr = run->pblk + (fileblock - run->lblk);
+		*count = run->len - (fileblock - run->lblk);
+		return 0;
+	}
+
+	/* Miss: decode the whole leaf covering fileblock into the cache */
+	buf = zalloc(EXT2_BLOCK_SIZE(node->data));
+	if (!buf)
+		return -ENOMEM;
+	log2_blksz = LOG2_BLOCK_SIZE(node->data) - get_fs()->dev_desc->log2blksz;
+	ext_block = ext4fs_get_extent_block(node->data, buf,
+					    (struct ext4_extent_header *)
+					    node->inode.b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		free(buf);
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+	entries = le16_to_cpu(ext_block->eh_entries);
+
+	/*
+	 * A leaf whose first extent is already cached was decoded before,
+	 * so fileblock lies in a hole; otherwise append all its runs.
+	 */
+	if (entries && !ext4fs_extent_cache_lookup(
+				le32_to_cpu(extent[0].ee_block))) {
+		if (ext4fs_extent_cache->nr_runs + entries >
+		    CONFIG_EXT4_EXTENT_CACHE_RUNS)
+			ext4fs_extent_cache_reset(node);
+		for (i = 0; i < entries &&
+		     ext4fs_extent_cache->nr_runs <
+		     CONFIG_EXT4_EXTENT_CACHE_RUNS; i++) {
+			run = &ext4fs_extent_cache->run[
+					ext4fs_extent_cache->nr_runs++];
+			run->lblk = le32_to_cpu(extent[i].ee_block);
+			run->len = le16_to_cpu(extent[i].ee_len);
+			run->pblk = le16_to_cpu(extent[i].ee_start_hi);
+			run->pblk = (run->pblk << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+		}
+	}
+
+	/* A hole ends at the next extent of this leaf, if there is one */
+	*blknr = 0;
+	*count = 1;
+	for (i = 0; i < entries; i++) {
+		uint32_t start = le32_to_cpu(extent[i].ee_block);
+		uint32_t len = le16_to_cpu(extent[i].ee_len);
+
+		if (fileblock < start) {
+			*count = start - fileblock;
+			break;
+		}
+		if (fileblock - start < len) {
+			*blknr = le16_to_cpu(extent[i].ee_start_hi);
+			*blknr = (*blknr << 32) +
+				le32_to_cpu(extent[i].ee_start_lo) +
+				(fileblock - start);
+			*count = len - (fileblock - start);
+			break;
+		}
+	}
+	free(buf);
+
+	return 0;
+}
+
 /**
  * ext4fs_reinit_global() - Reinitialize values of ext4 write implementation's
  *			    global pointers
@@ -1872,6 +2031,10 @@ void ext4fs_reinit_global(void)
 		ext4fs_indir3_size = 0;
 		ext4fs_indir3_blkno = -1;
 	}
+	if (ext4fs_extent_cache != NULL) {
+		free(ext4fs_extent_cache);
+		ext4fs_extent_cache = NULL;
+	}
 }
 void ext4fs_close(void)
 {
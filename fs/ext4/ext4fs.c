@@ -45,23 +45,26 @@ void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot)
  * Taken from openmoko-kernel mailing list: By Andy green
  * Optimized read file API : collects and defers contiguous sector
  * reads into one potentially more efficient larger sequential read action
+ *
+ * Blocks are mapped a whole extent run at a time, so a contiguous run
+ * costs one extent lookup and ends up in a single device read.
  */
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
+	lbaint_t i, first;
 	lbaint_t blockcnt;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
 	unsigned int filesize = __le32_to_cpu(node->inode.size);
-	lbaint_t previous_block_number = -1;
 	lbaint_t delayed_start = 0;
-	lbaint_t delayed_extent = 0;
+	loff_t delayed_extent = 0;
 	lbaint_t delayed_skipfirst = 0;
 	lbaint_t delayed_next = 0;
 	char *delayed_buf = NULL;
+	uint32_t count;
 	short status;
 
 	/* Adjust len so it we can't read past the end of the file. */
@@ -69,65 +72,37 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		len = filesize;
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
+	first = lldiv(pos, blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
-		lbaint_t blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+	for (i = first; i < blockcnt; i += count) {
+		uint64_t blknr;
+		loff_t extent;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
-		if (blknr < 0)
+
+		if (ext4fs_read_extent_run(node, i, &blknr, &count))
 			return -1;
+		if (count > blockcnt - i)
+			count = blockcnt - i;
 
 		blknr = blknr << log2_fs_blocksize;
+		extent = (loff_t)count * blocksize;
 
 		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		if (i + count == blockcnt)
+			extent -= (loff_t)blocksize * blockcnt - (len + pos);
 
 		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
+		if (i == first) {
+			skipfirst = pos - (blocksize * i);
+			extent -= skipfirst;
 		}
-		if (blknr) {
-			int status;
-
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
-					status = ext4fs_devread(delayed_start,
-							delayed_skipfirst,
-							delayed_extent,
-							delayed_buf);
-					if (status == 0)
-						return -1;
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
-				}
-			} else {
-				previous_block_number = blknr;
-				delayed_start = blknr;
-				delayed_extent = blockend;
-				delayed_skipfirst = skipfirst;
-				delayed_buf = buf;
-				delayed_next = blknr +
-					(blockend >> log2blksz);
-			}
+
+		if (blknr && delayed_extent && delayed_next == blknr &&
+		    delayed_extent + extent <= INT_MAX) {
+			delayed_extent += extent;
+			delayed_next += (lbaint_t)count << log2_fs_blocksize;
 		} else {
-			if (previous_block_number != -1) {
+			if (delayed_extent) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
@@ -135,20 +110,28 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 							delayed_buf);
 				if (status == 0)
 					return -1;
-				previous_block_number = -1;
+				delayed_extent = 0;
+			}
+			if (blknr) {
+				delayed_start = blknr;
+				delayed_extent = extent;
+				delayed_skipfirst = skipfirst;
+				delayed_buf = buf;
+				delayed_next = blknr +
+					((lbaint_t)count << log2_fs_blocksize);
+			} else {
+				memset(buf, 0, extent);
 			}
-			memset(buf, 0, blocksize - skipfirst);
 		}
-		buf += blocksize - skipfirst;
+		buf += extent;
 	}
-	if (previous_block_number != -1) {
+	if (delayed_extent) {
 		/* spill */
 		status = ext4fs_devread(delayed_start,
 					delayed_skipfirst, delayed_extent,
 					delayed_buf);
 		if (status == 0)
 			return -1;
-		previous_block_number = -1;
 	}
 
 	*actread  = len;
@@ -2869,6 +2869,93 @@ void ubifs_tnc_close(struct ubifs_info *c)
 	kfree(c->ilebs);
 	destroy_old_idx(c);
 }
+#else
+/**
+ * tnc_free_subtree - free a subtree of the TNC and the leaf nodes it caches.
+ * @znode: root of the subtree, unlinked from its parent here
+ *
+ * Only for the read-only U-Boot TNC, where every znode is clean. Returns the
+ * number of znodes freed.
+ */
+static long tnc_free_subtree(struct ubifs_znode *znode)
+{
+	struct ubifs_znode *zn = ubifs_tnc_postorder_first(znode);
+	struct ubifs_znode *next;
+	long freed = 0;
+	int n;
+
+	while (1) {
+		if (zn->level == 0)
+			for (n = 0; n < zn->child_cnt; n++)
+				lnc_free(&zn->zbranch[n]);
+
+		next = zn == znode ? NULL : ubifs_tnc_postorder_next(zn);
+		if (zn->parent)
+			zn->parent->zbranch[zn->iip].znode = NULL;
+		kfree(zn);
+		freed += 1;
+		if (!next)
+			return freed;
+		zn = next;
+	}
+}
+
+/**
+ * ubifs_tnc_trim - bound the number of znodes kept in memory.
+ * @c: UBIFS file-system description object
+ * @max: number of znodes that may stay
+ *
+ * U-Boot has no memory shrinker, so without this the TNC keeps every znode
+ * looked up since mount. Over @max, the level 0 znodes are dropped first:
+ * they are most of the tree and one index node read brings each back. If
+ * the upper levels alone are still too many, everything below the root
+ * goes. Must be called between lookups, never during one.
+ */
+void ubifs_tnc_trim(struct ubifs_info *c, long max)
+{
+	struct ubifs_znode *zroot = c->zroot.znode;
+	struct ubifs_znode *zn;
+	long cnt = atomic_long_read(&c->clean_zn_cnt);
+	long freed = 0;
+	int n;
+
+	if (!zroot || cnt <= max)
+		return;
+
+	for (zn = ubifs_tnc_postorder_first(zroot); zn;
+	     zn = ubifs_tnc_postorder_next(zn)) {
+		if (zn->level != 1)
+			continue;
+		for (n = 0; n < zn->child_cnt; n++)
+			if (zn->zbranch[n].znode)
+				freed += tnc_free_subtree(zn->zbranch[n].znode);
+	}
+
+	if (cnt - freed > max)
+		for (n = 0; n < zroot->child_cnt; n++)
+			if (zroot->zbranch[n].znode)
+				freed += tnc_free_subtree(
+						zroot->zbranch[n].znode);
+
+	atomic_long_sub(freed, &c->clean_zn_cnt);
+	atomic_long_sub(freed, &ubifs_clean_zn_cnt);
+}
+
+/**
+ * ubifs_tnc_close - free the TNC.
+ * @c: UBIFS file-system description object
+ */
+void ubifs_tnc_close(struct ubifs_info *c)
+{
+	long n;
+
+	if (!c->zroot.znode)
+		return;
+
+	n = tnc_free_subtree(c->zroot.znode);
+	c->zroot.znode = NULL;
+	atomic_long_sub(n, &ubifs_clean_zn_cnt);
+}
 #endif
 
 /**
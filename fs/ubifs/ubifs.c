@@ -28,9 +28,15 @@
 
 #include <linux/err.h>
 #include <linux/lzo.h>
+#include <asm/io.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Index nodes kept in memory from one command to the next */
+#ifndef CONFIG_UBIFS_TNC_MAX_ZNODES
+#define CONFIG_UBIFS_TNC_MAX_ZNODES	4096
+#endif
+
 /* compress.c */
 
 /*
@@ -76,6 +82,11 @@ static struct ubifs_compressor zlib_compr = {
 /* All UBIFS compressors */
 struct ubifs_compressor *ubifs_compressors[UBIFS_COMPR_TYPES_CNT];
 
+/* shrinker.c */
+
+/* Clean znodes of all mounted volumes */
+atomic_long_t ubifs_clean_zn_cnt;
+
 
 #ifdef __UBOOT__
 /* from mm/util.c */
@@ -606,6 +617,7 @@ out_mem:
 		free(dir);
 
 out:
+	ubifs_tnc_trim(c, CONFIG_UBIFS_TNC_MAX_ZNODES);
 	ubi_close_volume(c->ubi);
 	return ret;
 }
@@ -621,23 +633,13 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/* Uncompress data node @dn of @block into @addr, a whole block */
+static int decode_block(struct ubifs_info *c, struct inode *inode, void *addr,
+			unsigned int block, struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
-	int err, len, out_len;
-	union ubifs_key key;
+	int len, out_len, err;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -668,6 +670,70 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return decode_block(c, inode, addr, block, dn);
+}
+
+/*
+ * Bulk-read: find the data nodes of @block and the blocks after it that sit
+ * back to back in one LEB, read them with a single flash read and uncompress
+ * each into place; holes between them are zeroed. At most @max_blocks whole
+ * blocks are written. Returns the number of blocks done, 0 if @block does
+ * not start such a run (read it alone then), or a negative error code.
+ */
+static int read_bulk(struct ubifs_info *c, struct inode *inode, void *addr,
+		     unsigned int block, unsigned int max_blocks)
+{
+	struct bu_info *bu = &c->bu;
+	void *buf;
+	unsigned int next = 0, n;
+	int i, err;
+
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		return err;
+	if (bu->cnt < 2 || key_block(c, &bu->zbranch[0].key) != block)
+		return 0;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		return err;
+
+	buf = bu->buf;
+	for (i = 0; i < bu->cnt; i++) {
+		n = key_block(c, &bu->zbranch[i].key) - block;
+		if (n >= max_blocks)
+			break;
+		memset(addr + next * UBIFS_BLOCK_SIZE, 0,
+		       (n - next) * UBIFS_BLOCK_SIZE);
+		err = decode_block(c, inode, addr + n * UBIFS_BLOCK_SIZE,
+				   block + n, buf);
+		if (err)
+			return err;
+		next = n + 1;
+		buf += ALIGN(bu->zbranch[i].len, 8);
+	}
+
+	return next;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -786,7 +852,7 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -820,22 +886,37 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	printf("Loading file '%s' to addr 0x%08x with size %d (0x%08x)...\n",
 	       filename, addr, size, size);
 
-	page.addr = (void *)(unsigned long)addr;
+	page.addr = map_sysmem(addr, size);
 	page.index = 0;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
+	for (i = 0; i < count; i += n) {
 		/*
-		 * Make sure to not read beyond the requested size
+		 * Whole blocks come in runs through bulk-read, the last one
+		 * goes through do_readpage() so nothing is written past @size
 		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
+		n = 0;
+		if (c->bulk_read && count - i > 2) {
+			n = read_bulk(c, inode, page.addr, i, count - 1 - i);
+			if (n < 0) {
+				err = n;
+				break;
+			}
+		}
+		if (!n) {
+			/*
+			 * Make sure to not read beyond the requested size
+			 */
+			if (((i + 1) == count) && (size < inode->i_size))
+				last_block_size = size - (i * PAGE_SIZE);
 
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
-			break;
+			err = do_readpage(c, inode, &page, last_block_size);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
 
 	if (err)
@@ -848,6 +929,7 @@ int ubifs_load(char *filename, u32 addr, u32 size)
 	ubifs_iput(inode);
 
 out:
+	ubifs_tnc_trim(c, CONFIG_UBIFS_TNC_MAX_ZNODES);
 	ubi_close_volume(c->ubi);
 	return err;
 }
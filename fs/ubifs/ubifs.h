@@ -64,12 +64,13 @@ struct page {
 void iput(struct inode *inode);
 
 /*
- * The atomic operations are used for budgeting etc which is not
- * needed for the read-only U-Boot implementation:
+ * U-Boot runs single threaded, so plain counters do. Of those only the
+ * znode counts matter, ubifs_tnc_trim() bounds the TNC by them.
  */
-#define atomic_long_inc(a)
-#define atomic_long_dec(a)
-#define	atomic_long_sub(a, b)
+#define atomic_long_inc(a)	((*(a))++)
+#define atomic_long_dec(a)	((*(a))--)
+#define	atomic_long_sub(a, b)	(*(b) -= (a))
+#define atomic_long_read(a)	(*(a))
 
 typedef unsigned long atomic_long_t;
 
@@ -2190,6 +2191,9 @@ struct ubifs_dent_node *ubifs_tnc_next_ent(struct ubifs_info *c,
 					   union ubifs_key *key,
 					   const struct qstr *nm);
 void ubifs_tnc_close(struct ubifs_info *c);
+#ifdef __UBOOT__
+void ubifs_tnc_trim(struct ubifs_info *c, long max);
+#endif
 int ubifs_tnc_has_node(struct ubifs_info *c, union ubifs_key *key, int level,
 		       int lnum, int offs, int is_idx);
 int ubifs_dirty_idx_node(struct ubifs_info *c, union ubifs_key *key, int level,
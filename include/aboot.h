@@ -23,6 +23,42 @@ static inline int is_sparse_image(void *buf)
 	return 0;
 }
 
+/*
+ * Incremental sparse image writer. The image may be passed to
+ * sparse_stream_write() in pieces of any size; RAW data is written
+ * straight from the pieces in whole blocks. With @async set the last
+ * such write of a piece may still be in flight when it returns, and the
+ * piece must stay unchanged until sparse_stream_sync().
+ */
+struct sparse_stream {
+	block_dev_desc_t *dev_desc;
+	disk_partition_t *info;
+	sparse_header_t sparse_header;
+	chunk_header_t chunk_header;
+	uint32_t fill_val;
+	int state;
+	unsigned int have;		/* header bytes gathered so far */
+	unsigned int skip;		/* bytes to drop before going on */
+	unsigned int data_left;		/* data bytes left in this chunk */
+	unsigned int chunks_left;
+	lbaint_t blk;			/* next block to write */
+	uint32_t total_blocks;
+	uint32_t bytes_written;
+	char *partial;			/* RAW block split between pieces */
+	unsigned int partial_len;
+	uint32_t *fill_buf;
+	int async;			/* write RAW data with blk_write_submit() */
+	int busy;			/* req is in flight */
+	struct blk_req req;
+};
+
+int sparse_stream_init(struct sparse_stream *ss, block_dev_desc_t *dev_desc,
+		       disk_partition_t *info);
+int sparse_stream_write(struct sparse_stream *ss, void *buf, unsigned int len);
+int sparse_stream_sync(struct sparse_stream *ss);
+void sparse_stream_poll(struct sparse_stream *ss);
+int sparse_stream_finish(struct sparse_stream *ss, const char *part_name);
+
 void write_sparse_image(block_dev_desc_t *dev_desc,
 		disk_partition_t *info, const char *part_name,
 		void *data, unsigned sz);
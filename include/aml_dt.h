@@ -0,0 +1,74 @@
+/*
+ * Amlogic multi-dtb container
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __AML_DT_H
+#define __AML_DT_H
+
+#define AML_DT_HEADER_MAGIC	0x5f4c4d41	/* "AML_", multi dtbs supported */
+
+/*
+ * Version 3 layout. All words are little-endian.
+ *
+ *	struct aml_dt_v3_header
+ *	struct aml_dt_v3_entry	[count], sorted by id
+ *	entry data, each at a multiple of AML_DT_V3_ALIGN
+ *
+ * An id is the soc, platform and variant strings of aml_dt, each in a
+ * field of AML_DT_V3_ID_LEN bytes padded with NULs, so that the index
+ * can be searched with memcmp(). Every entry is stored on its own, raw
+ * or compressed with one of the IH_COMP_* methods, so a loader only has
+ * to touch the one it boots.
+ */
+#define AML_DT_V3_VERSION	3
+#define AML_DT_V3_ID_LEN	16
+#define AML_DT_V3_ID_FIELDS	3	/* soc, platform, variant */
+#define AML_DT_V3_ID_SIZE	(AML_DT_V3_ID_LEN * AML_DT_V3_ID_FIELDS)
+#define AML_DT_V3_ALIGN		8
+
+struct aml_dt_v3_header {
+	uint32_t magic;		/* AML_DT_HEADER_MAGIC */
+	uint32_t version;	/* AML_DT_V3_VERSION */
+	uint32_t count;		/* Number of entries */
+	uint32_t entry_size;	/* Size of an entry, at least 64 */
+};
+
+struct aml_dt_v3_entry {
+	char id[AML_DT_V3_ID_SIZE];
+	uint32_t offset;	/* From the start of the container */
+	uint32_t size;		/* Stored size */
+	uint32_t dtb_size;	/* Size once decompressed */
+	uint8_t comp;		/* IH_COMP_NONE, IH_COMP_GZIP or IH_COMP_LZ4 */
+	uint8_t reserved[3];
+};
+
+/**
+ * aml_dt_v3_find() - Look up a dtb in a version 3 container
+ *
+ * @blob:	Container
+ * @soc:	First part of aml_dt
+ * @plat:	Second part of aml_dt
+ * @vari:	Third part of aml_dt, may be NULL or empty
+ * @return index of the entry, or -ENOENT
+ */
+int aml_dt_v3_find(const void *blob, const char *soc, const char *plat,
+		   const char *vari);
+
+/**
+ * aml_dt_v3_load() - Get a dtb from a version 3 container
+ *
+ * An uncompressed entry is used where it is unless @blob and @dest differ.
+ * A compressed one is inflated to @dest, which may overlap @blob.
+ *
+ * @blob:	Container
+ * @index:	Entry, from aml_dt_v3_find()
+ * @dest:	Where to put the dtb if it has to be copied or decompressed
+ * @dest_size:	Space at @dest
+ * @return address of the dtb, or NULL on error
+ */
+void *aml_dt_v3_load(const void *blob, int index, void *dest,
+		     unsigned long dest_size);
+
+#endif
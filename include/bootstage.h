@@ -186,6 +186,8 @@ enum bootstage_id {
 	BOOTSTAGE_ID_MAIN_LOOP,
 	BOOTSTAGE_KERNELREAD_START,
 	BOOTSTAGE_KERNELREAD_STOP,
+	BOOTSTAGE_LOGOREAD_START,
+	BOOTSTAGE_LOGO_SHOWN,
 	BOOTSTAGE_ID_BOARD_INIT,
 	BOOTSTAGE_ID_BOARD_INIT_DONE,
 
@@ -194,6 +196,8 @@ enum bootstage_id {
 	BOOTSTAGE_ID_MAIN_CPU_READY,
 
 	BOOTSTAGE_ID_ACCUM_LCD,
+	BOOTSTAGE_ID_ACCUM_IMGREAD_READ,
+	BOOTSTAGE_ID_ACCUM_IMGREAD_INFLATE,
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -325,6 +329,28 @@ int bootstage_stash(void *base, int size);
  */
 int bootstage_unstash(void *base, int size);
 
+/**
+ * Export bootstage data in the portable format of bootstage_export.h
+ *
+ * Unlike bootstage_stash() this includes accumulated timings and is meant
+ * to be collected from the board and read by tools/bootstage-diff.
+ *
+ * @param base	Base address of memory buffer
+ * @param size	Size of memory buffer
+ * @return size of the export in bytes, or -ENOSPC if out of space
+ */
+int bootstage_export(void *base, int size);
+
+/**
+ * Save an export just before the OS is started
+ *
+ * The export goes to CONFIG_BOOTSTAGE_EXPORT_ADDR if defined, and to the
+ * file given by the bootstage_file environment variable if set.
+ *
+ * @return 0 if ok (or nothing to do), -ve on error
+ */
+int bootstage_export_save(void);
+
 #else
 static inline ulong bootstage_add_record(enum bootstage_id id,
 		const char *name, int flags, ulong mark)
@@ -385,6 +411,16 @@ static inline int bootstage_unstash(void *base, int size)
 {
 	return 0;	/* Pretend to succeed */
 }
+
+static inline int bootstage_export(void *base, int size)
+{
+	return 0;	/* Nothing to export */
+}
+
+static inline int bootstage_export_save(void)
+{
+	return 0;
+}
 #endif /* CONFIG_BOOTSTAGE */
 
 /* Helper macro for adding a bootstage to a line of code */
@@ -0,0 +1,43 @@
+/*
+ * Binary export of bootstage records, shared between U-Boot and the
+ * bootstage-diff host tool.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __BOOTSTAGE_EXPORT_H
+#define __BOOTSTAGE_EXPORT_H
+
+/*
+ * An export is a header, an array of records and a string table holding
+ * the record names. All fields are little-endian. Records are in id
+ * order; sort them by time to get the boot timeline.
+ */
+enum {
+	BOOTSTAGE_EXPORT_MAGIC		= 0x58457342,	/* "BsEX" */
+	BOOTSTAGE_EXPORT_VERSION	= 1,
+};
+
+/* Flags for each exported record */
+enum bootstage_export_flags {
+	BOOTSTAGE_EXPORTF_ERROR	= 1 << 0,	/* Error record */
+	BOOTSTAGE_EXPORTF_ACCUM	= 1 << 1,	/* Accumulated, not a mark */
+};
+
+struct bootstage_export_hdr {
+	uint32_t magic;		/* BOOTSTAGE_EXPORT_MAGIC */
+	uint32_t version;	/* BOOTSTAGE_EXPORT_VERSION */
+	uint32_t count;		/* Number of records */
+	uint32_t size;		/* Total size, including this header */
+	uint32_t crc32;		/* crc32 of everything after the header */
+	uint32_t reserved;
+};
+
+struct bootstage_export_rec {
+	uint32_t id;		/* enum bootstage_id */
+	uint32_t flags;		/* enum bootstage_export_flags */
+	uint32_t time_us;	/* Mark time, or total time if accumulated */
+	uint32_t name;		/* Offset of name in the string table */
+};
+
+#endif
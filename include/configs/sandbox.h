@@ -55,6 +55,9 @@
 #define CONFIG_CMD_EXT4
 #define CONFIG_CMD_EXT4_WRITE
 #define CONFIG_CMD_PART
+#define CONFIG_BLOCK_CACHE
+#define CONFIG_CMD_BLOCK_CACHE
+#define CONFIG_BLOCK_ASYNC
 #define CONFIG_DOS_PARTITION
 #define CONFIG_HOST_MAX_DEVICES 4
 #define CONFIG_CMD_FS_GENERIC
@@ -118,8 +121,9 @@
 #define CONFIG_I2C_EDID
 #define CONFIG_I2C_EEPROM
 
-/* Memory things - we don't really want a memory test */
+/* Memory things - mtest is only there to regression-test its engine */
 #define CONFIG_SYS_LOAD_ADDR		0x00000000
+#define CONFIG_CMD_MEMTEST
 #define CONFIG_SYS_MEMTEST_START	0x00100000
 #define CONFIG_SYS_MEMTEST_END		(CONFIG_SYS_MEMTEST_START + 0x1000)
 #define CONFIG_SYS_FDT_LOAD_ADDR	        0x100
@@ -143,9 +147,31 @@
 /* include default commands */
 #include <config_cmd_default.h>
 
-/* We don't have networking support yet */
-#undef CONFIG_CMD_NET
-#undef CONFIG_CMD_NFS
+/* Networking over a host UDP socket, see drivers/net/sandbox.c */
+#define CONFIG_SANDBOX_ETH
+#define CONFIG_IP_DEFRAG
+#define CONFIG_NET_MAXDEFRAG		16384
+#define CONFIG_CMD_PING
+#define CONFIG_CMD_TIME
+#define CONFIG_IPADDR			192.168.7.2
+#define CONFIG_SERVERIP			192.168.7.1
+#define CONFIG_NETMASK			255.255.255.0
+
+/* NAND backed by a host file, see drivers/mtd/nand/sandbox_nand.c */
+#define CONFIG_NAND_SANDBOX
+#define CONFIG_CMD_NAND
+#define CONFIG_CMD_NAND_TORTURE
+#define CONFIG_CMD_NAND_TRIMFFS
+#define CONFIG_SYS_MAX_NAND_DEVICE	1
+#define CONFIG_SYS_NAND_BASE		0
+#define CONFIG_MTD_DEVICE
+#define CONFIG_MTD_PARTITIONS
+#define CONFIG_CMD_MTDPARTS
+#define MTDIDS_DEFAULT			"nand0=sandbox-nand"
+#define MTDPARTS_DEFAULT		"mtdparts=sandbox-nand:-(ubi)"
+#define CONFIG_CMD_UBI
+#define CONFIG_CMD_UBIFS
+#define CONFIG_RBTREE
 
 #define CONFIG_CMD_HASH
 #define CONFIG_HASH_VERIFY
@@ -199,6 +225,7 @@
 #define CONFIG_GZIP_COMPRESSED
 #define CONFIG_BZIP2
 #define CONFIG_LZO
+#define CONFIG_LZ4
 #define CONFIG_LZMA
 
 #define CONFIG_TPM_TIS_SANDBOX
@@ -29,6 +29,12 @@
 
 #define FATBUFBLOCKS	6
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
+
+/* Number of FATBUFSIZE windows kept by the read path, replaced LRU */
+#ifndef CONFIG_FS_FAT_BUFWINDOWS
+#define CONFIG_FS_FAT_BUFWINDOWS	8
+#endif
+#define FATBUFWINDOWS	CONFIG_FS_FAT_BUFWINDOWS
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
@@ -173,7 +179,10 @@ typedef struct {
 	__u16	sect_size;	/* Size of sectors in bytes */
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
-	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	int	fatbufnum;	/* Used by get_fatent_value, init to -1 */
+	int	fatwinnum[FATBUFWINDOWS]; /* FAT window held in each slot, or -1 */
+	__u32	fatwinused[FATBUFWINDOWS]; /* LRU stamp of each slot */
+	__u32	fatwinclock;	/* Source of LRU stamps */
 } fsdata;
 
 typedef int	(file_detectfs_func)(void);
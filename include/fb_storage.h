@@ -11,4 +11,10 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 			unsigned int download_bytes, char *response);
 void fb_mmc_erase_write(const char *cmd, void *download_buffer,
 			char *response);
+
+u64 fb_mmc_stream_open(const char *cmd, char *response);
+void fb_mmc_stream_start(char *response);
+int fb_mmc_stream_write(void *buf, unsigned int len);
+void fb_mmc_stream_poll(void);
+int fb_mmc_stream_finish(void);
 #endif /* _FB_STORAGE_H_ */
@@ -250,6 +250,7 @@ struct lmb;
 #define IH_COMP_BZIP2		2	/* bzip2 Compression Used	*/
 #define IH_COMP_LZMA		3	/* lzma  Compression Used	*/
 #define IH_COMP_LZO		4	/* lzo   Compression Used	*/
+#define IH_COMP_LZ4		5	/* lz4   Compression Used	*/
 
 #define IH_MAGIC	0x27051956	/* Image Magic Number		*/
 #define IH_NMLEN		32	/* Image Name Length		*/
@@ -1083,6 +1084,55 @@ ulong android_image_get_kload(const struct andr_img_hdr *hdr);
 ulong android_image_get_comp(const struct andr_img_hdr *hdr);
 int android_image_need_move(ulong *img_addr,const struct andr_img_hdr *hdr);
 
+/**
+ * struct andr_img_placed - Android image whose sections were loaded apart
+ *
+ * @hdr:	Copy of the image header
+ * @kernel_data: Kernel
+ * @kernel_len:	Size of the kernel at @kernel_data
+ * @kernel_comp: IH_COMP_NONE once the kernel sits at its load address
+ * @rd_data:	Ramdisk, where it can be booted in place
+ * @second_data: Second stage (dtb)
+ * @buf:	malloc()ed buffer holding the sections, owned by the record
+ */
+struct andr_img_placed {
+	const struct andr_img_hdr *hdr;
+	ulong kernel_data;
+	ulong kernel_len;
+	int kernel_comp;
+	ulong rd_data;
+	ulong second_data;
+	void *buf;
+};
+
+/**
+ * android_image_set_placed() - Record an image loaded section by section
+ *
+ * bootm of @addr then finds the sections where @placed says, as long as
+ * what is at @addr has not been changed since. @placed->buf is freed when
+ * the record is replaced or forgotten.
+ *
+ * @addr:	Address the image was loaded for
+ * @placed:	Where each section is, NULL to forget
+ */
+void android_image_set_placed(ulong addr, const struct andr_img_placed *placed);
+
+/**
+ * android_image_get_placed() - Find the header of a placed image
+ *
+ * @addr:	Address passed to bootm
+ * @return header recorded for @addr, or NULL
+ */
+const struct andr_img_hdr *android_image_get_placed(ulong addr);
+
+/**
+ * android_image_ramdisk_placed() - Check for a ramdisk that is in place
+ *
+ * @rd_data:	Ramdisk address
+ * @return 1 if @rd_data is a placed ramdisk, which needs no relocation, else 0
+ */
+int android_image_ramdisk_placed(ulong rd_data);
+
 #endif /* CONFIG_ANDROID_BOOT_IMAGE */
 
 #endif	/* __IMAGE_H__ */
@@ -0,0 +1,30 @@
+/*
+ * LZ4 frame and legacy stream decompression
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __LZ4_H
+#define __LZ4_H
+
+#define LZ4_MAGIC		0x184D2204	/* LZ4 frame */
+#define LZ4_LEGACY_MAGIC	0x184C2102	/* lz4 -l, used for kernels */
+
+/**
+ * ulz4fn() - Decompress LZ4 data
+ *
+ * Decodes one or more LZ4 frames or legacy streams. Skippable frames are
+ * ignored, as is anything following the last stream. Header, block and
+ * content checksums are not verified.
+ *
+ * @src:	Compressed data
+ * @srcn:	Size of compressed data
+ * @dst:	Output buffer
+ * @dstn:	Size of the output buffer on entry, size of the
+ *		decompressed data on return
+ * @return 0 if OK, -EINVAL if @src is not LZ4 data or uses an unsupported
+ * feature, -EPROTO if it is corrupt, -ENOBUFS if @dst is too small
+ */
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+#endif
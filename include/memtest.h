@@ -0,0 +1,50 @@
+/*
+ * Memory test engine working a cache line at a time
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __MEMTEST_H
+#define __MEMTEST_H
+
+/* Words written or verified as one burst, a cache line on arm64 */
+#define MEMTEST_LINE_WORDS	8
+#define MEMTEST_LINE		(MEMTEST_LINE_WORDS * sizeof(ulong))
+
+enum memtest_alg {
+	MEMTEST_ALG_INV,	/* moving inversions of a walking-ones pattern */
+	MEMTEST_ALG_XOR,	/* xor-shift pseudo-random sequence */
+	MEMTEST_ALG_ADDR,	/* each word holds its address, then its complement */
+
+	MEMTEST_ALG_COUNT,
+};
+
+struct memtest_stats {
+	ulong errs;		/* words that read back wrong */
+	u64 write_bytes;	/* written by fill passes */
+	u64 write_us;
+	u64 read_bytes;		/* read by verify passes */
+	u64 read_us;
+	u64 bytes;		/* read and written by all passes */
+	u64 us;			/* all passes, with cache flushes */
+};
+
+/**
+ * memtest_run() - Run one pass of a memory test algorithm
+ *
+ * @alg:	Algorithm, MEMTEST_ALG_...
+ * @buf:	Memory to test, aligned to MEMTEST_LINE
+ * @start_addr:	Address of @buf to report errors at
+ * @size:	Bytes to test, a multiple of MEMTEST_LINE
+ * @pattern:	Walking pattern or seed, 0 to derive it from @iteration
+ * @iteration:	Iteration number, varies the pattern from pass to pass
+ * @flush:	Flush the data cache between passes, so that reads come
+ *		from memory
+ * @stats:	Errors and throughput are added to this
+ * @return 0 if the pass completed, -1 if interrupted by ctrl-c
+ */
+int memtest_run(enum memtest_alg alg, ulong *buf, ulong start_addr,
+		ulong size, ulong pattern, int iteration, int flush,
+		struct memtest_stats *stats);
+
+#endif
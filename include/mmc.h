@@ -41,8 +41,10 @@
 #define MMC_MODE_SPI		(1 << 4)
 #define MMC_MODE_HC		(1 << 5)
 #define MMC_MODE_DDR_52MHz	(1 << 6)
+#define MMC_MODE_CMD23		(1 << 7)	/* Host can send SET_BLOCK_COUNT */
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23	0x00000002	/* CMD_SUPPORT bit for SET_BLOCK_COUNT */
 
 #define IS_SD(x) (x->version & SD_VERSION_SD)
 
@@ -106,6 +108,8 @@
 #define OCR_ACCESS_MODE		0x60000000
 
 #define SECURE_ERASE		0x80000000
+#define MMC_ERASE_ARG		0x00000000
+#define MMC_TRIM_ARG		0x00000001
 
 #define MMC_STATUS_MASK		(~0x0206BF7F)
 #define MMC_STATUS_SWITCH_ERROR	(1 << 7)
@@ -153,16 +157,19 @@
 #define EXT_CSD_PARTITIONS_ATTRIBUTE	156	/* R/W */
 #define EXT_CSD_PARTITIONING_SUPPORT	160	/* RO */
 #define EXT_CSD_RST_N_FUNCTION		162	/* R/W */
+#define EXT_CSD_WR_REL_PARAM		166	/* RO */
 #define EXT_CSD_RPMB_MULT		168	/* RO */
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
 #define EXT_CSD_REV			192	/* RO */
 #define EXT_CSD_CARD_TYPE		196	/* RO */
 #define EXT_CSD_SEC_CNT			212	/* RO, 4 bytes */
 #define EXT_CSD_HC_WP_GRP_SIZE		221	/* RO */
+#define EXT_CSD_REL_WR_SEC_C		222	/* RO */
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_DEV_LIFETIME_EST_TYP_A	268	/* RO */
@@ -204,6 +211,12 @@
 
 #define EXT_CSD_PARTITION_SETTING_COMPLETED	(1 << 0)
 
+#define EXT_CSD_WR_REL_PARAM_EN		(1 << 2)	/* Enhanced reliable write */
+
+/* SET_BLOCK_COUNT argument */
+#define MMC_CMD23_ARG_REL_WR	(1 << 31)	/* Reliable write */
+#define MMC_CMD23_MAX_BLOCKS	0xffff
+
 #define R1_ILLEGAL_COMMAND		(1 << 22)
 #define R1_APP_CMD			(1 << 5)
 
@@ -276,6 +289,15 @@ struct mmc_ops {
 	int (*getwp)(struct mmc *mmc);
 	int (*calibration)(struct mmc *mmc);
 	int (*refix)(struct mmc *mmc);
+	/*
+	 * Optional split of send_cmd() for asynchronous transfers: start the
+	 * command and return, then poll until it no longer returns -EBUSY.
+	 * The final poll returns what send_cmd() would have.
+	 */
+	int (*send_cmd_start)(struct mmc *mmc,
+			      struct mmc_cmd *cmd, struct mmc_data *data);
+	int (*send_cmd_poll)(struct mmc *mmc,
+			     struct mmc_cmd *cmd, struct mmc_data *data);
 };
 
 struct mmc_config {
@@ -327,8 +349,23 @@ struct mmc {
 	char preinit;		/* start init as early as possible */
 	uint op_cond_response;	/* the response byte from the last op_cond */
 	int ddr_mode;
+	uint cur_blocklen;	/* length last set by CMD16, 0 if unknown */
+	char cmd23;		/* transfers use SET_BLOCK_COUNT, not STOP */
+	char rel_wr_en;		/* enhanced reliable write, any size */
+	char reliable_write;	/* see mmc_set_reliable_write() */
+	uint rel_wr_sectors;	/* reliable write unit, 0 if unsupported */
+	char erased_zero;	/* erased blocks read back as zeros */
+#ifdef CONFIG_MMC_CMD_STATS
+	ulong cmd_stats[64];	/* commands sent, by index */
+#endif
 	unsigned char calout[20][20];
 	int refix;
+#ifdef CONFIG_BLOCK_ASYNC
+	struct mmc_cmd async_cmd;	/* transfer in flight, blk_*_submit() */
+	struct mmc_data async_data;
+	char async_prg;			/* written chunk is being programmed */
+	ulong async_timer;		/* when programming started */
+#endif
 };
 
 int mmc_register(struct mmc *mmc);
@@ -366,6 +403,34 @@ int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
 		   unsigned short cnt, unsigned char *key);
 
 int mmc_switch_partition(struct mmc* mmc, unsigned int part);
+
+/**
+ * mmc_set_reliable_write() - Make writes reliable, or stop doing so
+ *
+ * A reliable write leaves either the old or the new data in each sector if
+ * power fails during the write. It is slower, so only use it around writes
+ * of small, important data such as the environment or keys.
+ *
+ * @mmc:	MMC device
+ * @enable:	1 to make the following writes reliable, 0 to stop
+ * @return 0 if OK, -EOPNOTSUPP if the card or host cannot do it
+ */
+int mmc_set_reliable_write(struct mmc *mmc, int enable);
+
+/**
+ * mmc_erase_groups() - Erase whole erase groups with a plain erase or trim
+ *
+ * Unlike the block device erase this is not a secure erase. Erased blocks
+ * read back as zeros only if mmc->erased_zero is set.
+ *
+ * @mmc:	MMC device
+ * @start:	First block, aligned to mmc->erase_grp_size
+ * @blkcnt:	Number of blocks, a multiple of mmc->erase_grp_size
+ * @arg:	MMC_ERASE_ARG or MMC_TRIM_ARG
+ * @return 0 if OK, non-zero on error
+ */
+int mmc_erase_groups(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+		     uint arg);
 /**
  * Start device initialization and return immediately; it does not block on
  * polling OCR (operation condition register) status.  Then you should call
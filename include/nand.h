@@ -27,7 +27,7 @@
 #endif
 #else
 #if defined(CONFIG_NAND_FSL_ELBC) || defined(CONFIG_NAND_ATMEL)\
-	|| defined(CONFIG_NAND_FSL_IFC)
+	|| defined(CONFIG_NAND_FSL_IFC) || defined(CONFIG_NAND_SANDBOX)
 #define CONFIG_SYS_NAND_SELF_INIT
 #endif
 #endif
@@ -157,6 +157,10 @@ void board_nand_select_device(struct nand_chip *nand, int chip);
 
 __attribute__((noreturn)) void nand_boot(void);
 
+#ifdef CONFIG_NAND_SANDBOX
+void sandbox_nand_show_stats(int reset);
+#endif
+
 #endif
 
 #ifdef CONFIG_ENV_OFFSET_OOB
@@ -10,6 +10,8 @@
 #include <ide.h>
 #include <common.h>
 
+struct blk_req;
+
 typedef struct block_dev_desc {
 	int		if_type;	/* type of the interface */
 	int		dev;		/* device number */
@@ -38,6 +40,11 @@ typedef struct block_dev_desc {
 	unsigned long   (*block_erase)(int dev,
 				       lbaint_t start,
 				       lbaint_t blkcnt);
+	/* Optional, see blk_read_submit() and blk_write_submit() */
+	int		(*block_read_submit)(struct blk_req *req);
+	int		(*block_read_poll)(struct blk_req *req);
+	int		(*block_write_submit)(struct blk_req *req);
+	int		(*block_write_poll)(struct blk_req *req);
 	void		*priv;		/* driver private struct pointer */
 }block_dev_desc_t;
 
@@ -149,6 +156,217 @@ static inline int get_device_and_partition(const char *ifname,
 { *dev_desc = NULL; return -1; }
 #endif
 
+/* disk/part.c: block cache shared by all block devices */
+struct block_cache_stats {
+	unsigned hits;			/* reads served from the cache */
+	unsigned misses;		/* reads that went to the device */
+	unsigned readahead;		/* blocks fetched ahead of a read */
+	unsigned entries;		/* entries currently cached */
+	unsigned max_blocks_per_entry;	/* larger reads bypass the cache */
+	unsigned max_entries;		/* 0 disables the cache */
+};
+
+#if defined(CONFIG_BLOCK_CACHE) && !defined(CONFIG_SPL_BUILD)
+/**
+ * blk_dread() - Read blocks through the block cache
+ *
+ * @block_dev:	Device to read from
+ * @start:	First block to read
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer
+ * @return number of blocks read, like block_dev->block_read()
+ */
+unsigned long blk_dread(block_dev_desc_t *block_dev, lbaint_t start,
+			lbaint_t blkcnt, void *buffer);
+
+/**
+ * blk_dwrite() - Write blocks, dropping stale cache entries of the device
+ *
+ * @block_dev:	Device to write to
+ * @start:	First block to write
+ * @blkcnt:	Number of blocks to write
+ * @buffer:	Source buffer
+ * @return number of blocks written, like block_dev->block_write()
+ */
+unsigned long blk_dwrite(block_dev_desc_t *block_dev, lbaint_t start,
+			 lbaint_t blkcnt, const void *buffer);
+
+/**
+ * blkcache_invalidate() - Drop all cached blocks of a device
+ *
+ * Drivers call this when the media changes underneath the cache: on
+ * writes and erases that bypass blk_dwrite(), hardware partition
+ * switches and re-initialisation.
+ *
+ * @if_type:	Interface type (IF_TYPE_...)
+ * @dev:	Device number
+ */
+void blkcache_invalidate(int if_type, int dev);
+
+/**
+ * blkcache_configure() - Resize the block cache, dropping its contents
+ *
+ * @blocks:	Largest read (in blocks) kept in the cache
+ * @entries:	Number of entries kept, 0 to disable the cache
+ */
+void blkcache_configure(unsigned blocks, unsigned entries);
+
+/**
+ * blkcache_stats() - Get and reset the block cache statistics
+ *
+ * @stats:	Returns the statistics
+ */
+void blkcache_stats(struct block_cache_stats *stats);
+#else
+static inline unsigned long blk_dread(block_dev_desc_t *block_dev,
+				      lbaint_t start, lbaint_t blkcnt,
+				      void *buffer)
+{
+	return block_dev->block_read(block_dev->dev, start, blkcnt, buffer);
+}
+
+static inline unsigned long blk_dwrite(block_dev_desc_t *block_dev,
+				       lbaint_t start, lbaint_t blkcnt,
+				       const void *buffer)
+{
+	return block_dev->block_write(block_dev->dev, start, blkcnt, buffer);
+}
+
+static inline void blkcache_invalidate(int if_type, int dev) {}
+#endif
+
+/* disk/part.c: asynchronous block reads and writes */
+enum blk_req_state {
+	BLK_REQ_BUSY,		/* submitted, buffer in use by the device */
+	BLK_REQ_DONE,		/* finished, 'done' blocks are valid */
+};
+
+struct blk_req {
+	block_dev_desc_t *block_dev;
+	lbaint_t start;			/* first block */
+	lbaint_t blkcnt;		/* number of blocks */
+	void *buffer;			/* destination or source buffer */
+	lbaint_t done;			/* blocks transferred, less on error */
+	enum blk_req_state state;
+};
+
+#if defined(CONFIG_BLOCK_ASYNC) && !defined(CONFIG_SPL_BUILD)
+/**
+ * blk_read_submit() - Start reading blocks and return without waiting
+ *
+ * The CPU is free to do other work, such as hashing or decompressing the
+ * previous chunk, until blk_read_poll() reports the read finished. Only
+ * one request may be in flight per device, and the device must not be
+ * used otherwise meanwhile. Devices without the block_read_submit()
+ * operation complete the read before this returns.
+ *
+ * @block_dev:	Device to read from
+ * @start:	First block to read
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer, must stay valid until the read finishes
+ * @req:	Request to fill in and track the read with
+ * @return 0 if the read was started, -ve on error
+ */
+int blk_read_submit(block_dev_desc_t *block_dev, lbaint_t start,
+		    lbaint_t blkcnt, void *buffer, struct blk_req *req);
+
+/**
+ * blk_read_poll() - Check whether a submitted read has finished
+ *
+ * @req:	Request passed to blk_read_submit()
+ * @return 1 if finished (req->done is valid), 0 if still in flight
+ */
+int blk_read_poll(struct blk_req *req);
+
+/**
+ * blk_read_wait() - Wait for a submitted read to finish
+ *
+ * @req:	Request passed to blk_read_submit()
+ * @return number of blocks read, like block_dev->block_read()
+ */
+unsigned long blk_read_wait(struct blk_req *req);
+
+/**
+ * blk_write_submit() - Start writing blocks and return without waiting
+ *
+ * Works like blk_read_submit(): the CPU may go on, for instance to
+ * receive the next buffer, until blk_write_poll() reports the write
+ * finished. @buffer must not change until then. Devices without the
+ * block_write_submit() operation complete the write before this returns.
+ *
+ * @block_dev:	Device to write to
+ * @start:	First block to write
+ * @blkcnt:	Number of blocks to write
+ * @buffer:	Source buffer, must stay unchanged until the write finishes
+ * @req:	Request to fill in and track the write with
+ * @return 0 if the write was started, -ve on error
+ */
+int blk_write_submit(block_dev_desc_t *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, const void *buffer, struct blk_req *req);
+
+/**
+ * blk_write_poll() - Check whether a submitted write has finished
+ *
+ * @req:	Request passed to blk_write_submit()
+ * @return 1 if finished (req->done is valid), 0 if still in flight
+ */
+int blk_write_poll(struct blk_req *req);
+
+/**
+ * blk_write_wait() - Wait for a submitted write to finish
+ *
+ * @req:	Request passed to blk_write_submit()
+ * @return number of blocks written, like block_dev->block_write()
+ */
+unsigned long blk_write_wait(struct blk_req *req);
+#else
+static inline int blk_read_submit(block_dev_desc_t *block_dev,
+				  lbaint_t start, lbaint_t blkcnt,
+				  void *buffer, struct blk_req *req)
+{
+	req->block_dev = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buffer;
+	req->done = blk_dread(block_dev, start, blkcnt, buffer);
+	req->state = BLK_REQ_DONE;
+	return 0;
+}
+
+static inline int blk_read_poll(struct blk_req *req)
+{
+	return 1;
+}
+
+static inline unsigned long blk_read_wait(struct blk_req *req)
+{
+	return req->done;
+}
+
+static inline int blk_write_submit(block_dev_desc_t *block_dev,
+				   lbaint_t start, lbaint_t blkcnt,
+				   const void *buffer, struct blk_req *req)
+{
+	req->block_dev = block_dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = (void *)buffer;
+	req->done = blk_dwrite(block_dev, start, blkcnt, buffer);
+	req->state = BLK_REQ_DONE;
+	return 0;
+}
+
+static inline int blk_write_poll(struct blk_req *req)
+{
+	return 1;
+}
+
+static inline unsigned long blk_write_wait(struct blk_req *req)
+{
+	return req->done;
+}
+#endif
+
 #ifdef CONFIG_MAC_PARTITION
 /* disk/part_mac.c */
 int get_partition_info_mac (block_dev_desc_t * dev_desc, int part, disk_partition_t *info);
@@ -11,8 +11,23 @@ struct host_block_dev {
 	block_dev_desc_t blk_dev;
 	char *filename;
 	int fd;
+	ulong delay_us;		/* simulated latency of each transfer */
+	ulong ready_us;		/* when the transfer in flight finishes */
 };
 
 int host_dev_bind(int dev, char *filename);
 
+/**
+ * host_dev_set_delay() - Make reads and writes of a host device take longer
+ *
+ * Synchronous transfers sleep for @delay_us. Asynchronous ones return at
+ * once and only finish (and fill or take the buffer) @delay_us later,
+ * like a DMA transfer would.
+ *
+ * @dev:	Device number
+ * @delay_us:	Latency of each transfer in microseconds, 0 for none
+ * @return 0 if ok, -1 if there is no such device
+ */
+int host_dev_set_delay(int dev, ulong delay_us);
+
 #endif
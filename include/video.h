@@ -26,6 +26,26 @@ void	video_puts(struct stdio_dev *dev, const char *s);
  */
 int video_display_bitmap(ulong bmp_image, int x, int y);
 
+/**
+ * Get the frame buffer that bitmaps are drawn into
+ *
+ * @param base		Returns the address of the frame buffer
+ * @param width		Returns its width in pixels
+ * @param height	Returns its height in pixels
+ * @param format	Returns the colour format index << 8 | bits per pixel
+ * @return size of the frame buffer in bytes, or 0 if there is none
+ */
+ulong video_get_fb(ulong *base, unsigned *width, unsigned *height,
+		   unsigned *format);
+
+/**
+ * Show a frame buffer that was filled without video_display_bitmap(),
+ * e.g. read straight from storage
+ *
+ * @return 0 if OK, 1 if there is no frame buffer
+ */
+int video_display_fb(void);
+
 /**
  * Get the width of the screen in pixels
  *
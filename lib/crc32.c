@@ -26,6 +26,14 @@
 
 #define tole(x) cpu_to_le32(x)
 
+/*
+ * Slice-by-8 processes eight bytes per step with seven extra tables
+ * (7KiB). SPL keeps the single table to stay small.
+ */
+#if !defined(DYNAMIC_CRC_TABLE) && !defined(CONFIG_SPL_BUILD)
+#define CRC32_SLICE_BY_8
+#endif
+
 #ifdef DYNAMIC_CRC_TABLE
 
 local int crc_table_empty = 1;
@@ -151,6 +159,53 @@ tole(0xb40bbe37L), tole(0xc30c8ea1L), tole(0x5a05df1bL), tole(0x2d02ef8dL)
 };
 #endif
 
+#ifdef CRC32_SLICE_BY_8
+#include "crc32table.h"
+#endif
+
+#if defined(CONFIG_ARM64) && !defined(USE_HOSTCC)
+/*
+ * The ARMv8 CRC32 instructions compute the same reflected CRC-32 without
+ * the ones complement. They are optional in ARMv8.0, so check
+ * ID_AA64ISAR0_EL1.CRC32 before using them.
+ */
+static inline int crc32_arm64_present(void)
+{
+	unsigned long isar0;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (isar0));
+	return ((isar0 >> 16) & 0xf) != 0;
+}
+
+static uint32_t crc32_arm64(uint32_t crc, const uint8_t *p, uInt len)
+{
+	while (len && ((unsigned long)p & 7)) {
+		asm(".arch armv8-a+crc\n\tcrc32b %w0, %w0, %w1"
+		    : "+r" (crc) : "r" ((uint32_t)*p++));
+		len--;
+	}
+	for (; len >= 32; len -= 32, p += 32) {
+		const uint64_t *d = (const uint64_t *)p;
+
+		asm(".arch armv8-a+crc\n\t"
+		    "crc32x %w0, %w0, %x1\n\t"
+		    "crc32x %w0, %w0, %x2\n\t"
+		    "crc32x %w0, %w0, %x3\n\t"
+		    "crc32x %w0, %w0, %x4"
+		    : "+r" (crc)
+		    : "r" (d[0]), "r" (d[1]), "r" (d[2]), "r" (d[3]));
+	}
+	for (; len >= 8; len -= 8, p += 8)
+		asm(".arch armv8-a+crc\n\tcrc32x %w0, %w0, %x1"
+		    : "+r" (crc) : "r" (*(const uint64_t *)p));
+	while (len--)
+		asm(".arch armv8-a+crc\n\tcrc32b %w0, %w0, %w1"
+		    : "+r" (crc) : "r" ((uint32_t)*p++));
+
+	return crc;
+}
+#endif
+
 #if 0
 /* =========================================================================
  * This function can be used by asm versions of crc32()
@@ -167,8 +222,16 @@ const uint32_t * ZEXPORT get_crc_table()
 /* ========================================================================= */
 # if __BYTE_ORDER == __LITTLE_ENDIAN
 #  define DO_CRC(x) crc = tab[(crc ^ (x)) & 255] ^ (crc >> 8)
+#  define DO_CRC4(q) (sl[2][(q) & 255] ^ sl[1][((q) >> 8) & 255] ^ \
+		      sl[0][((q) >> 16) & 255] ^ tab[((q) >> 24) & 255])
+#  define DO_CRC8(q) (sl[6][(q) & 255] ^ sl[5][((q) >> 8) & 255] ^ \
+		      sl[4][((q) >> 16) & 255] ^ sl[3][((q) >> 24) & 255])
 # else
 #  define DO_CRC(x) crc = tab[((crc >> 24) ^ (x)) & 255] ^ (crc << 8)
+#  define DO_CRC4(q) (tab[(q) & 255] ^ sl[0][((q) >> 8) & 255] ^ \
+		      sl[1][((q) >> 16) & 255] ^ sl[2][((q) >> 24) & 255])
+#  define DO_CRC8(q) (sl[3][(q) & 255] ^ sl[4][((q) >> 8) & 255] ^ \
+		      sl[5][((q) >> 16) & 255] ^ sl[6][((q) >> 24) & 255])
 # endif
 
 /* ========================================================================= */
@@ -181,6 +244,14 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     const uint32_t *tab = crc_table;
     const uint32_t *b =(const uint32_t *)buf;
     size_t rem_len;
+#ifdef CRC32_SLICE_BY_8
+    const uint32_t (*sl)[256] = crc_table_slice;
+    uint32_t q;
+#endif
+#if defined(CONFIG_ARM64) && !defined(USE_HOSTCC)
+    if (crc32_arm64_present())
+	 return crc32_arm64(crc, buf, len);
+#endif
 #ifdef DYNAMIC_CRC_TABLE
     if (crc_table_empty)
       make_crc_table();
@@ -195,6 +266,17 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 	 b = (uint32_t *)p;
     }
 
+#ifdef CRC32_SLICE_BY_8
+    rem_len = len & 7;
+    len = len >> 3;
+    for (--b; len; --len) {
+	 /* two 32 bit loads, eight table lookups per 8 bytes */
+	 q = crc ^ *++b; /* use pre increment for speed */
+	 crc = DO_CRC8(q);
+	 q = *++b;
+	 crc ^= DO_CRC4(q);
+    }
+#else
     rem_len = len & 3;
     len = len >> 2;
     for (--b; len; --len) {
@@ -205,6 +287,7 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
 	 DO_CRC(0);
 	 DO_CRC(0);
     }
+#endif
     len = rem_len;
     /* And the last few bytes */
     if (len) {
@@ -217,6 +300,8 @@ uint32_t ZEXPORT crc32_no_comp(uint32_t crc, const Bytef *buf, uInt len)
     return le32_to_cpu(crc);
 }
 #undef DO_CRC
+#undef DO_CRC4
+#undef DO_CRC8
 
 uint32_t ZEXPORT crc32 (uint32_t crc, const Bytef *p, uInt len)
 {
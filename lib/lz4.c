@@ -0,0 +1,261 @@
+/*
+ * LZ4 decompression
+ *
+ * Block format and frame format as documented in lz4_Block_format.md and
+ * lz4_Frame_format.md of the LZ4 project, plus the legacy format written
+ * by "lz4 -l" that the Linux kernel uses for compressed images.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <lz4.h>
+
+#define LZ4_SKIPPABLE_MAGIC	0x184D2A50	/* low nibble is free */
+#define LZ4_SKIPPABLE_MASK	0xFFFFFFF0
+
+#define LZ4_LEGACY_BLOCK_SIZE	(8 << 20)
+
+/* Frame descriptor flags */
+#define LZ4_FLG_VERSION_MASK	0xc0
+#define LZ4_FLG_VERSION		0x40
+#define LZ4_FLG_BLOCK_CSUM	0x10
+#define LZ4_FLG_CONTENT_SIZE	0x08
+#define LZ4_FLG_CONTENT_CSUM	0x04
+#define LZ4_FLG_DICT_ID		0x01
+
+#define LZ4_BLOCK_UNCOMPRESSED	0x80000000
+
+#define MINMATCH		4
+#define RUN_MASK		15
+
+/* Room needed past a copy to do it in whole 8/16 byte steps */
+#define COPY_SLACK		16
+
+static inline u32 lz4_le32(const u8 *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (u32)p[3] << 24;
+}
+
+/* Read the 255-terminated extension of a length field */
+static inline int lz4_ext_len(const u8 **ip, const u8 *iend, size_t *len)
+{
+	unsigned int s;
+
+	do {
+		if (*ip >= iend)
+			return -EPROTO;
+		s = *(*ip)++;
+		*len += s;
+	} while (s == 255);
+
+	return 0;
+}
+
+/*
+ * Decode one block from @src into @op. Matches may reach back to @base,
+ * which lets linked blocks refer to the blocks before them.
+ */
+static int lz4_block(const u8 *src, size_t srcn, u8 *base, u8 **opp,
+		     u8 *oend)
+{
+	const u8 *ip = src;
+	const u8 *const iend = src + srcn;
+	u8 *op = *opp;
+
+	for (;;) {
+		unsigned int token;
+		const u8 *match;
+		size_t len, offset;
+
+		if (ip >= iend)
+			return -EPROTO;
+		token = *ip++;
+
+		/* Literals */
+		len = token >> 4;
+		if (len == RUN_MASK && lz4_ext_len(&ip, iend, &len))
+			return -EPROTO;
+		if (len > iend - ip)
+			return -EPROTO;
+		if (len > oend - op)
+			return -ENOBUFS;
+		if (len <= COPY_SLACK && iend - ip >= COPY_SLACK &&
+		    oend - op >= COPY_SLACK)
+			memcpy(op, ip, COPY_SLACK);
+		else
+			memcpy(op, ip, len);
+		op += len;
+		ip += len;
+
+		/* The last sequence has literals only */
+		if (ip == iend)
+			break;
+
+		/* Match */
+		if (iend - ip < 2)
+			return -EPROTO;
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		if (!offset || offset > op - base)
+			return -EPROTO;
+		match = op - offset;
+
+		len = token & RUN_MASK;
+		if (len == RUN_MASK && lz4_ext_len(&ip, iend, &len))
+			return -EPROTO;
+		len += MINMATCH;
+		if (len > oend - op)
+			return -ENOBUFS;
+
+		if (offset >= 8 && oend - op >= len + COPY_SLACK) {
+			u8 *cpy = op + len;
+
+			do {
+				memcpy(op, match, 8);
+				op += 8;
+				match += 8;
+			} while (op < cpy);
+			op = cpy;
+		} else {
+			/* Overlapping copy repeats the last @offset bytes */
+			while (len--)
+				*op++ = *match++;
+		}
+	}
+
+	*opp = op;
+	return 0;
+}
+
+static int lz4_frame(const u8 **inp, const u8 *end, u8 **opp, u8 *oend)
+{
+	const u8 *in = *inp;
+	u8 *base = *opp;
+	unsigned int flg;
+	size_t hdr_len;
+	int ret;
+
+	if (end - in < 3)
+		return -EPROTO;
+	flg = in[0];
+	if ((flg & LZ4_FLG_VERSION_MASK) != LZ4_FLG_VERSION)
+		return -EINVAL;
+	/* An external dictionary is not available here */
+	if (flg & LZ4_FLG_DICT_ID)
+		return -EINVAL;
+
+	/* FLG, BD, optional content size, header checksum */
+	hdr_len = 3 + (flg & LZ4_FLG_CONTENT_SIZE ? 8 : 0);
+	if (end - in < hdr_len)
+		return -EPROTO;
+	in += hdr_len;
+
+	for (;;) {
+		u32 size;
+
+		if (end - in < 4)
+			return -EPROTO;
+		size = lz4_le32(in);
+		in += 4;
+		if (!size)
+			break;
+
+		if (size & LZ4_BLOCK_UNCOMPRESSED) {
+			size &= ~LZ4_BLOCK_UNCOMPRESSED;
+			if (size > end - in)
+				return -EPROTO;
+			if (size > oend - *opp)
+				return -ENOBUFS;
+			memcpy(*opp, in, size);
+			*opp += size;
+		} else {
+			if (size > end - in)
+				return -EPROTO;
+			ret = lz4_block(in, size, base, opp, oend);
+			if (ret)
+				return ret;
+		}
+		in += size;
+
+		if (flg & LZ4_FLG_BLOCK_CSUM)
+			in += 4;
+	}
+
+	if (flg & LZ4_FLG_CONTENT_CSUM)
+		in += 4;
+	if (in > end)
+		return -EPROTO;
+
+	*inp = in;
+	return 0;
+}
+
+/*
+ * Legacy streams are a series of independent blocks of up to 8 MiB
+ * without an end mark. They end with the input, at the next stream's
+ * magic, or at a word that can't be a block size (kbuild appends the
+ * decompressed size to the kernel).
+ */
+static int lz4_legacy(const u8 **inp, const u8 *end, u8 **opp, u8 *oend)
+{
+	const u8 *in = *inp;
+	int ret;
+
+	while (end - in >= 4) {
+		u32 size = lz4_le32(in);
+
+		if (size == LZ4_LEGACY_MAGIC || size > end - in - 4)
+			break;
+		in += 4;
+
+		ret = lz4_block(in, size, *opp, opp, oend);
+		if (ret)
+			return ret;
+		in += size;
+	}
+
+	*inp = in;
+	return 0;
+}
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *in = src;
+	const u8 *const end = in + srcn;
+	u8 *op = dst;
+	u8 *const oend = op + *dstn;
+	int streams = 0;
+	int ret = 0;
+
+	while (end - in >= 4) {
+		u32 magic = lz4_le32(in);
+
+		if (magic == LZ4_MAGIC) {
+			in += 4;
+			ret = lz4_frame(&in, end, &op, oend);
+		} else if (magic == LZ4_LEGACY_MAGIC) {
+			in += 4;
+			ret = lz4_legacy(&in, end, &op, oend);
+		} else if ((magic & LZ4_SKIPPABLE_MASK) == LZ4_SKIPPABLE_MAGIC) {
+			if (end - in < 8 || lz4_le32(in + 4) > end - in - 8)
+				return -EPROTO;
+			in += 8 + lz4_le32(in + 4);
+			continue;
+		} else {
+			/* Trailing data after the last stream */
+			break;
+		}
+
+		if (ret)
+			return ret;
+		streams++;
+	}
+
+	if (!streams)
+		return -EINVAL;
+
+	*dstn = op - (u8 *)dst;
+	return 0;
+}
@@ -37,6 +37,10 @@
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <u-boot/sha1.h>
+#if defined(CONFIG_ARM64) && !defined(USE_HOSTCC)
+#include <asm/armv8/sha_ce.h>
+#define SHA1_CE
+#endif
 
 /*
  * 32-bit integer manipulation macros (big endian)
@@ -227,6 +231,32 @@ static void sha1_process(sha1_context *ctx, const unsigned char data[64])
 	ctx->state[4] += E;
 }
 
+/*
+ * Process whole blocks, with the ARMv8 SHA-1 instructions if present
+ */
+static void sha1_blocks(sha1_context *ctx, const unsigned char *data,
+			unsigned int blocks)
+{
+#ifdef SHA1_CE
+	if (sha1_ce_present()) {
+		uint32_t state[5];
+		int i;
+
+		/* sha1_context keeps the state in unsigned longs */
+		for (i = 0; i < 5; i++)
+			state[i] = ctx->state[i];
+		sha1_ce_transform(state, data, blocks);
+		for (i = 0; i < 5; i++)
+			ctx->state[i] = state[i];
+		return;
+	}
+#endif
+	while (blocks--) {
+		sha1_process(ctx, data);
+		data += 64;
+	}
+}
+
 /*
  * SHA-1 process buffer
  */
@@ -250,16 +280,16 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
 
 	if (left && ilen >= fill) {
 		memcpy ((void *) (ctx->buffer + left), (void *) input, fill);
-		sha1_process (ctx, ctx->buffer);
+		sha1_blocks(ctx, ctx->buffer, 1);
 		input += fill;
 		ilen -= fill;
 		left = 0;
 	}
 
-	while (ilen >= 64) {
-		sha1_process (ctx, input);
-		input += 64;
-		ilen -= 64;
+	if (ilen >= 64) {
+		sha1_blocks(ctx, input, ilen / 64);
+		input += ilen & ~0x3F;
+		ilen &= 0x3F;
 	}
 
 	if (ilen > 0) {
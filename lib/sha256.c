@@ -14,6 +14,10 @@
 #endif /* USE_HOSTCC */
 #include <watchdog.h>
 #include <u-boot/sha256.h>
+#if defined(CONFIG_ARM64) && !defined(USE_HOSTCC)
+#include <asm/armv8/sha_ce.h>
+#define SHA256_CE
+#endif
 
 /*
  * 32-bit integer manipulation macros (big endian)
@@ -181,6 +185,22 @@ static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 	ctx->state[7] += H;
 }
 
+/* Process whole blocks, with the ARMv8 SHA-256 instructions if present */
+static void sha256_blocks(sha256_context *ctx, const uint8_t *data,
+			  uint32_t blocks)
+{
+#ifdef SHA256_CE
+	if (sha256_ce_present()) {
+		sha256_ce_transform(ctx->state, data, blocks);
+		return;
+	}
+#endif
+	while (blocks--) {
+		sha256_process(ctx, data);
+		data += 64;
+	}
+}
+
 void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 {
 	uint32_t left, fill;
@@ -199,16 +219,16 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 
 	if (left && length >= fill) {
 		memcpy((void *) (ctx->buffer + left), (void *) input, fill);
-		sha256_process(ctx, ctx->buffer);
+		sha256_blocks(ctx, ctx->buffer, 1);
 		length -= fill;
 		input += fill;
 		left = 0;
 	}
 
-	while (length >= 64) {
-		sha256_process(ctx, input);
-		length -= 64;
-		input += 64;
+	if (length >= 64) {
+		sha256_blocks(ctx, input, length / 64);
+		input += length & ~0x3F;
+		length &= 0x3F;
 	}
 
 	if (length)
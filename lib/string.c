@@ -19,6 +19,7 @@
 #include <linux/string.h>
 #include <linux/ctype.h>
 #include <malloc.h>
+#include <asm/byteorder.h>
 
 
 /**
@@ -436,24 +437,29 @@ char *strswab(const char *s)
  */
 void * memset(void * s,int c,size_t count)
 {
-	unsigned long *sl = (unsigned long *) s;
+	unsigned long *sl;
 	unsigned long cl = 0;
-	char *s8;
+	char *s8 = (char *)s;
 	int i;
 
-	/* do it one word at a time (32 bits or 64 bits) while possible */
-	if ( ((ulong)s & (sizeof(*sl) - 1)) == 0) {
+	/* head a byte at a time, then one word at a time (32 bits or 64 bits) */
+	if (count >= 2 * sizeof(*sl)) {
+		while ((ulong)s8 & (sizeof(*sl) - 1)) {
+			*s8++ = c;
+			count--;
+		}
 		for (i = 0; i < sizeof(*sl); i++) {
 			cl <<= 8;
 			cl |= c & 0xff;
 		}
+		sl = (unsigned long *)s8;
 		while (count >= sizeof(*sl)) {
 			*sl++ = cl;
 			count -= sizeof(*sl);
 		}
+		s8 = (char *)sl;
 	}
 	/* fill 8 bits at a time */
-	s8 = (char *)sl;
 	while (count--)
 		*s8++ = c;
 
@@ -485,6 +491,66 @@ char * bcopy(const char * src, char * dest, int count)
 }
 #endif
 
+/* the word at @shift bits into @lo, continued in @hi (0 < @shift < bits) */
+#ifdef __BIG_ENDIAN
+#define MERGE_WORDS(lo, hi, shift) \
+	(((lo) << (shift)) | ((hi) >> (8 * sizeof(long) - (shift))))
+#else
+#define MERGE_WORDS(lo, hi, shift) \
+	(((lo) >> (shift)) | ((hi) << (8 * sizeof(long) - (shift))))
+#endif
+
+/*
+ * Forward copy for memcpy() and memmove(). It never writes a byte before
+ * it has read all source bytes at lower addresses, so it may be used when
+ * dest lies below an overlapping src.
+ */
+static inline void *copy_forward(void *dest, const void *src, size_t count)
+{
+	unsigned long *dl, *sl, lo, hi;
+	char *d8 = (char *)dest, *s8 = (char *)src;
+	int shift;
+
+	if (count >= 2 * sizeof(*dl)) {
+		/* align the destination a byte at a time */
+		while ((ulong)d8 & (sizeof(*dl) - 1)) {
+			*d8++ = *s8++;
+			count--;
+		}
+		dl = (unsigned long *)d8;
+		shift = ((ulong)s8 & (sizeof(*dl) - 1)) * 8;
+		if (!shift) {
+			/* source aligned too (common case), a word at a time */
+			sl = (unsigned long *)s8;
+			while (count >= sizeof(*dl)) {
+				*dl++ = *sl++;
+				count -= sizeof(*dl);
+			}
+			s8 = (char *)sl;
+		} else {
+			/*
+			 * read aligned source words and shift each output
+			 * word together from two of them, no unaligned access
+			 */
+			sl = (unsigned long *)(s8 - shift / 8);
+			lo = *sl++;
+			while (count >= sizeof(*dl)) {
+				hi = *sl++;
+				*dl++ = MERGE_WORDS(lo, hi, shift);
+				lo = hi;
+				count -= sizeof(*dl);
+			}
+			s8 = (char *)(sl - 1) + shift / 8;
+		}
+		d8 = (char *)dl;
+	}
+	/* copy the rest one byte at a time */
+	while (count--)
+		*d8++ = *s8++;
+
+	return dest;
+}
+
 #ifndef __HAVE_ARCH_MEMCPY
 /**
  * memcpy - Copy one area of memory to another
@@ -497,26 +563,10 @@ char * bcopy(const char * src, char * dest, int count)
  */
 void * memcpy(void *dest, const void *src, size_t count)
 {
-	unsigned long *dl = (unsigned long *)dest, *sl = (unsigned long *)src;
-	char *d8, *s8;
-
 	if (src == dest)
 		return dest;
 
-	/* while all data is aligned (common case), copy a word at a time */
-	if ( (((ulong)dest | (ulong)src) & (sizeof(*dl) - 1)) == 0) {
-		while (count >= sizeof(*dl)) {
-			*dl++ = *sl++;
-			count -= sizeof(*dl);
-		}
-	}
-	/* copy the reset one byte at a time */
-	d8 = (char *)dl;
-	s8 = (char *)sl;
-	while (count--)
-		*d8++ = *s8++;
-
-	return dest;
+	return copy_forward(dest, src, count);
 }
 #endif
 
@@ -531,23 +581,35 @@ void * memcpy(void *dest, const void *src, size_t count)
  */
 void * memmove(void * dest,const void *src,size_t count)
 {
+	unsigned long *dl, *sl;
 	char *tmp, *s;
 
 	if (src == dest)
 		return dest;
 
-	if (dest <= src) {
-		tmp = (char *) dest;
-		s = (char *) src;
-		while (count--)
-			*tmp++ = *s++;
-		}
-	else {
-		tmp = (char *) dest + count;
-		s = (char *) src + count;
-		while (count--)
+	if (dest <= src || (char *)dest >= (char *)src + count)
+		return copy_forward(dest, src, count);
+
+	tmp = (char *) dest + count;
+	s = (char *) src + count;
+	/* backwards a word at a time while both ends are aligned */
+	if (count >= 2 * sizeof(*dl) &&
+	    (((ulong)tmp ^ (ulong)s) & (sizeof(*dl) - 1)) == 0) {
+		while ((ulong)tmp & (sizeof(*dl) - 1)) {
 			*--tmp = *--s;
+			count--;
 		}
+		dl = (unsigned long *)tmp;
+		sl = (unsigned long *)s;
+		while (count >= sizeof(*dl)) {
+			*--dl = *--sl;
+			count -= sizeof(*dl);
+		}
+		tmp = (char *)dl;
+		s = (char *)sl;
+	}
+	while (count--)
+		*--tmp = *--s;
 
 	return dest;
 }
@@ -562,10 +624,26 @@ void * memmove(void * dest,const void *src,size_t count)
  */
 int memcmp(const void * cs,const void * ct,size_t count)
 {
+	const unsigned long *l1, *l2;
 	const unsigned char *su1, *su2;
 	int res = 0;
 
-	for( su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+	su1 = cs;
+	su2 = ct;
+	/* skip equal words while both are aligned, the bytes decide */
+	if ((((ulong)su1 | (ulong)su2) & (sizeof(*l1) - 1)) == 0) {
+		l1 = (const unsigned long *)su1;
+		l2 = (const unsigned long *)su2;
+		while (count >= sizeof(*l1) && *l1 == *l2) {
+			l1++;
+			l2++;
+			count -= sizeof(*l1);
+		}
+		su1 = (const unsigned char *)l1;
+		su2 = (const unsigned char *)l2;
+	}
+
+	for (; 0 < count; ++su1, ++su2, count--)
 		if ((res = *su1 - *su2) != 0)
 			break;
 	return res;
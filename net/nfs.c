@@ -26,6 +26,7 @@
 #include <command.h>
 #include <net.h>
 #include <malloc.h>
+#include <asm/io.h>
 #include "nfs.h"
 #include "bootp.h"
 
@@ -39,15 +40,61 @@
 
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
+#define NFS_RPC_MISMATCH	125	/* server does not speak our version */
+
+/* Words of a v3 READ reply ahead of the data, RPC header included */
+#define NFS3_READ_REPLY_HDR	(6 + 1 + 22 + 3)
+
+/*
+ * Largest v3 READ: the server's rtmax permitting, as much as fits the
+ * IP reassembly buffer, or a single frame without reassembly.
+ */
+#ifdef CONFIG_IP_DEFRAG
+#ifndef CONFIG_NET_MAXDEFRAG
+#define CONFIG_NET_MAXDEFRAG 16384
+#endif
+/* net.c sizes its reassembly buffer the same way */
+#define NFS3_READ_MAX	((CONFIG_NET_MAXDEFRAG + \
+			  sizeof(((struct rpc_t *)0)->u.reply) - \
+			  IP_UDP_HDR_SIZE - NFS3_READ_REPLY_HDR * 4) & ~1023)
+#else
+#define NFS3_READ_MAX	1024
+#endif
+
+#if NFS_READ_SIZE > NFS_MAXDATA
+#define NFS2_READ_SIZE	NFS_MAXDATA
+#else
+#define NFS2_READ_SIZE	NFS_READ_SIZE
+#endif
+
+enum nfs_version {
+	NFS_V2 = 2,
+	NFS_V3 = 3,
+};
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
+static unsigned int nfs_offset;	/* next offset to ask for */
 static ulong nfs_timeout = NFS_TIMEOUT;
-
-static char dirfh[NFS_FHSIZE];	/* file handle of directory */
-static char filefh[NFS_FHSIZE]; /* file handle of kernel image */
+static enum nfs_version nfs_version;
+
+static char dirfh[NFS3_FHSIZE];	/* file handle of directory */
+static int dirfh_len;
+static char filefh[NFS3_FHSIZE]; /* file handle of kernel image */
+static int filefh_len;
+
+/* READs in flight; replies may come back in any order */
+static struct nfs_read_slot {
+	uint32_t id;		/* RPC xid, 0 if the slot is free */
+	unsigned int offset;
+	unsigned int len;
+} nfs_slots[NFS_MAX_WINDOW];
+static int nfs_window;		/* slots in use at most */
+static int nfs_in_flight;
+static unsigned int nfs_read_size;
+static unsigned int nfs_file_end;	/* file size, once a reply shows it */
+static unsigned int nfs_received;	/* bytes stored so far */
+static unsigned int nfs_hashes;		/* progress marks printed */
 
 static enum net_loop_state nfs_download_state;
 static IPaddr_t NfsServerIP;
@@ -63,6 +110,7 @@ static int	NfsState;
 #define STATE_LOOKUP_REQ		5
 #define STATE_READ_REQ			6
 #define STATE_READLINK_REQ		7
+#define STATE_FSINFO_REQ		8
 
 static char default_filename[64];
 static char *nfs_filename;
@@ -93,7 +141,10 @@ store_block(uchar *src, unsigned offset, unsigned len)
 	} else
 #endif /* CONFIG_SYS_DIRECT_FLASH_NFS */
 	{
-		(void)memcpy((void *)(load_addr + offset), src, len);
+		void *ptr = map_sysmem(load_addr + offset, len);
+
+		memcpy(ptr, src, len);
+		unmap_sysmem(ptr);
 	}
 
 	if (NetBootFileXferSize < (offset+len))
@@ -174,7 +225,7 @@ static long *rpc_add_credentials(long *p)
 /**************************************************************************
 RPC_LOOKUP - Lookup RPC Port numbers
 **************************************************************************/
-static void
+static uint32_t
 rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 {
 	struct rpc_t pkt;
@@ -188,7 +239,12 @@ rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 	pkt.u.call.type = htonl(MSG_CALL);
 	pkt.u.call.rpcvers = htonl(2);	/* use RPC version 2 */
 	pkt.u.call.prog = htonl(rpc_prog);
-	pkt.u.call.vers = htonl(2);	/* portmapper is version 2 */
+	if (rpc_prog == PROG_PORTMAP)
+		pkt.u.call.vers = htonl(2);	/* portmapper is version 2 */
+	else if (rpc_prog == PROG_MOUNT)
+		pkt.u.call.vers = htonl(nfs_version == NFS_V3 ? 3 : 1);
+	else
+		pkt.u.call.vers = htonl(nfs_version);
 	pkt.u.call.proc = htonl(rpc_proc);
 	p = (uint32_t *)&(pkt.u.call.data);
 
@@ -209,6 +265,8 @@ rpc_req(int rpc_prog, int rpc_proc, uint32_t *data, int datalen)
 
 	NetSendUDPPacket(NetServerEther, NfsServerIP, sport, NfsOurPort,
 		pktlen);
+
+	return id;
 }
 
 /**************************************************************************
@@ -278,6 +336,19 @@ nfs_umountall_req(void)
 	rpc_req(PROG_MOUNT, MOUNT_UMOUNTALL, data, len);
 }
 
+/* Add a file handle: fixed size in v2, counted opaque in v3 */
+static uint32_t *
+nfs_add_fh(uint32_t *p, const char *fh, int fhlen)
+{
+	if (nfs_version == NFS_V3)
+		*p++ = htonl(fhlen);
+	if (fhlen & 3)
+		*(p + fhlen / 4) = 0;
+	memcpy(p, fh, fhlen);
+
+	return p + (fhlen + 3) / 4;
+}
+
 /***************************************************************************
  * NFS_READLINK (AH 2003-07-14)
  * This procedure is called when read of the first block fails -
@@ -295,8 +366,7 @@ nfs_readlink_req(void)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, filefh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, filefh, filefh_len);
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
@@ -319,8 +389,7 @@ nfs_lookup_req(char *fname)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, dirfh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
+	p = nfs_add_fh(p, dirfh, dirfh_len);
 	*p++ = htonl(fnamelen);
 	if (fnamelen & 3)
 		*(p + fnamelen / 4) = 0;
@@ -329,14 +398,35 @@ nfs_lookup_req(char *fname)
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_LOOKUP, data, len);
+	rpc_req(PROG_NFS, nfs_version == NFS_V3 ? NFS3PROC_LOOKUP : NFS_LOOKUP,
+		data, len);
 }
 
 /**************************************************************************
-NFS_READ - Read File on NFS Server
+NFS3_FSINFO - Ask for the largest READ the server takes
 **************************************************************************/
 static void
-nfs_read_req(int offset, int readlen)
+nfs_fsinfo_req(void)
+{
+	uint32_t data[1024];
+	uint32_t *p;
+	int len;
+
+	p = &(data[0]);
+	p = (uint32_t *)rpc_add_credentials((long *)p);
+
+	p = nfs_add_fh(p, filefh, filefh_len);
+
+	len = (uint32_t *)p - (uint32_t *)&(data[0]);
+
+	rpc_req(PROG_NFS, NFS3PROC_FSINFO, data, len);
+}
+
+/**************************************************************************
+NFS_READ - Read File on NFS Server
+**************************************************************************/
+static uint32_t
+nfs_read_req(unsigned int offset, unsigned int readlen)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -345,15 +435,70 @@ nfs_read_req(int offset, int readlen)
 	p = &(data[0]);
 	p = (uint32_t *)rpc_add_credentials((long *)p);
 
-	memcpy(p, filefh, NFS_FHSIZE);
-	p += (NFS_FHSIZE / 4);
-	*p++ = htonl(offset);
-	*p++ = htonl(readlen);
-	*p++ = 0;
+	p = nfs_add_fh(p, filefh, filefh_len);
+	if (nfs_version == NFS_V3) {
+		*p++ = 0;		/* offset is 64 bits */
+		*p++ = htonl(offset);
+		*p++ = htonl(readlen);
+	} else {
+		*p++ = htonl(offset);
+		*p++ = htonl(readlen);
+		*p++ = 0;		/* totalcount, unused */
+	}
 
 	len = (uint32_t *)p - (uint32_t *)&(data[0]);
 
-	rpc_req(PROG_NFS, NFS_READ, data, len);
+	return rpc_req(PROG_NFS, NFS_READ, data, len);
+}
+
+/* Keep up to nfs_window READs in flight, stopping at the end of file */
+static void
+nfs_read_fill(void)
+{
+	int i;
+
+	for (i = 0; i < nfs_window && nfs_offset < nfs_file_end; i++) {
+		if (nfs_slots[i].id)
+			continue;
+		nfs_slots[i].offset = nfs_offset;
+		nfs_slots[i].len = nfs_read_size;
+		nfs_slots[i].id = nfs_read_req(nfs_offset, nfs_read_size);
+		nfs_offset += nfs_read_size;
+		nfs_in_flight++;
+	}
+}
+
+/* Send everything in flight again, after a timeout */
+static void
+nfs_read_resend(void)
+{
+	int i;
+
+	for (i = 0; i < nfs_window; i++)
+		if (nfs_slots[i].id)
+			nfs_slots[i].id = nfs_read_req(nfs_slots[i].offset,
+						       nfs_slots[i].len);
+}
+
+static void
+nfs_read_start(void)
+{
+	char *ep;
+
+	memset(nfs_slots, 0, sizeof(nfs_slots));
+	nfs_in_flight = 0;
+	nfs_offset = 0;
+	nfs_received = 0;
+	nfs_hashes = 0;
+	nfs_file_end = ~0U;
+
+	nfs_window = CONFIG_NFS_WINDOWSIZE;
+	ep = getenv("nfswindowsize");
+	if (ep)
+		nfs_window = simple_strtol(ep, NULL, 10);
+	nfs_window = max(1, min(nfs_window, NFS_MAX_WINDOW));
+
+	nfs_read_fill();
 }
 
 /**************************************************************************
@@ -367,10 +512,10 @@ NfsSend(void)
 
 	switch (NfsState) {
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
-		rpc_lookup_req(PROG_MOUNT, 1);
+		rpc_lookup_req(PROG_MOUNT, nfs_version == NFS_V3 ? 3 : 1);
 		break;
 	case STATE_PRCLOOKUP_PROG_NFS_REQ:
-		rpc_lookup_req(PROG_NFS, 2);
+		rpc_lookup_req(PROG_NFS, nfs_version);
 		break;
 	case STATE_MOUNT_REQ:
 		nfs_mount_req(nfs_path);
@@ -381,8 +526,11 @@ NfsSend(void)
 	case STATE_LOOKUP_REQ:
 		nfs_lookup_req(nfs_filename);
 		break;
+	case STATE_FSINFO_REQ:
+		nfs_fsinfo_req();
+		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -394,6 +542,30 @@ NfsSend(void)
 Handlers for the reply from server
 **************************************************************************/
 
+/* Skip a v3 post_op_attr: a flag, then the attributes if it is set */
+static uint32_t *
+nfs3_skip_attr(uint32_t *p)
+{
+	return p + (*p ? 1 + 21 : 1);
+}
+
+/* Copy a file handle out of a LOOKUP or MNT reply */
+static int
+nfs_get_fh(uint32_t *p, char *fh, int *fhlen)
+{
+	int len = NFS_FHSIZE;
+
+	if (nfs_version == NFS_V3) {
+		len = ntohl(*p++);
+		if (len > NFS3_FHSIZE)
+			return -1;
+	}
+	memcpy(fh, p, len);
+	*fhlen = len;
+
+	return 0;
+}
+
 static int
 rpc_lookup_reply(int prog, uchar *pkt, unsigned len)
 {
@@ -413,6 +585,7 @@ rpc_lookup_reply(int prog, uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.astatus)
 		return -1;
 
+	/* port 0: the version we asked for is not registered */
 	switch (prog) {
 	case PROG_MOUNT:
 		NfsSrvMountPort = ntohl(rpc_pkt.u.reply.data[0]);
@@ -439,14 +612,17 @@ nfs_mount_reply(uchar *pkt, unsigned len)
 	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
 		return -NFS_RPC_DROP;
 
+	if (ntohl(rpc_pkt.u.reply.astatus) == NFS_RPC_PROG_MISMATCH)
+		return -NFS_RPC_MISMATCH;
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
 	    rpc_pkt.u.reply.astatus  ||
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
+	if (nfs_get_fh(rpc_pkt.u.reply.data + 1, dirfh, &dirfh_len))
+		return -1;
 	fs_mounted = 1;
-	memcpy(dirfh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
 
 	return 0;
 }
@@ -496,7 +672,37 @@ nfs_lookup_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
-	memcpy(filefh, rpc_pkt.u.reply.data + 1, NFS_FHSIZE);
+	return nfs_get_fh(rpc_pkt.u.reply.data + 1, filefh, &filefh_len);
+}
+
+static int
+nfs_fsinfo_reply(uchar *pkt, unsigned len)
+{
+	struct rpc_t rpc_pkt;
+	uint32_t *p;
+	unsigned int rtmax;
+
+	debug("%s\n", __func__);
+
+	memcpy((unsigned char *)&rpc_pkt, pkt,
+	       min_t(unsigned, len, sizeof(rpc_pkt)));
+
+	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
+		return -NFS_RPC_ERR;
+	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+		return -NFS_RPC_DROP;
+
+	if (rpc_pkt.u.reply.rstatus  ||
+	    rpc_pkt.u.reply.verifier ||
+	    rpc_pkt.u.reply.astatus  ||
+	    rpc_pkt.u.reply.data[0])
+		return -1;
+
+	/* obj_attributes, then rtmax */
+	p = nfs3_skip_attr(rpc_pkt.u.reply.data + 1);
+	rtmax = ntohl(*p);
+	if (rtmax >= 1024 && rtmax < nfs_read_size)
+		nfs_read_size = rtmax & ~1023;
 
 	return 0;
 }
@@ -505,6 +711,7 @@ static int
 nfs_readlink_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
+	uint32_t *p;
 	int rlen;
 
 	debug("%s\n", __func__);
@@ -522,36 +729,61 @@ nfs_readlink_reply(uchar *pkt, unsigned len)
 	    rpc_pkt.u.reply.data[0])
 		return -1;
 
-	rlen = ntohl(rpc_pkt.u.reply.data[1]); /* new path length */
+	p = rpc_pkt.u.reply.data + 1;
+	if (nfs_version == NFS_V3)
+		p = nfs3_skip_attr(p);	/* symlink_attributes */
+	rlen = ntohl(*p++); /* new path length */
 
-	if (*((char *)&(rpc_pkt.u.reply.data[2])) != '/') {
+	if (*((char *)p) != '/') {
 		int pathlen;
 		strcat(nfs_path, "/");
 		pathlen = strlen(nfs_path);
-		memcpy(nfs_path + pathlen, (uchar *)&(rpc_pkt.u.reply.data[2]),
-			rlen);
+		memcpy(nfs_path + pathlen, (uchar *)p, rlen);
 		nfs_path[pathlen + rlen] = 0;
 	} else {
-		memcpy(nfs_path, (uchar *)&(rpc_pkt.u.reply.data[2]), rlen);
+		memcpy(nfs_path, (uchar *)p, rlen);
 		nfs_path[rlen] = 0;
 	}
 	return 0;
 }
 
+static void
+nfs_show_progress(unsigned int rlen)
+{
+	unsigned int hash = (NFS_READ_SIZE / 2) * 10;
+
+	nfs_received += rlen;
+	while (nfs_hashes < nfs_received / hash) {
+		if (nfs_hashes && !(nfs_hashes % HASHES_PER_LINE))
+			puts("\n\t ");
+		putc('#');
+		nfs_hashes++;
+	}
+}
+
+/*
+ * Store the data of a READ reply at the offset its request asked for.
+ * Returns the number of bytes read, or a negative NFS error.
+ */
 static int
 nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot = NULL;
+	uint32_t *p;
+	uchar *data;
+	int rlen, eof, i;
 
 	debug("%s\n", __func__);
 
 	memcpy((uchar *)&rpc_pkt, pkt, sizeof(rpc_pkt.u.reply));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
-		return -NFS_RPC_DROP;
+	for (i = 0; i < nfs_window; i++)
+		if (nfs_slots[i].id &&
+		    nfs_slots[i].id == ntohl(rpc_pkt.u.reply.id))
+			slot = &nfs_slots[i];
+	if (!slot)
+		return -NFS_RPC_DROP;	/* resent, or read past the end */
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -564,17 +796,45 @@ nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
+	if (nfs_version == NFS_V3) {
+		/* file_attributes, count, eof, then the opaque data */
+		if (len < (6 + 1 + 1 + 3) * 4)
+			return -9999;
+		/* pkt is only 2-byte aligned, read the words from a copy */
+		memcpy((uchar *)&rpc_pkt, pkt,
+		       min_t(unsigned, len, (6 + 1 + 1 + 21 + 3) * 4));
+		p = nfs3_skip_attr(rpc_pkt.u.reply.data + 1);
+		rlen = ntohl(p[0]);
+		eof = p[1] != 0;
+		data = pkt + ((uchar *)(p + 3) - (uchar *)&rpc_pkt);
+	} else {
+		rlen = ntohl(rpc_pkt.u.reply.data[18]);
+		eof = 0;
+		data = pkt + sizeof(rpc_pkt.u.reply);
+	}
+	if (rlen > slot->len || data + rlen > pkt + len)
+		return -9999;
 
-	rlen = ntohl(rpc_pkt.u.reply.data[18]);
-	if (store_block((uchar *)pkt + sizeof(rpc_pkt.u.reply),
-			nfs_offset, rlen))
+	if (store_block(data, slot->offset, rlen))
 		return -9999;
 
+	nfs_show_progress(rlen);
+
+	/*
+	 * A short v2 read is the end of file. v3 says where the file ends
+	 * and may return less without being there: ask again for the rest.
+	 */
+	if (eof || !rlen || (rlen < slot->len && nfs_version == NFS_V2)) {
+		nfs_file_end = min(nfs_file_end, slot->offset + rlen);
+	} else if (rlen < slot->len) {
+		slot->offset += rlen;
+		slot->len -= rlen;
+		slot->id = nfs_read_req(slot->offset, slot->len);
+		return rlen;
+	}
+	slot->id = 0;
+	nfs_in_flight--;
+
 	return rlen;
 }
 
@@ -596,6 +856,32 @@ NfsTimeout(void)
 	}
 }
 
+/* The server does not speak NFSv3: start over with v2 */
+static int
+nfs_fallback_v2(void)
+{
+	if (nfs_version != NFS_V3)
+		return 0;
+
+	debug("NFSv3 not available, trying NFSv2\n");
+	nfs_version = NFS_V2;
+	NfsSrvMountPort = 0;
+	NfsSrvNfsPort = 0;
+	NfsState = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+	NfsSend();
+
+	return 1;
+}
+
+static void
+nfs_start_reading(void)
+{
+	NfsState = STATE_READ_REQ;
+	nfs_read_start();
+	debug("NFSv%d, %u byte READs, %d in flight\n", nfs_version,
+	      nfs_read_size, nfs_window);
+}
+
 static void
 NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 {
@@ -611,6 +897,8 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 	case STATE_PRCLOOKUP_PROG_MOUNT_REQ:
 		if (rpc_lookup_reply(PROG_MOUNT, pkt, len) == -NFS_RPC_DROP)
 			break;
+		if (!NfsSrvMountPort && nfs_fallback_v2())
+			break;
 		NfsState = STATE_PRCLOOKUP_PROG_NFS_REQ;
 		NfsSend();
 		break;
@@ -618,6 +906,8 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 	case STATE_PRCLOOKUP_PROG_NFS_REQ:
 		if (rpc_lookup_reply(PROG_NFS, pkt, len) == -NFS_RPC_DROP)
 			break;
+		if (!NfsSrvNfsPort && nfs_fallback_v2())
+			break;
 		NfsState = STATE_MOUNT_REQ;
 		NfsSend();
 		break;
@@ -626,7 +916,9 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 		reply = nfs_mount_reply(pkt, len);
 		if (reply == -NFS_RPC_DROP)
 			break;
-		else if (reply == -NFS_RPC_ERR) {
+		else if (reply == -NFS_RPC_MISMATCH && nfs_fallback_v2())
+			break;
+		else if (reply) {
 			puts("*** ERROR: Cannot mount\n");
 			/* just to be sure... */
 			NfsState = STATE_UMOUNT_REQ;
@@ -658,14 +950,23 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 			puts("*** ERROR: File lookup fail\n");
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
-		} else {
-			NfsState = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+		} else if (nfs_version == NFS_V3) {
+			nfs_read_size = NFS3_READ_MAX;
+			NfsState = STATE_FSINFO_REQ;
 			NfsSend();
+		} else {
+			nfs_read_size = NFS2_READ_SIZE;
+			nfs_start_reading();
 		}
 		break;
 
+	case STATE_FSINFO_REQ:
+		/* without an answer, keep our own READ size */
+		if (nfs_fsinfo_reply(pkt, len) == -NFS_RPC_DROP)
+			break;
+		nfs_start_reading();
+		break;
+
 	case STATE_READLINK_REQ:
 		reply = nfs_readlink_reply(pkt, len);
 		if (reply == -NFS_RPC_DROP)
@@ -686,17 +987,25 @@ NfsHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src, unsigned len)
 
 	case STATE_READ_REQ:
 		rlen = nfs_read_reply(pkt, len);
+		if (rlen == -NFS_RPC_DROP)
+			break;
 		NetSetTimeout(nfs_timeout, NfsTimeout);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			/* progress: a later loss starts a fresh retry count */
+			NfsTimeoutCount = 0;
+			nfs_read_fill();
+			if (nfs_in_flight)
+				break;
+			nfs_download_state = NETLOOP_SUCCESS;
+			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
-			/* symbolic link */
+			/* symbolic link; the other READs answer the same */
+			memset(nfs_slots, 0, sizeof(nfs_slots));
+			nfs_in_flight = 0;
 			NfsState = STATE_READLINK_REQ;
 			NfsSend();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
 			NfsState = STATE_UMOUNT_REQ;
 			NfsSend();
 		}
@@ -775,6 +1084,9 @@ NfsStart(void)
 
 	NfsTimeoutCount = 0;
 	NfsState = STATE_PRCLOOKUP_PROG_MOUNT_REQ;
+	nfs_version = NFS_V3;
+	NfsSrvMountPort = 0;
+	NfsSrvNfsPort = 0;
 
 	/*NfsOurPort = 4096 + (get_ticks() % 3072);*/
 	/*FIX ME !!!*/
@@ -25,7 +25,15 @@
 #define NFS_READLINK    5
 #define NFS_READ        6
 
+/* NFSv3 renumbered LOOKUP; READLINK and READ keep their numbers */
+#define NFS3PROC_LOOKUP	3
+#define NFS3PROC_FSINFO	19
+
 #define NFS_FHSIZE      32
+#define NFS3_FHSIZE     64
+#define NFS_MAXDATA	8192	/* largest NFSv2 READ */
+
+#define NFS_RPC_PROG_MISMATCH	2	/* accept_stat: version not served */
 
 #define NFSERR_PERM     1
 #define NFSERR_NOENT    2
@@ -44,6 +52,15 @@
 #define NFS_READ_SIZE 1024 /* biggest power of two that fits Ether frame */
 #endif
 
+/*
+ * Most READs the client keeps in flight at once; the environment
+ * variable nfswindowsize overrides the default.
+ */
+#ifndef CONFIG_NFS_WINDOWSIZE
+#define CONFIG_NFS_WINDOWSIZE 1
+#endif
+#define NFS_MAX_WINDOW	16
+
 #define NFS_MAXLINKDEPTH 16
 
 struct rpc_t {
@@ -9,6 +9,7 @@
 #include <common.h>
 #include <command.h>
 #include <net.h>
+#include <asm/io.h>
 #include "tftp.h"
 #include "bootp.h"
 #ifdef CONFIG_SYS_DIRECT_FLASH_TFTP
@@ -78,6 +79,10 @@ static ulong	TftpLastBlock;
 static ulong	TftpBlockWrap;
 /* memory offset due to wrapping */
 static ulong	TftpBlockWrapOffset;
+/* block number that completes the current window and gets ACKed */
+static ulong	TftpNextAck;
+/* last good block we re-ACKed after detecting a gap */
+static ulong	TftpLastNack;
 static int	TftpState;
 #ifdef CONFIG_TFTP_TSIZE
 /* The file size reported by the server */
@@ -130,6 +135,20 @@ static char tftp_filename[MAX_LEN];
 static unsigned short TftpBlkSize = TFTP_BLOCK_SIZE;
 static unsigned short TftpBlkSizeOption = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 windowsize: the server sends this many blocks before waiting
+ * for an ACK, so a transfer costs one round trip per window instead of
+ * one per block. A window of 1 is plain lock-step TFTP.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short TftpWindowSize = 1;
+static unsigned short TftpWindowSizeOption = TFTP_WINDOWSIZE;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -184,7 +203,10 @@ store_block(int block, uchar *src, unsigned len)
 	} else
 #endif /* CONFIG_SYS_DIRECT_FLASH_TFTP */
 	{
-		(void)memcpy((void *)(load_addr + offset), src, len);
+		void *ptr = map_sysmem(load_addr + offset, len);
+
+		memcpy(ptr, src, len);
+		unmap_sysmem(ptr);
 	}
 #ifdef CONFIG_MCAST_TFTP
 	if (Multicast)
@@ -201,6 +223,8 @@ static void new_transfer(void)
 	TftpLastBlock = 0;
 	TftpBlockWrap = 0;
 	TftpBlockWrapOffset = 0;
+	TftpNextAck = TftpWindowSize;
+	TftpLastNack = -1;
 #ifdef CONFIG_CMD_TFTPPUT
 	TftpFinalBlock = 0;
 #endif
@@ -361,6 +385,10 @@ TftpSend(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, TftpBlkSizeOption, 0);
+		/* only reads are windowed, we still send one block per ACK */
+		if (TftpState == STATE_SEND_RRQ && TftpWindowSizeOption > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, TftpWindowSizeOption, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!ProhibitMcast) {
@@ -530,6 +558,17 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				debug("Blocksize ack: %s, %d\n",
 					(char *)pkt+i+8, TftpBlkSize);
 			}
+			if (strcmp((char *)pkt+i, "windowsize") == 0) {
+				TftpWindowSize = (unsigned short)
+					simple_strtoul((char *)pkt+i+11, NULL,
+						       10);
+				/* the server may only lower our proposal */
+				if (TftpWindowSize < 1 ||
+				    TftpWindowSize > TftpWindowSizeOption)
+					TftpWindowSize = 1;
+				debug("Windowsize ack: %s, %d\n",
+					(char *)pkt+i+11, TftpWindowSize);
+			}
 #ifdef CONFIG_TFTP_TSIZE
 			if (strcmp((char *)pkt+i, "tsize") == 0) {
 				TftpTsize = simple_strtoul((char *)pkt+i+6,
@@ -560,8 +599,6 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 		len -= 2;
 		TftpBlock = ntohs(*(__be16 *)pkt);
 
-		update_block_number();
-
 		if (TftpState == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
@@ -577,7 +614,11 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 				TftpLastBlock = TftpBlock - 1;
 			} else
 #endif
-			if (TftpBlock != 1) {	/* Assertion */
+			/*
+			 * With a window, a lost block 1 is just a gap:
+			 * ACK block 0 below so the server resends it.
+			 */
+			if (TftpBlock != 1 && TftpWindowSize == 1) {
 				printf("\nTFTP error: "
 				       "First block is not block 1 (%ld)\n"
 				       "Starting again\n\n",
@@ -594,6 +635,27 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			break;
 		}
 
+		if (TftpWindowSize > 1 &&
+		    TftpBlock != ((TftpLastBlock + 1) & 0xffff)) {
+			/*
+			 *	A block of the window went missing. ACK the
+			 *	last block we stored so the server resends the
+			 *	window from there, once per gap.
+			 */
+			debug("Unexpected block %lu, expected %lu\n",
+			      TftpBlock, (TftpLastBlock + 1) & 0xffff);
+			TftpBlock = TftpLastBlock;
+			if (TftpLastNack != TftpLastBlock) {
+				TftpLastNack = TftpLastBlock;
+				TftpNextAck = (TftpLastBlock + TftpWindowSize) &
+					      0xffff;
+				TftpSend();
+			}
+			break;
+		}
+
+		update_block_number();
+
 		TftpLastBlock = TftpBlock;
 		TftpTimeoutCountMax = TIMEOUT_COUNT;
 		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
@@ -629,7 +691,19 @@ TftpHandler(uchar *pkt, unsigned dest, IPaddr_t sip, unsigned src,
 			}
 		}
 #endif
-		TftpSend();
+		/*
+		 *	With a window, only ACK its last block and the final
+		 *	block of the file.
+		 */
+#ifdef CONFIG_MCAST_TFTP
+		if (Multicast)
+			TftpSend();
+		else
+#endif
+		if (TftpBlock == TftpNextAck || len < TftpBlkSize) {
+			TftpNextAck = (TftpBlock + TftpWindowSize) & 0xffff;
+			TftpSend();
+		}
 
 #ifdef CONFIG_MCAST_TFTP
 		if (Multicast) {
@@ -681,6 +755,9 @@ TftpTimeout(void)
 	} else {
 		puts("T ");
 		NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
+		/* the server restarts its window after our re-ACK */
+		if (TftpState == STATE_DATA && !TftpWriting)
+			TftpNextAck = (TftpLastBlock + TftpWindowSize) & 0xffff;
 		if (TftpState != STATE_RECV_WRQ)
 			TftpSend();
 	}
@@ -699,6 +776,10 @@ void TftpStart(enum proto_t protocol)
 	if (ep != NULL)
 		TftpBlkSizeOption = simple_strtol(ep, NULL, 10);
 
+	ep = getenv("tftpwindowsize");
+	if (ep != NULL)
+		TftpWindowSizeOption = simple_strtol(ep, NULL, 10);
+
 	ep = getenv("tftptimeout");
 	if (ep != NULL)
 		TftpTimeoutMSecs = simple_strtol(ep, NULL, 10);
@@ -710,8 +791,8 @@ void TftpStart(enum proto_t protocol)
 		TftpTimeoutMSecs = 1000;
 	}
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-		TftpBlkSizeOption, TftpTimeoutMSecs);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+		TftpBlkSizeOption, TftpWindowSizeOption, TftpTimeoutMSecs);
 
 	TftpRemoteIP = NetServerIP;
 	if (BootFile[0] == '\0') {
@@ -809,8 +890,9 @@ void TftpStart(enum proto_t protocol)
 
 	/* zero out server ether in case the server ip has changed */
 	memset(NetServerEther, 0, 6);
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -839,8 +921,9 @@ TftpStartServer(void)
 	TftpTimeoutMSecs = TIMEOUT;
 	NetSetTimeout(TftpTimeoutMSecs, TftpTimeout);
 
-	/* Revert TftpBlkSize to dflt */
+	/* Revert TftpBlkSize and TftpWindowSize to dflt */
 	TftpBlkSize = TFTP_BLOCK_SIZE;
+	TftpWindowSize = 1;
 	TftpBlock = 0;
 	TftpOurPort = WELL_KNOWN_PORT;
 
@@ -0,0 +1,186 @@
+/*
+ * Asynchronous block read and write tests, run against a sandbox host block
+ * device
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+
+#define TEST_DEV	(CONFIG_HOST_MAX_DEVICES - 1)
+#define TEST_FILE	"blkasync-test.img"
+#define TEST_BLOCKS	128
+#define BLKSZ		512
+
+/* Larger than a block cache entry, so reads go to the device */
+#define CHUNK		16
+#define CHUNKS		(TEST_BLOCKS / CHUNK)
+
+#define DEV_DELAY_US	20000	/* time the device takes for each chunk */
+#define WORK_US		20000	/* time spent processing each chunk */
+
+#define errcheck(statement) if (!(statement)) { \
+	fprintf(stderr, "\tFailed: %s\n", #statement); \
+	ret = 1; \
+	goto out; \
+}
+
+block_dev_desc_t *host_get_dev(int dev);
+
+static int create_image(void)
+{
+	char buf[BLKSZ];
+	int fd, i;
+
+	fd = os_open(TEST_FILE, OS_O_CREAT | OS_O_RDWR);
+	if (fd < 0)
+		return -1;
+	for (i = 0; i < TEST_BLOCKS; i++) {
+		memset(buf, i, BLKSZ);
+		if (os_write(fd, buf, BLKSZ) != BLKSZ) {
+			os_close(fd);
+			return -1;
+		}
+	}
+	os_close(fd);
+
+	return 0;
+}
+
+static int check_blocks(const char *buf, int start, int count)
+{
+	int i;
+
+	for (i = 0; i < count * BLKSZ; i++)
+		if (buf[i] != (char)(start + i / BLKSZ))
+			return 0;
+	return 1;
+}
+
+/* Stand-in for decompressing or hashing a chunk */
+static u32 process(const char *buf)
+{
+	udelay(WORK_US);
+
+	return crc32(0, (const unsigned char *)buf, CHUNK * BLKSZ);
+}
+
+/* Stand-in for receiving a chunk, block n of it is filled with first + n */
+static void produce(char *buf, int first)
+{
+	int i;
+
+	udelay(WORK_US);
+	for (i = 0; i < CHUNK; i++)
+		memset(buf + i * BLKSZ, first + i, BLKSZ);
+}
+
+static int do_test_blkasync(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	static char buf[2][CHUNK * BLKSZ];
+	u32 sync_crc = 0, async_crc = 0;
+	ulong start, sync_us, async_us;
+	block_dev_desc_t *dev;
+	struct blk_req req;
+	int ret = 0;
+	int i;
+
+	if (create_image() || host_dev_bind(TEST_DEV, TEST_FILE)) {
+		printf("test_blkasync: cannot set up %s\n", TEST_FILE);
+		return 1;
+	}
+	dev = host_get_dev(TEST_DEV);
+	errcheck(dev != NULL);
+	errcheck(host_dev_set_delay(TEST_DEV, DEV_DELAY_US) == 0);
+
+	/* A submitted read is not finished until the device says so */
+	errcheck(blk_read_submit(dev, 0, CHUNK, buf[0], &req) == 0);
+	errcheck(!blk_read_poll(&req));
+	errcheck(blk_read_wait(&req) == CHUNK);
+	errcheck(blk_read_poll(&req));
+	errcheck(check_blocks(buf[0], 0, CHUNK));
+
+	/* Empty reads finish at once */
+	errcheck(blk_read_submit(dev, 0, 0, buf[0], &req) == 0);
+	errcheck(blk_read_poll(&req));
+	errcheck(blk_read_wait(&req) == 0);
+	printf("\tsubmit and wait ok\n");
+
+	/* Read a chunk, then process it */
+	start = timer_get_us();
+	for (i = 0; i < CHUNKS; i++) {
+		errcheck(blk_dread(dev, i * CHUNK, CHUNK, buf[0]) == CHUNK);
+		sync_crc ^= process(buf[0]);
+	}
+	sync_us = timer_get_us() - start;
+
+	/* Process each chunk while the device reads the next one */
+	start = timer_get_us();
+	errcheck(blk_read_submit(dev, 0, CHUNK, buf[0], &req) == 0);
+	for (i = 0; i < CHUNKS; i++) {
+		char *cur = buf[i & 1];
+
+		errcheck(blk_read_wait(&req) == CHUNK);
+		errcheck(check_blocks(cur, i * CHUNK, CHUNK));
+		if (i + 1 < CHUNKS)
+			errcheck(blk_read_submit(dev, (i + 1) * CHUNK, CHUNK,
+						 buf[!(i & 1)], &req) == 0);
+		async_crc ^= process(cur);
+	}
+	async_us = timer_get_us() - start;
+
+	printf("\tsync %lu ms, overlapped %lu ms\n", sync_us / 1000,
+	       async_us / 1000);
+	errcheck(sync_crc == async_crc);
+	errcheck(async_us < sync_us / 4 * 3);
+	printf("\toverlap ok\n");
+
+	/* Receive a chunk, then write it, with data the image doesn't hold */
+	start = timer_get_us();
+	for (i = 0; i < CHUNKS; i++) {
+		produce(buf[0], i * CHUNK + 1);
+		errcheck(blk_dwrite(dev, i * CHUNK, CHUNK, buf[0]) == CHUNK);
+	}
+	sync_us = timer_get_us() - start;
+
+	/* Receive each chunk while the device writes the previous one */
+	start = timer_get_us();
+	for (i = 0; i < CHUNKS; i++) {
+		char *cur = buf[i & 1];
+
+		produce(cur, i * CHUNK);
+		if (i)
+			errcheck(blk_write_wait(&req) == CHUNK);
+		errcheck(blk_write_submit(dev, i * CHUNK, CHUNK, cur,
+					  &req) == 0);
+	}
+	errcheck(blk_write_wait(&req) == CHUNK);
+	async_us = timer_get_us() - start;
+
+	for (i = 0; i < CHUNKS; i++) {
+		errcheck(blk_dread(dev, i * CHUNK, CHUNK, buf[0]) == CHUNK);
+		errcheck(check_blocks(buf[0], i * CHUNK, CHUNK));
+	}
+	printf("\twrite sync %lu ms, overlapped %lu ms\n", sync_us / 1000,
+	       async_us / 1000);
+	errcheck(async_us < sync_us / 4 * 3);
+	printf("\twrite overlap ok\n");
+
+out:
+	host_dev_bind(TEST_DEV, NULL);
+	os_unlink(TEST_FILE);
+
+	printf("test_blkasync %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	test_blkasync,	1,	1,	do_test_blkasync,
+	"Basic test of asynchronous block reads and writes", ""
+);
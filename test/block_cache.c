@@ -0,0 +1,153 @@
+/*
+ * Block cache tests, run against a sandbox host block device
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <os.h>
+#include <part.h>
+#include <sandboxblockdev.h>
+
+#define TEST_DEV	(CONFIG_HOST_MAX_DEVICES - 1)
+#define TEST_FILE	"blkcache-test.img"
+#define TEST_BLOCKS	64
+#define BLKSZ		512
+
+#define errcheck(statement) if (!(statement)) { \
+	fprintf(stderr, "\tFailed: %s\n", #statement); \
+	ret = 1; \
+	goto out; \
+}
+
+block_dev_desc_t *host_get_dev(int dev);
+
+/* Every byte of a block holds the block number plus a generation */
+static void fill_block(char *buf, int block, int gen)
+{
+	memset(buf, block + gen, BLKSZ);
+}
+
+static int check_block(const char *buf, int block, int gen)
+{
+	int i;
+
+	for (i = 0; i < BLKSZ; i++)
+		if (buf[i] != (char)(block + gen))
+			return 0;
+	return 1;
+}
+
+static int create_image(void)
+{
+	char buf[BLKSZ];
+	int fd, i;
+
+	fd = os_open(TEST_FILE, OS_O_CREAT | OS_O_RDWR);
+	if (fd < 0)
+		return -1;
+	for (i = 0; i < TEST_BLOCKS; i++) {
+		fill_block(buf, i, 0);
+		if (os_write(fd, buf, BLKSZ) != BLKSZ) {
+			os_close(fd);
+			return -1;
+		}
+	}
+	os_close(fd);
+
+	return 0;
+}
+
+static int do_test_blkcache(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	struct block_cache_stats defaults, stats;
+	block_dev_desc_t *dev;
+	static char big[9 * BLKSZ];
+	char buf[BLKSZ];
+	int ret = 0;
+
+	/* Start from an empty cache with known geometry */
+	blkcache_stats(&defaults);
+	blkcache_configure(8, 32);
+
+	if (create_image() || host_dev_bind(TEST_DEV, TEST_FILE)) {
+		printf("test_blkcache: cannot set up %s\n", TEST_FILE);
+		return 1;
+	}
+	dev = host_get_dev(TEST_DEV);
+	errcheck(dev != NULL);
+
+	/* A single read misses, repeating it hits */
+	errcheck(blk_dread(dev, 0, 1, buf) == 1);
+	errcheck(check_block(buf, 0, 0));
+	errcheck(blk_dread(dev, 0, 1, buf) == 1);
+	errcheck(check_block(buf, 0, 0));
+
+	/* A sequential read fetches a whole entry ahead */
+	errcheck(blk_dread(dev, 1, 1, buf) == 1);
+	errcheck(check_block(buf, 1, 0));
+	errcheck(blk_dread(dev, 2, 1, buf) == 1);
+	errcheck(check_block(buf, 2, 0));
+	errcheck(blk_dread(dev, 8, 1, buf) == 1);
+	errcheck(check_block(buf, 8, 0));
+
+	blkcache_stats(&stats);
+	errcheck(stats.hits == 3);
+	errcheck(stats.misses == 2);
+	errcheck(stats.readahead == 7);
+	errcheck(stats.entries == 2);
+	printf("\thits, misses and readahead ok\n");
+
+	/* Reads never run past the end of the device */
+	errcheck(blk_dread(dev, TEST_BLOCKS - 2, 1, buf) == 1);
+	errcheck(blk_dread(dev, TEST_BLOCKS - 1, 1, buf) == 1);
+	errcheck(check_block(buf, TEST_BLOCKS - 1, 0));
+	blkcache_stats(&stats);
+	errcheck(stats.readahead == 0);
+
+	/* Writing through blk_dwrite() drops stale blocks */
+	fill_block(buf, 3, 1);
+	errcheck(blk_dwrite(dev, 3, 1, buf) == 1);
+	errcheck(blk_dread(dev, 3, 1, buf) == 1);
+	errcheck(check_block(buf, 3, 1));
+
+	/* So does writing to the device directly */
+	errcheck(blk_dread(dev, 4, 1, buf) == 1);
+	errcheck(check_block(buf, 4, 0));
+	fill_block(buf, 4, 1);
+	errcheck(dev->block_write(dev->dev, 4, 1, buf) == 1);
+	errcheck(blk_dread(dev, 4, 1, buf) == 1);
+	errcheck(check_block(buf, 4, 1));
+	printf("\tinvalidation on write ok\n");
+
+	/* Large reads and a disabled cache go straight to the device */
+	blkcache_stats(&stats);
+	errcheck(blk_dread(dev, 16, 9, big) == 9);
+	errcheck(check_block(big + 8 * BLKSZ, 24, 0));
+	blkcache_stats(&stats);
+	errcheck(stats.hits == 0 && stats.misses == 0);
+	blkcache_configure(0, 0);
+	errcheck(blk_dread(dev, 16, 1, buf) == 1);
+	errcheck(check_block(buf, 16, 0));
+	blkcache_stats(&stats);
+	errcheck(stats.hits == 0 && stats.misses == 0 && stats.entries == 0);
+	printf("\tdisabled cache ok\n");
+
+out:
+	blkcache_configure(defaults.max_blocks_per_entry,
+			   defaults.max_entries);
+	host_dev_bind(TEST_DEV, NULL);
+	os_unlink(TEST_FILE);
+
+	printf("test_blkcache %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	test_blkcache,	1,	1,	do_test_blkcache,
+	"Basic test of the block cache", ""
+);
@@ -18,6 +18,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <lz4.h>
 
 static const char plain[] =
 	"I am a highly compressable bit of text.\n"
@@ -92,6 +93,27 @@ static const char lzo_compressed[] =
 	"\x73\x61\x67\x65\x73\x2e\x0a\x11\x00\x00\x00\x00\x00\x00";
 static const unsigned long lzo_compressed_size = 334;
 
+/* lz4 -c /tmp/plain.txt > /tmp/plain.lz4 */
+static const char lz4_compressed[] =
+	"\x04\x22\x4d\x18\x60\x40\x82\x01\x01\x00\x00\xff\x19\x49\x20\x61"
+	"\x6d\x20\x61\x20\x68\x69\x67\x68\x6c\x79\x20\x63\x6f\x6d\x70\x72"
+	"\x65\x73\x73\x61\x62\x6c\x65\x20\x62\x69\x74\x20\x6f\x66\x20\x74"
+	"\x65\x78\x74\x2e\x0a\x28\x00\x3d\xf1\x25\x54\x68\x65\x72\x65\x20"
+	"\x61\x72\x65\x20\x6d\x61\x6e\x79\x20\x6c\x69\x6b\x65\x20\x6d\x65"
+	"\x2c\x20\x62\x75\x74\x20\x74\x68\x69\x73\x20\x6f\x6e\x65\x20\x69"
+	"\x73\x20\x6d\x69\x6e\x65\x2e\x0a\x49\x66\x20\x49\x20\x77\x32\x00"
+	"\xd1\x6e\x79\x20\x73\x68\x6f\x72\x74\x65\x72\x2c\x20\x74\x45\x00"
+	"\xf4\x0b\x77\x6f\x75\x6c\x64\x6e\x27\x74\x20\x62\x65\x20\x6d\x75"
+	"\x63\x68\x20\x73\x65\x6e\x73\x65\x20\x69\x6e\x0a\xcf\x00\x50\x69"
+	"\x6e\x67\x20\x6d\x12\x00\x00\x32\x00\xf0\x11\x20\x66\x69\x72\x73"
+	"\x74\x20\x70\x6c\x61\x63\x65\x2e\x20\x41\x74\x20\x6c\x65\x61\x73"
+	"\x74\x20\x77\x69\x74\x68\x20\x6c\x7a\x6f\x2c\x63\x00\xf5\x14\x77"
+	"\x61\x79\x2c\x0a\x77\x68\x69\x63\x68\x20\x61\x70\x70\x65\x61\x72"
+	"\x73\x20\x74\x6f\x20\x62\x65\x68\x61\x76\x65\x20\x70\x6f\x6f\x72"
+	"\x6c\x79\x4e\x00\x30\x61\x63\x65\x27\x01\x01\x95\x00\x01\x2d\x01"
+	"\xb0\x0a\x6d\x65\x73\x73\x61\x67\x65\x73\x2e\x0a\x00\x00\x00\x00";
+static const unsigned long lz4_compressed_size = 272;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -224,6 +246,38 @@ static int uncompress_using_lzo(void *in, unsigned long in_size,
 	return (ret != LZO_E_OK);
 }
 
+static int compress_using_lz4(void *in, unsigned long in_size,
+			      void *out, unsigned long out_max,
+			      unsigned long *out_size)
+{
+	/* There is no lz4 compression in u-boot, so fake it. */
+	assert(in_size == strlen(plain));
+	assert(memcmp(plain, in, in_size) == 0);
+
+	if (lz4_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, lz4_compressed, lz4_compressed_size);
+	if (out_size)
+		*out_size = lz4_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_lz4(void *in, unsigned long in_size,
+				void *out, unsigned long out_max,
+				unsigned long *out_size)
+{
+	int ret;
+	size_t output_size = out_max;
+
+	ret = ulz4fn(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -313,6 +367,117 @@ out:
 	return ret;
 }
 
+#define BENCH_SIZE		(8 << 20)
+#define BENCH_LZ4_BLOCK		(4 << 20)
+
+static uint bench_rand(uint *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+/*
+ * Without an lz4 compressor, build a frame for the speed test out of short
+ * literal runs and matches, which is roughly what lz4 makes of code.
+ */
+static ulong make_lz4_bench(uchar *out, ulong size)
+{
+	uchar *op = out;
+	uchar *blk_start;
+	ulong produced = 0;
+	ulong block, done, left;
+	uint seed = 1;
+	uint lit, len, offset, i;
+
+	/* magic, version 1 with independent blocks, 4 MiB blocks, checksum */
+	memcpy(op, "\x04\x22\x4d\x18\x60\x70\x73", 7);
+	op += 7;
+
+	while (produced < size) {
+		block = min(size - produced, (ulong)BENCH_LZ4_BLOCK);
+		blk_start = op;
+		op += 4;
+		for (done = 0; block - done > 64; done += lit + len) {
+			lit = done ? bench_rand(&seed) % 15 : 14;
+			len = 4 + bench_rand(&seed) % 15;
+			*op++ = lit << 4 | (len - 4);
+			for (i = 0; i < lit; i++)
+				*op++ = 'a' + bench_rand(&seed) % 26;
+			offset = 1 + bench_rand(&seed) % min(done + lit, 1024UL);
+			*op++ = offset & 0xff;
+			*op++ = offset >> 8;
+		}
+
+		/* Last literals */
+		left = block - done;
+		*op++ = 15 << 4;
+		for (len = left - 15; len >= 255; len -= 255)
+			*op++ = 255;
+		*op++ = len;
+		for (i = 0; i < left; i++)
+			*op++ = ' ' + bench_rand(&seed) % 64;
+
+		i = op - blk_start - 4;
+		blk_start[0] = i;
+		blk_start[1] = i >> 8;
+		blk_start[2] = i >> 16;
+		blk_start[3] = i >> 24;
+		produced += block;
+	}
+	memset(op, 0, 4);
+	op += 4;
+
+	return op - out;
+}
+
+/* Time lz4 and gzip on the same data */
+static int run_bench(void)
+{
+	uchar *lz4_buf = NULL, *gz_buf = NULL, *data = NULL, *out = NULL;
+	ulong lz4_size, gz_size = BENCH_SIZE;
+	unsigned long out_size;
+	ulong start, ms;
+	size_t size;
+	int ret;
+
+	printf(" speed ...\n");
+
+	lz4_buf = malloc(BENCH_SIZE);
+	gz_buf = malloc(BENCH_SIZE);
+	data = malloc(BENCH_SIZE);
+	out = malloc(BENCH_SIZE);
+	errcheck(lz4_buf && gz_buf && data && out);
+
+	lz4_size = make_lz4_bench(lz4_buf, BENCH_SIZE);
+	size = BENCH_SIZE;
+	start = get_timer(0);
+	errcheck(ulz4fn(lz4_buf, lz4_size, data, &size) == 0);
+	ms = get_timer(start);
+	errcheck(size == BENCH_SIZE);
+	printf("\tlz4: %lu -> %lu bytes in %lu ms\n", lz4_size,
+	       (ulong)size, ms);
+
+	errcheck(gzip(gz_buf, &gz_size, data, BENCH_SIZE) == 0);
+	out_size = gz_size;
+	start = get_timer(0);
+	errcheck(gunzip(out, BENCH_SIZE, gz_buf, &out_size) == 0);
+	ms = get_timer(start);
+	errcheck(out_size == BENCH_SIZE);
+	errcheck(memcmp(out, data, BENCH_SIZE) == 0);
+	printf("\tgzip: %lu -> %lu bytes in %lu ms\n", gz_size,
+	       out_size, ms);
+
+	ret = 0;
+out:
+	printf(" speed: %s\n", ret == 0 ? "ok" : "FAILED");
+
+	free(out);
+	free(data);
+	free(gz_buf);
+	free(lz4_buf);
+
+	return ret;
+}
 
 static int do_test_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 			       char * const argv[])
@@ -323,6 +488,8 @@ static int do_test_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 	err += run_test("bzip2", compress_using_bzip2, uncompress_using_bzip2);
 	err += run_test("lzma", compress_using_lzma, uncompress_using_lzma);
 	err += run_test("lzo", compress_using_lzo, uncompress_using_lzo);
+	err += run_test("lz4", compress_using_lz4, uncompress_using_lz4);
+	err += run_bench();
 
 	printf("test_compression %s\n", err == 0 ? "ok" : "FAILED");
 
@@ -331,5 +498,5 @@ static int do_test_compression(cmd_tbl_t *cmdtp, int flag, int argc,
 
 U_BOOT_CMD(
 	test_compression,	5,	1,	do_test_compression,
-	"Basic test of compressors: gzip bzip2 lzma lzo", ""
+	"Basic test of compressors: gzip bzip2 lzma lzo lz4", ""
 );
@@ -0,0 +1,89 @@
+/*
+ * CRC32 correctness and throughput test
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+#define BENCH_SIZE	(16 << 20)
+#define BENCH_LOOPS	4
+
+/* Bit at a time reference implementation */
+static uint32_t crc32_ref(uint32_t crc, const unsigned char *p, uint len)
+{
+	int k;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+	}
+
+	return ~crc;
+}
+
+static int do_test_crc32(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	unsigned char *buf;
+	ulong start, ms;
+	uint32_t crc = 0;
+	int off, len, i;
+	int ret = 0;
+
+	buf = malloc(BENCH_SIZE);
+	if (!buf) {
+		puts("test_crc32: out of memory\n");
+		return 1;
+	}
+
+	if (crc32(0, (const unsigned char *)"123456789", 9) != 0xcbf43926) {
+		puts("\tcheck value mismatch\n");
+		ret = 1;
+		goto out;
+	}
+
+	/* Every alignment and tail length against the reference */
+	for (i = 0; i < 1024; i++)
+		buf[i] = i * 7 + (i >> 3);
+	for (off = 0; off < 16; off++) {
+		for (len = 0; len < 512; len++) {
+			if (crc32(0x1234, buf + off, len) !=
+			    crc32_ref(0x1234, buf + off, len) ||
+			    crc32_no_comp(0x1234, buf + off, len) !=
+			    ~crc32_ref(~0x1234, buf + off, len)) {
+				printf("\tmismatch at offset %d length %d\n",
+				       off, len);
+				ret = 1;
+				goto out;
+			}
+		}
+	}
+	puts("\talignments and lengths ok\n");
+
+	memset(buf, 0x5a, BENCH_SIZE);
+	start = get_timer(0);
+	for (i = 0; i < BENCH_LOOPS; i++)
+		crc = crc32(crc, buf, BENCH_SIZE);
+	ms = get_timer(start);
+	printf("\t%d MiB in %lu ms", (BENCH_SIZE >> 20) * BENCH_LOOPS, ms);
+	if (ms)
+		printf(" (%lu MiB/s)", (BENCH_SIZE >> 20) * BENCH_LOOPS *
+		       1000UL / ms);
+	printf(", crc %08x\n", crc);
+
+out:
+	free(buf);
+	printf("test_crc32 %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	test_crc32,	1,	1,	do_test_crc32,
+	"Check crc32 against a reference and measure its throughput", ""
+);
@@ -0,0 +1,100 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+
+# Invoke this script from U-Boot base directory as ./test/fs/ext4-bench.sh
+# It loads large files from a host-bound ext4 image with ext4load in
+# sandbox, checks their md5 against the host and prints the load rate
+# reported by U-Boot, so ext4 read path regressions show up as a drop in
+# MiB/s. Pass "clean" to remove the generated files.
+
+# pre-requisite binaries list.
+PREREQ_BINS="md5sum mkfs.ext4 dd truncate"
+
+OUT_DIR="sandbox/test/fs"
+UBOOT="./sandbox/u-boot"
+SRC_DIR="${OUT_DIR}/bench-src"
+IMG="${OUT_DIR}/bench.ext4.img"
+OUT="${OUT_DIR}/ext4-bench.out"
+
+# Number of times each file is loaded
+LOOPS=3
+
+function check_prereq() {
+	for prereq in $PREREQ_BINS; do
+		if [ ! -x `which $prereq` ]; then
+			echo "Missing $prereq binary. Exiting!"
+			exit
+		fi
+	done
+}
+
+function compile_sandbox() {
+	unset CROSS_COMPILE
+	NUM_CPUS=$(cat /proc/cpuinfo |grep -c processor)
+	make O=sandbox sandbox_config
+	make O=sandbox -s -j${NUM_CPUS}
+
+	if [ ! -x "$UBOOT" ]; then
+		echo "$UBOOT does not exist or is not executable"
+		echo "Build error?"
+		exit
+	fi
+}
+
+# 32MB file and a sparse file with holes between its extents.
+function create_image() {
+	if [ -f "$IMG" ]; then
+		return
+	fi
+	mkdir -p "$SRC_DIR"
+	dd if=/dev/urandom of="${SRC_DIR}/big.file" bs=1M count=32 &> /dev/null
+	truncate -s 16M "${SRC_DIR}/sparse.file"
+	for seek in 1 5 9 13; do
+		dd if=/dev/urandom of="${SRC_DIR}/sparse.file" bs=256K \
+			seek=$((seek * 4)) count=1 conv=notrunc &> /dev/null
+	done
+	mkfs.ext4 -q -F -d "$SRC_DIR" "$IMG" 128M
+}
+
+function run_bench() {
+	addr="0x01000008"
+
+	(
+		echo "sb bind 0 $IMG"
+		for file in big.file sparse.file; do
+			md5=`md5sum < "${SRC_DIR}/${file}" | cut -d' ' -f1`
+			for i in `seq 1 $LOOPS`; do
+				echo "echo expect ${file} ${md5}"
+				echo "ext4load host 0:0 $addr /${file}"
+				echo "md5sum $addr \$filesize"
+			done
+		done
+	) | $UBOOT > "$OUT" 2>&1
+
+	awk '
+		/^expect/ { name = $2; md5 = $3; next }
+		/bytes read in/ { print name ": " $0; next }
+		/^md5 for/ {
+			if ($NF == md5) {
+				pass++
+			} else {
+				fail++
+				print name ": md5 mismatch"
+			}
+		}
+		END { print "Summary: PASS: " pass + 0 " FAIL: " fail + 0 }
+	' "$OUT"
+}
+
+check_prereq
+if [ "$1" = "clean" ]; then
+	rm -rf "$SRC_DIR" "$IMG" "$OUT"
+	echo "Cleaned up generated files. Exiting"
+	exit
+fi
+compile_sandbox
+mkdir -p "$OUT_DIR"
+create_image
+run_bench
@@ -0,0 +1,128 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+
+# Invoke this script from U-Boot base directory as ./test/fs/ubifs-bench.sh
+# It writes a UBI image holding a UBIFS volume to the sandbox NAND chip,
+# then times attaching it, mounting the volume and loading a 10MB file,
+# and checks the file's md5 against the host. The chip spends realistic
+# read/program/erase times, so the figures follow the number of NAND
+# operations each step needs; "sb nand" adds the raw counts. Extra
+# arguments are appended to the --nand option, e.g. "tr=60,flip=100".
+# Pass "clean" to remove the generated files.
+
+# pre-requisite binaries list.
+PREREQ_BINS="md5sum mkfs.ubifs ubinize dd"
+
+OUT_DIR="sandbox/test/fs"
+UBOOT="./sandbox/u-boot"
+SRC_DIR="${OUT_DIR}/ubifs-src"
+UBIFS_IMG="${OUT_DIR}/bench.ubifs"
+UBI_IMG="${OUT_DIR}/bench.ubi"
+NAND_IMG="${OUT_DIR}/bench.nand"
+OUT="${OUT_DIR}/ubifs-bench.out"
+
+# Default sandbox NAND geometry: 2KiB pages, 128KiB blocks, 512 byte
+# subpages, 128MiB
+PAGE=2048
+SUBPAGE=512
+PEB=128KiB
+LEB=126976
+MAX_LEBS=1000
+
+# Number of times the file is loaded
+LOOPS=3
+
+function check_prereq() {
+	for prereq in $PREREQ_BINS; do
+		if [ ! -x `which $prereq` ]; then
+			echo "Missing $prereq binary. Exiting!"
+			exit
+		fi
+	done
+}
+
+function compile_sandbox() {
+	unset CROSS_COMPILE
+	NUM_CPUS=$(cat /proc/cpuinfo |grep -c processor)
+	make O=sandbox sandbox_config
+	make O=sandbox -s -j${NUM_CPUS}
+
+	if [ ! -x "$UBOOT" ]; then
+		echo "$UBOOT does not exist or is not executable"
+		echo "Build error?"
+		exit
+	fi
+}
+
+function create_image() {
+	if [ -f "$UBI_IMG" ]; then
+		return
+	fi
+	mkdir -p "$SRC_DIR"
+	dd if=/dev/urandom of="${SRC_DIR}/big.file" bs=1M count=10 &> /dev/null
+	mkfs.ubifs -q -r "$SRC_DIR" -m $PAGE -e $LEB -c $MAX_LEBS \
+		-o "$UBIFS_IMG"
+	cat > "${OUT_DIR}/ubinize.cfg" << EOF
+[rootfs]
+mode=ubi
+image=${UBIFS_IMG}
+vol_id=0
+vol_type=dynamic
+vol_name=rootfs
+vol_flags=autoresize
+EOF
+	ubinize -o "$UBI_IMG" -p $PEB -m $PAGE -s $SUBPAGE \
+		"${OUT_DIR}/ubinize.cfg"
+}
+
+function run_bench() {
+	addr="0x01000008"
+	md5=`md5sum < "${SRC_DIR}/big.file" | cut -d' ' -f1`
+
+	(
+		echo "sb load hostfs - $addr $UBI_IMG"
+		echo "nand erase.chip"
+		echo "nand write.trimffs $addr 0 \$filesize"
+		echo "sb nand reset"
+		echo "echo step attach"
+		echo "time ubi part ubi"
+		echo "echo step mount"
+		echo "time ubifsmount ubi0:rootfs"
+		for i in `seq 1 $LOOPS`; do
+			echo "echo step load"
+			echo "time ubifsload $addr /big.file"
+			echo "md5sum $addr \$filesize"
+		done
+		echo "sb nand"
+	) | $UBOOT --nand "${NAND_IMG}${NAND_OPTS:+,$NAND_OPTS}" > "$OUT" 2>&1
+
+	awk -v md5="$md5" '
+		/^step/ { step = $2; next }
+		/^time:/ { print step ": " $0; next }
+		/^md5 for/ {
+			if ($NF == md5) {
+				pass++
+			} else {
+				fail++
+				print "big.file: md5 mismatch"
+			}
+		}
+		/^(page|block|bits|bus|array)/ { print }
+		END { print "Summary: PASS: " pass + 0 " FAIL: " fail + 0 }
+	' "$OUT"
+}
+
+check_prereq
+if [ "$1" = "clean" ]; then
+	rm -rf "$SRC_DIR" "$UBIFS_IMG" "$UBI_IMG" "$NAND_IMG" "$OUT" \
+		"${OUT_DIR}/ubinize.cfg"
+	echo "Cleaned up generated files. Exiting"
+	exit
+fi
+NAND_OPTS="$1"
+compile_sandbox
+mkdir -p "$OUT_DIR"
+create_image
+run_bench
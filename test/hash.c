@@ -0,0 +1,183 @@
+/*
+ * SHA-1/SHA-256 known-answer tests and throughput
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <hash.h>
+#include <malloc.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+#define BENCH_SIZE	(16 << 20)
+
+struct hash_test {
+	const char *input;
+	int repeat;		/* times the input is hashed */
+	const char *sha1;
+	const char *sha256;
+};
+
+/* FIPS 180-2 appendix examples */
+static const struct hash_test hash_tests[] = {
+	{
+		"", 1,
+		"da39a3ee5e6b4b0d3255bfef95601890afd80709",
+		"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+	}, {
+		"abc", 1,
+		"a9993e364706816aba3e25717850c26c9cd0d89d",
+		"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+	}, {
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+		"84983e441c3bd26ebaae4aa1f95129e5e54670f1",
+		"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+	}, {
+		"aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa", 20000,
+		"34aa973cd4c4daa4f61eeb2bdbad27316534016f",
+		"cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+	},
+};
+
+static int check_digest(const char *name, int test, const uint8_t *sum,
+			const char *expect, int len)
+{
+	char hex[SHA256_SUM_LEN * 2 + 1];
+	int i;
+
+	for (i = 0; i < len; i++)
+		sprintf(hex + i * 2, "%02x", sum[i]);
+	if (strcmp(hex, expect)) {
+		printf("\t%s test %d: got %s\n", name, test, hex);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int run_kat(void)
+{
+	uint8_t sum[SHA256_SUM_LEN];
+	sha1_context ctx1;
+	sha256_context ctx256;
+	int err = 0;
+	int i, j, len;
+
+	for (i = 0; i < ARRAY_SIZE(hash_tests); i++) {
+		const struct hash_test *t = &hash_tests[i];
+
+		len = strlen(t->input);
+		sha1_starts(&ctx1);
+		sha256_starts(&ctx256);
+		for (j = 0; j < t->repeat; j++) {
+			sha1_update(&ctx1, (const uint8_t *)t->input, len);
+			sha256_update(&ctx256, (const uint8_t *)t->input, len);
+		}
+		sha1_finish(&ctx1, sum);
+		err |= check_digest("sha1", i, sum, t->sha1, SHA1_SUM_LEN);
+		sha256_finish(&ctx256, sum);
+		err |= check_digest("sha256", i, sum, t->sha256,
+				    SHA256_SUM_LEN);
+	}
+
+	return err;
+}
+
+/* Feeding a buffer in odd pieces must give the one-shot digest */
+static int run_split(uint8_t *buf, int size)
+{
+	static const int chunks[] = { 1, 3, 63, 64, 65, 200, 4096 };
+	uint8_t ref1[SHA1_SUM_LEN], ref256[SHA256_SUM_LEN];
+	uint8_t sum[SHA256_SUM_LEN];
+	sha1_context ctx1;
+	sha256_context ctx256;
+	int i, pos, n;
+
+	for (i = 0; i < size; i++)
+		buf[i] = i * 13 + (i >> 5);
+	sha1_csum_wd(buf, size, ref1, CHUNKSZ_SHA1);
+	sha256_csum_wd(buf, size, ref256, CHUNKSZ_SHA256);
+
+	for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+		sha1_starts(&ctx1);
+		sha256_starts(&ctx256);
+		for (pos = 0; pos < size; pos += n) {
+			n = min(chunks[i], size - pos);
+			sha1_update(&ctx1, buf + pos, n);
+			sha256_update(&ctx256, buf + pos, n);
+		}
+		sha1_finish(&ctx1, sum);
+		if (memcmp(sum, ref1, SHA1_SUM_LEN)) {
+			printf("\tsha1 mismatch with %d byte updates\n",
+			       chunks[i]);
+			return 1;
+		}
+		sha256_finish(&ctx256, sum);
+		if (memcmp(sum, ref256, SHA256_SUM_LEN)) {
+			printf("\tsha256 mismatch with %d byte updates\n",
+			       chunks[i]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static void run_bench(const char *algo_name, const uint8_t *buf, int size)
+{
+	uint8_t sum[HASH_MAX_DIGEST_SIZE];
+	ulong start, ms;
+
+	start = get_timer(0);
+	if (hash_block(algo_name, buf, size, sum, NULL)) {
+		printf("\t%s: not available\n", algo_name);
+		return;
+	}
+	ms = get_timer(start);
+	printf("\t%s: %d MiB in %lu ms", algo_name, size >> 20, ms);
+	if (ms)
+		printf(" (%lu MiB/s)", (size >> 20) * 1000UL / ms);
+	putc('\n');
+}
+
+static int do_test_hash(cmd_tbl_t *cmdtp, int flag, int argc,
+			char * const argv[])
+{
+	uint8_t *buf;
+	int ret = 0;
+
+	buf = malloc(BENCH_SIZE);
+	if (!buf) {
+		puts("test_hash: out of memory\n");
+		return 1;
+	}
+
+	if (run_kat()) {
+		ret = 1;
+		goto out;
+	}
+	puts("\tknown answers ok\n");
+
+	if (run_split(buf, 10000)) {
+		ret = 1;
+		goto out;
+	}
+	puts("\tsplit updates ok\n");
+
+	memset(buf, 0xa5, BENCH_SIZE);
+	run_bench("sha1", buf, BENCH_SIZE);
+	run_bench("sha256", buf, BENCH_SIZE);
+
+out:
+	free(buf);
+	printf("test_hash %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	test_hash,	1,	1,	do_test_hash,
+	"SHA-1/SHA-256 known-answer test and throughput", ""
+);
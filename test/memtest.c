@@ -0,0 +1,105 @@
+/*
+ * mtest engine test, on a malloc() buffer and on sandbox's emulated RAM
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <memtest.h>
+
+#define TEST_SIZE	(8 << 20)
+#define TEST_ADDR	0x10000000UL	/* reported address of the buffer */
+
+static const char *const alg_names[MEMTEST_ALG_COUNT] = {
+	"inv", "xor", "addr",
+};
+
+/* What each algorithm leaves behind, pass 0 with no pattern given */
+static int check_result(int alg, const ulong *buf)
+{
+	ulong words = TEST_SIZE / sizeof(ulong);
+	ulong i;
+
+	for (i = 0; i < words; i += words / 64 + 1) {
+		switch (alg) {
+		case MEMTEST_ALG_INV:
+			if (buf[i] != 1)
+				return 1;
+			break;
+		case MEMTEST_ALG_ADDR:
+			if (buf[i] != ~(TEST_ADDR + i * sizeof(ulong)))
+				return 1;
+			break;
+		default:
+			/* a pseudo-random sequence has no repeats */
+			if (i && buf[i] == buf[i - 1])
+				return 1;
+			break;
+		}
+	}
+
+	return 0;
+}
+
+static int do_test_memtest(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct memtest_stats stats;
+	ulong *buf;
+	int ret = 0;
+	int alg;
+
+	buf = memalign(MEMTEST_LINE, TEST_SIZE);
+	if (!buf) {
+		puts("test_memtest: out of memory\n");
+		return 1;
+	}
+
+	for (alg = 0; alg < MEMTEST_ALG_COUNT && !ret; alg++) {
+		memset(&stats, 0, sizeof(stats));
+		if (memtest_run(alg, buf, TEST_ADDR, TEST_SIZE, 0, 0, 0,
+				&stats) || stats.errs) {
+			printf("\t%s: %lu errors\n", alg_names[alg], stats.errs);
+			ret = 1;
+		} else if (check_result(alg, buf)) {
+			printf("\t%s: memory not as left by the test\n",
+			       alg_names[alg]);
+			ret = 1;
+		} else if (stats.bytes < 2ULL * TEST_SIZE) {
+			printf("\t%s: only %llu bytes moved\n", alg_names[alg],
+			       (unsigned long long)stats.bytes);
+			ret = 1;
+		} else {
+			printf("\t%s: %llu MiB in %lu us\n", alg_names[alg],
+			       (unsigned long long)(stats.bytes >> 20),
+			       (ulong)stats.us);
+		}
+	}
+	free(buf);
+
+	/* the command, on emulated RAM, leaving the cache setting alone */
+	if (!ret && (run_command("mtest -a all -c off 100000 900000 0 2", 0) ||
+		     !dcache_status())) {
+		puts("\tmtest -a all failed\n");
+		ret = 1;
+	}
+	if (!ret && run_command("mtest -a quick 100000 110000 0 1", 0)) {
+		puts("\tmtest -a quick failed\n");
+		ret = 1;
+	}
+	if (!ret && !run_command("mtest -a none", 0)) {
+		puts("\tmtest took an unknown algorithm\n");
+		ret = 1;
+	}
+
+	printf("test_memtest %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	test_memtest,	1,	1,	do_test_memtest,
+	"Check the mtest engine algorithms and the mtest command", ""
+);
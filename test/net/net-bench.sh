@@ -0,0 +1,118 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+
+# Invoke this script from U-Boot base directory as ./test/net/net-bench.sh
+# It starts test/net/sbeth-server.py as the other end of the sandbox
+# Ethernet device and loads a file over TFTP and NFS with different window
+# sizes, frame delays and loss rates. Every load is checked against the
+# host md5 and timed, so net/ regressions show up as failures or as longer
+# times. Pass "clean" to remove the generated files.
+
+# pre-requisite binaries list.
+PREREQ_BINS="md5sum dd python"
+
+OUT_DIR="sandbox/test/net"
+UBOOT="./sandbox/u-boot"
+SERVER="./test/net/sbeth-server.py"
+ROOT="${OUT_DIR}/root"
+OUT="${OUT_DIR}/net-bench.out"
+PORT=5555
+FILE="big.file"
+
+# "ethdelay(ms) ethloss(%)" pairs
+LINKS="0,0 2,0 0,1 2,1"
+TFTP_WINDOWS="1 8"
+NFS_WINDOWS="1 4"
+
+function check_prereq() {
+	for prereq in $PREREQ_BINS; do
+		if [ ! -x `which $prereq` ]; then
+			echo "Missing $prereq binary. Exiting!"
+			exit
+		fi
+	done
+}
+
+function compile_sandbox() {
+	unset CROSS_COMPILE
+	NUM_CPUS=$(cat /proc/cpuinfo |grep -c processor)
+	make O=sandbox sandbox_config
+	make O=sandbox -s -j${NUM_CPUS}
+
+	if [ ! -x "$UBOOT" ]; then
+		echo "$UBOOT does not exist or is not executable"
+		echo "Build error?"
+		exit
+	fi
+}
+
+function create_files() {
+	mkdir -p "$ROOT"
+	if [ ! -f "${ROOT}/${FILE}" ]; then
+		dd if=/dev/urandom of="${ROOT}/${FILE}" bs=1M count=8 &> /dev/null
+	fi
+}
+
+# $1: extra server options, $2: label
+function run_bench() {
+	addr="0x01000000"
+	md5=`md5sum < "${ROOT}/${FILE}" | cut -d' ' -f1`
+
+	python $SERVER --port $PORT --root "$ROOT" $1 &
+	server=$!
+	sleep 1
+
+	(
+		echo "setenv tftptimeout 1000"
+		for link in $LINKS; do
+			delay=${link%,*}
+			loss=${link#*,}
+			echo "setenv ethdelay $delay"
+			echo "setenv ethloss $loss"
+			for win in $TFTP_WINDOWS; do
+				echo "setenv tftpwindowsize $win"
+				echo "echo expect tftp delay=$delay loss=$loss" \
+					"window=$win"
+				echo "time tftpboot $addr $FILE"
+				echo "md5sum $addr \$filesize"
+			done
+			for win in $NFS_WINDOWS; do
+				echo "setenv nfswindowsize $win"
+				echo "echo expect nfs$2 delay=$delay loss=$loss" \
+					"window=$win"
+				echo "time nfs $addr /${FILE}"
+				echo "md5sum $addr \$filesize"
+			done
+		done
+	) | $UBOOT --eth 127.0.0.1:$PORT > "$OUT" 2>&1
+
+	kill $server
+
+	awk -v md5=$md5 '
+		/^expect/ { name = $2 " " $3 " " $4 " " $5; next }
+		/^time:/ { print name ": " $2 " s"; next }
+		/^md5 for/ {
+			if ($NF == md5) {
+				pass++
+			} else {
+				fail++
+				print name ": md5 mismatch"
+			}
+		}
+		END { print "Summary: PASS: " pass + 0 " FAIL: " fail + 0 }
+	' "$OUT"
+}
+
+check_prereq
+if [ "$1" = "clean" ]; then
+	rm -rf "$ROOT" "$OUT"
+	echo "Cleaned up generated files. Exiting"
+	exit
+fi
+compile_sandbox
+mkdir -p "$OUT_DIR"
+create_files
+run_bench "" ""
+run_bench "--v2-only" "v2"
@@ -0,0 +1,481 @@
+#!/usr/bin/env python
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Host end of the sandbox Ethernet device (drivers/net/sandbox.c).
+#
+# Each UDP datagram carries one Ethernet frame. The script answers ARP and
+# ping and serves the files below a directory over TFTP (with the blksize,
+# tsize and windowsize options) and over NFS v2/v3 (portmapper, mountd and
+# nfsd in one), so the U-Boot network stack can be exercised and timed
+# without hardware:
+#
+#   ./test/net/sbeth-server.py --root /some/dir &
+#   ./sandbox/u-boot --eth 127.0.0.1:5555 -c "tftpboot 1000000 file"
+#
+# Latency and loss are added on the U-Boot side (ethdelay, ethloss).
+
+import optparse
+import os
+import select
+import socket
+import stat
+import struct
+import time
+
+ETH_P_IP = 0x0800
+ETH_P_ARP = 0x0806
+IPPROTO_ICMP = 1
+IPPROTO_UDP = 17
+
+SERVER_MAC = b'\x02\x00\x00\x00\x00\x01'
+
+TFTP_PORT = 69
+PORTMAP_PORT = 111
+MOUNT_PORT = 635
+NFS_PORT = 2049
+
+PROG_PORTMAP = 100000
+PROG_NFS = 100003
+PROG_MOUNT = 100005
+
+NFS2_FHSIZE = 32
+NFS3_FHSIZE = 24	# shorter than v2 on purpose: v3 handles vary in size
+
+NFS_OK = 0
+NFSERR_NOENT = 2
+NFSERR_INVAL = 22
+
+TFTP_RRQ, TFTP_DATA, TFTP_ACK, TFTP_ERROR, TFTP_OACK = 1, 3, 4, 5, 6
+
+
+def ip_checksum(data):
+    if len(data) & 1:
+        data += b'\0'
+    total = sum(struct.unpack('!%dH' % (len(data) // 2), data))
+    while total >> 16:
+        total = (total & 0xffff) + (total >> 16)
+    return ~total & 0xffff
+
+
+def xdr_opaque(data):
+    pad = (4 - len(data) % 4) % 4
+    return struct.pack('!I', len(data)) + data + b'\0' * pad
+
+
+class Xdr(object):
+    """Reads XDR words from an RPC call"""
+
+    def __init__(self, data, pos=0):
+        self.data = data
+        self.pos = pos
+
+    def u32(self):
+        val, = struct.unpack_from('!I', self.data, self.pos)
+        self.pos += 4
+        return val
+
+    def u64(self):
+        val, = struct.unpack_from('!Q', self.data, self.pos)
+        self.pos += 8
+        return val
+
+    def opaque(self, size=None):
+        if size is None:
+            size = self.u32()
+        val = self.data[self.pos:self.pos + size]
+        self.pos += (size + 3) & ~3
+        return val
+
+
+class TftpTransfer(object):
+    def __init__(self, server, port, cport, data, blksize, window, oack):
+        self.server = server
+        self.port = port
+        self.cport = cport
+        self.data = data
+        self.blksize = blksize
+        self.window = window
+        self.blocks = len(data) // blksize + 1
+        self.base = 0 if oack else 1	# block 0 is the OACK
+        self.oack = oack
+        self.sent_at = 0
+
+    def send_window(self):
+        if self.base == 0:
+            self.server.send_udp(self.port, self.cport, self.oack)
+        else:
+            last = min(self.base + self.window - 1, self.blocks)
+            for block in range(self.base, last + 1):
+                start = (block - 1) * self.blksize
+                self.server.send_udp(self.port, self.cport,
+                    struct.pack('!HH', TFTP_DATA, block & 0xffff) +
+                    self.data[start:start + self.blksize])
+        self.sent_at = time.time()
+
+    def ack(self, block):
+        # ACKs carry 16 bits: take the block nearest the window
+        full = (self.base - 1) & ~0xffff | block
+        if full < self.base - 1 - 0x8000:
+            full += 0x10000
+        if full < self.base - 1:
+            return True
+        if full >= self.blocks:
+            return False
+        self.base = full + 1
+        self.send_window()
+        return True
+
+
+class Server(object):
+    def __init__(self, sock, ip, root, opts):
+        self.sock = sock
+        self.ip = socket.inet_aton(ip)
+        self.root = os.path.realpath(root)
+        self.opts = opts
+        self.peer = None
+        self.client_mac = None
+        self.client_ip = None
+        self.ip_id = 0
+        self.tftp = {}
+        self.next_tftp_port = 49152
+        self.handles = [self.root]
+
+    # Link and network layer
+
+    def send_frame(self, dst, ethertype, payload):
+        frame = dst + SERVER_MAC + struct.pack('!H', ethertype) + payload
+        if len(frame) < 60:
+            frame += b'\0' * (60 - len(frame))
+        self.sock.sendto(frame, self.peer)
+
+    def send_ip(self, proto, payload):
+        """Send an IP datagram to the client, fragmented to the MTU"""
+        self.ip_id = (self.ip_id + 1) & 0xffff
+        step = (self.opts.mtu - 20) & ~7
+        offset = 0
+        while True:
+            chunk = payload[offset:offset + step]
+            more = offset + len(chunk) < len(payload)
+            flags = (0x2000 if more else 0) | (offset >> 3)
+            hdr = struct.pack('!BBHHHBBH4s4s', 0x45, 0, 20 + len(chunk),
+                              self.ip_id, flags, 64, proto, 0,
+                              self.ip, self.client_ip)
+            hdr = hdr[:10] + struct.pack('!H', ip_checksum(hdr)) + hdr[12:]
+            self.send_frame(self.client_mac, ETH_P_IP, hdr + chunk)
+            offset += len(chunk)
+            if not more:
+                break
+
+    def send_udp(self, sport, dport, payload):
+        # a zero checksum means none, which IPv4 allows
+        hdr = struct.pack('!HHHH', sport, dport, 8 + len(payload), 0)
+        self.send_ip(IPPROTO_UDP, hdr + payload)
+
+    def handle_frame(self, frame):
+        if len(frame) < 14:
+            return
+        dst, src, ethertype = struct.unpack_from('!6s6sH', frame)
+        payload = frame[14:]
+        if ethertype == ETH_P_ARP:
+            self.handle_arp(src, payload)
+        elif ethertype == ETH_P_IP:
+            self.handle_ip(src, payload)
+
+    def handle_arp(self, src, pkt):
+        if len(pkt) < 28:
+            return
+        op, sha, spa, tha, tpa = struct.unpack_from('!6xH6s4s6s4s', pkt)
+        if op != 1 or tpa != self.ip:
+            return
+        reply = struct.pack('!HHBBH6s4s6s4s', 1, ETH_P_IP, 6, 4, 2,
+                            SERVER_MAC, self.ip, sha, spa)
+        self.send_frame(src, ETH_P_ARP, reply)
+
+    def handle_ip(self, src, pkt):
+        if len(pkt) < 20:
+            return
+        vhl, tot_len, frag, proto, saddr, daddr = \
+            struct.unpack_from('!BxHxxHxB2x4s4s', pkt)
+        hlen = (vhl & 0xf) * 4
+        if daddr != self.ip or frag & 0x3fff:
+            return
+        self.client_mac = src
+        self.client_ip = saddr
+        data = pkt[hlen:tot_len]
+        if proto == IPPROTO_ICMP:
+            self.handle_icmp(data)
+        elif proto == IPPROTO_UDP and len(data) >= 8:
+            sport, dport = struct.unpack_from('!HH', data)
+            self.handle_udp(sport, dport, data[8:])
+
+    def handle_icmp(self, data):
+        if len(data) < 8 or struct.unpack_from('!B', data)[0] != 8:
+            return
+        reply = b'\0\0\0\0' + data[4:]
+        reply = reply[:2] + struct.pack('!H', ip_checksum(reply)) + reply[4:]
+        self.send_ip(IPPROTO_ICMP, reply)
+
+    def handle_udp(self, sport, dport, data):
+        if dport == TFTP_PORT:
+            self.tftp_request(sport, data)
+        elif dport in self.tftp:
+            self.tftp_packet(dport, data)
+        elif dport in (PORTMAP_PORT, MOUNT_PORT, NFS_PORT):
+            reply = self.rpc_call(data)
+            if reply is not None:
+                self.send_udp(dport, sport, reply)
+
+    # TFTP
+
+    def tftp_error(self, port, cport, code, msg):
+        self.send_udp(port, cport, struct.pack('!HH', TFTP_ERROR, code) +
+                      msg.encode() + b'\0')
+
+    def tftp_request(self, cport, data):
+        fields = data[2:].split(b'\0')
+        if struct.unpack_from('!H', data)[0] != TFTP_RRQ or len(fields) < 2:
+            return
+        port = self.next_tftp_port
+        self.next_tftp_port += 1
+        name = fields[0].decode()
+        path = self.lookup_path(name)
+        if path is None or not os.path.isfile(path):
+            self.tftp_error(port, cport, 1, 'File not found')
+            return
+        with open(path, 'rb') as f:
+            content = f.read()
+
+        blksize, window, oack = 512, 1, b''
+        opts = fields[2:]
+        for i in range(0, len(opts) - 1, 2):
+            key, val = opts[i].decode().lower(), opts[i + 1].decode()
+            if key == 'blksize':
+                blksize = min(int(val), self.opts.mtu - 32)
+                val = str(blksize)
+            elif key == 'windowsize':
+                window = int(val)
+            elif key == 'tsize':
+                val = str(len(content))
+            elif key != 'timeout':
+                continue
+            oack += key.encode() + b'\0' + val.encode() + b'\0'
+        if oack:
+            oack = struct.pack('!H', TFTP_OACK) + oack
+
+        xfer = TftpTransfer(self, port, cport, content, blksize, window, oack)
+        self.tftp[port] = xfer
+        xfer.send_window()
+
+    def tftp_packet(self, port, data):
+        xfer = self.tftp[port]
+        opcode, = struct.unpack_from('!H', data)
+        if opcode == TFTP_ACK and len(data) >= 4:
+            if not xfer.ack(struct.unpack_from('!H', data, 2)[0]):
+                del self.tftp[port]
+        elif opcode == TFTP_ERROR:
+            del self.tftp[port]
+
+    def tftp_timeouts(self):
+        now = time.time()
+        for xfer in list(self.tftp.values()):
+            if now - xfer.sent_at > self.opts.timeout:
+                xfer.send_window()
+
+    # Files and handles
+
+    def lookup_path(self, name):
+        path = os.path.realpath(os.path.join(self.root, name.lstrip('/')))
+        if path != self.root and not path.startswith(self.root + os.sep):
+            return None
+        return path if os.path.lexists(path) else None
+
+    def handle_for(self, path, size):
+        if path not in self.handles:
+            self.handles.append(path)
+        index = self.handles.index(path)
+        return struct.pack('!I', index) + b'\xfe' * (size - 4)
+
+    def path_for(self, fh):
+        index, = struct.unpack_from('!I', fh)
+        if index < len(self.handles):
+            return self.handles[index]
+        return None
+
+    def fattr2(self, path):
+        st = os.lstat(path)
+        ftype = 2 if stat.S_ISDIR(st.st_mode) else \
+            5 if stat.S_ISLNK(st.st_mode) else 1
+        return struct.pack('!17I', ftype, st.st_mode & 0xffff, 1, 0, 0,
+                           st.st_size & 0xffffffff, 4096, 0,
+                           (st.st_size + 511) // 512, 1,
+                           st.st_ino & 0xffffffff, 0, 0, 0, 0, 0, 0)
+
+    def post_op_attr(self, path):
+        st = os.lstat(path)
+        ftype = 2 if stat.S_ISDIR(st.st_mode) else \
+            5 if stat.S_ISLNK(st.st_mode) else 1
+        return struct.pack('!IIIIIIQQIIQQIIIIII', 1, ftype,
+                           st.st_mode & 0xffff, 1, 0, 0, st.st_size,
+                           st.st_size, 0, 0, 1, st.st_ino,
+                           0, 0, 0, 0, 0, 0)
+
+    # RPC
+
+    def rpc_call(self, data):
+        x = Xdr(data)
+        try:
+            xid, mtype, rpcvers, prog, vers, proc = [x.u32() for i in
+                                                     range(6)]
+            x.u32()
+            x.opaque()	# credential
+            x.u32()
+            x.opaque()	# verifier
+        except struct.error:
+            return None
+        if mtype != 0:
+            return None
+
+        head = struct.pack('!IIIII', xid, 1, 0, 0, 0)
+        if prog == PROG_PORTMAP:
+            body = self.portmap(proc, x)
+        elif prog == PROG_MOUNT:
+            body = self.mountd(vers, proc, x)
+        elif prog == PROG_NFS:
+            body = self.nfsd(vers, proc, x)
+        else:
+            body = None
+        if body is None:
+            # PROG_MISMATCH: only v1 and v2 when v3 is switched off
+            low, high = (1, 1) if prog == PROG_MOUNT else (2, 2)
+            return struct.pack('!IIIIIIII', xid, 1, 0, 0, 0, 2, low, high)
+        return head + struct.pack('!I', 0) + body
+
+    def portmap(self, proc, x):
+        if proc == 0:
+            return b''
+        if proc != 3:
+            return None
+        prog, vers = x.u32(), x.u32()
+        port = 0
+        if prog == PROG_MOUNT and vers in (1, 3):
+            port = MOUNT_PORT
+        elif prog == PROG_NFS and vers in (2, 3):
+            port = NFS_PORT
+        if vers == 3 and self.opts.v2_only:
+            port = 0
+        return struct.pack('!I', port)
+
+    def mountd(self, vers, proc, x):
+        if vers == 3 and self.opts.v2_only:
+            return None
+        if proc in (0, 3, 4):	# NULL, UMNT, UMNTALL
+            return b''
+        if proc != 1:
+            return None
+        path = self.lookup_path(x.opaque().decode())
+        if path is None or not os.path.isdir(path):
+            return struct.pack('!I', NFSERR_NOENT)
+        if vers == 3:
+            return struct.pack('!I', NFS_OK) + \
+                xdr_opaque(self.handle_for(path, NFS3_FHSIZE)) + \
+                struct.pack('!II', 1, 1)
+        return struct.pack('!I', NFS_OK) + self.handle_for(path, NFS2_FHSIZE)
+
+    def nfsd(self, vers, proc, x):
+        if vers == 3 and self.opts.v2_only:
+            return None
+        if proc == 0:
+            return b''
+        v3 = vers == 3
+        fh = x.opaque() if v3 else x.opaque(NFS2_FHSIZE)
+        path = self.path_for(fh)
+        if path is None:
+            return struct.pack('!I', 70)	# NFSERR_STALE
+
+        if (v3 and proc == 3) or (not v3 and proc == 4):	# LOOKUP
+            name = x.opaque().decode()
+            target = os.path.join(path, name)
+            if not os.path.lexists(target):
+                return struct.pack('!I', NFSERR_NOENT) + \
+                    (struct.pack('!I', 0) if v3 else b'')
+            if v3:
+                return struct.pack('!I', NFS_OK) + \
+                    xdr_opaque(self.handle_for(target, NFS3_FHSIZE)) + \
+                    self.post_op_attr(target) + struct.pack('!I', 0)
+            return struct.pack('!I', NFS_OK) + \
+                self.handle_for(target, NFS2_FHSIZE) + self.fattr2(target)
+
+        if proc == 5:						# READLINK
+            if not os.path.islink(path):
+                return struct.pack('!I', NFSERR_INVAL) + \
+                    (struct.pack('!I', 0) if v3 else b'')
+            link = xdr_opaque(os.readlink(path).encode())
+            if v3:
+                return struct.pack('!I', NFS_OK) + \
+                    self.post_op_attr(path) + link
+            return struct.pack('!I', NFS_OK) + link
+
+        if proc == 6:						# READ
+            offset = x.u64() if v3 else x.u32()
+            count = x.u32()
+            if not os.path.isfile(path) or os.path.islink(path):
+                return struct.pack('!I', NFSERR_INVAL) + \
+                    (struct.pack('!I', 0) if v3 else b'')
+            count = min(count, self.opts.rtmax if v3 else 8192)
+            with open(path, 'rb') as f:
+                f.seek(offset)
+                data = f.read(count)
+            if v3:
+                eof = offset + len(data) >= os.path.getsize(path)
+                return struct.pack('!I', NFS_OK) + self.post_op_attr(path) + \
+                    struct.pack('!II', len(data), eof) + xdr_opaque(data)
+            return struct.pack('!I', NFS_OK) + self.fattr2(path) + \
+                xdr_opaque(data)
+
+        if v3 and proc == 19:					# FSINFO
+            rtmax = self.opts.rtmax
+            return struct.pack('!I', NFS_OK) + self.post_op_attr(path) + \
+                struct.pack('!IIIIIIIQIII', rtmax, rtmax, 4096, rtmax,
+                            rtmax, 4096, 4096, (1 << 63) - 1, 0, 1, 0x1b)
+
+        return struct.pack('!I', 10004 if v3 else NFSERR_INVAL)
+
+    def run(self):
+        while True:
+            ready, _, _ = select.select([self.sock], [], [], 0.05)
+            if ready:
+                frame, self.peer = self.sock.recvfrom(65536)
+                self.handle_frame(frame)
+            if self.peer:
+                self.tftp_timeouts()
+
+
+def main():
+    parser = optparse.OptionParser()
+    parser.add_option('--port', type='int', default=5555,
+                      help='UDP port the sandbox sends frames to')
+    parser.add_option('--ip', default='192.168.7.1',
+                      help='IP address of the server (serverip)')
+    parser.add_option('--root', default='.',
+                      help='directory served over TFTP and NFS')
+    parser.add_option('--mtu', type='int', default=1500)
+    parser.add_option('--rtmax', type='int', default=32768,
+                      help='largest NFSv3 READ the server answers')
+    parser.add_option('--v2-only', action='store_true', dest='v2_only',
+                      help='offer NFSv2 only, as old servers do')
+    parser.add_option('--timeout', type='float', default=1.0,
+                      help='TFTP retransmission timeout in seconds')
+    opts, args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1 << 20)
+    sock.bind(('127.0.0.1', opts.port))
+    try:
+        Server(sock, opts.ip, opts.root, opts).run()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
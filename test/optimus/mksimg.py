@@ -0,0 +1,80 @@
+#!/usr/bin/env python
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Write a random Android sparse image and the raw image it expands to, for
+# simg2img-test.sh. Runs of adjacent RAW chunks, some longer than a packet,
+# are mixed with FILL and DONT_CARE chunks.
+#
+# Usage: mksimg.py <image.simg> <expected.raw> <seed> <blocks>
+
+import random
+import struct
+import sys
+
+SPARSE_HEADER_MAGIC = 0xed26ff3a
+CHUNK_TYPE_RAW = 0xcac1
+CHUNK_TYPE_FILL = 0xcac2
+CHUNK_TYPE_DONT_CARE = 0xcac3
+FILE_HDR_SZ = 28
+CHUNK_HDR_SZ = 12
+BLK_SZ = 4096
+
+# what simg2img_host starts the media with
+MEDIA_INIT_BYTE = b'\x5a'
+
+def rand_bytes(rnd, size):
+    return rnd.getrandbits(size * 8).to_bytes(size, 'little')
+
+def make_chunks(rnd, total_blocks):
+    """Return a list of (type, blocks, payload) covering total_blocks"""
+    chunks = []
+    left = total_blocks
+    while left:
+        kind = rnd.choice(('raw', 'raw', 'fill', 'dont_care'))
+        if kind == 'raw':
+            for i in range(rnd.randint(1, 8)):
+                if rnd.randint(0, 9):
+                    blocks = rnd.randint(1, 64)
+                else:
+                    blocks = rnd.randint(256, 1024)
+                blocks = min(blocks, left)
+                if not blocks:
+                    break
+                chunks.append((CHUNK_TYPE_RAW, blocks,
+                               rand_bytes(rnd, blocks * BLK_SZ)))
+                left -= blocks
+        else:
+            blocks = min(rnd.randint(1, 300), left)
+            if kind == 'fill':
+                value = rnd.choice((0, 0xffffffff, rnd.getrandbits(32)))
+                chunks.append((CHUNK_TYPE_FILL, blocks,
+                               struct.pack('<I', value)))
+            else:
+                chunks.append((CHUNK_TYPE_DONT_CARE, blocks, b''))
+            left -= blocks
+    return chunks
+
+def main():
+    simg_name, raw_name, seed, total_blocks = sys.argv[1:5]
+    rnd = random.Random(int(seed))
+    total_blocks = int(total_blocks)
+    chunks = make_chunks(rnd, total_blocks)
+
+    with open(simg_name, 'wb') as simg, open(raw_name, 'wb') as raw:
+        simg.write(struct.pack('<IHHHHIIII', SPARSE_HEADER_MAGIC, 1, 0,
+                               FILE_HDR_SZ, CHUNK_HDR_SZ, BLK_SZ,
+                               total_blocks, len(chunks), 0))
+        for chunk_type, blocks, payload in chunks:
+            simg.write(struct.pack('<HHII', chunk_type, 0, blocks,
+                                   CHUNK_HDR_SZ + len(payload)))
+            simg.write(payload)
+            if chunk_type == CHUNK_TYPE_RAW:
+                raw.write(payload)
+            elif chunk_type == CHUNK_TYPE_FILL:
+                raw.write(payload * (blocks * BLK_SZ // 4))
+            else:
+                raw.write(MEDIA_INIT_BYTE * (blocks * BLK_SZ))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,61 @@
+#!/bin/bash
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+# Host test for the burning tool's sparse image parser
+# (drivers/usb/gadget/v2_burning/v2_common/optimus_simg2img.c), which only
+# builds for Amlogic boards. The parser is built as a host program against
+# a memory backed media, fed sparse images in packets of several sizes, and
+# the media is compared to the raw images.
+#
+# Images come from mksimg.py. If img2simg from the Android tools is
+# installed, the raw images are also converted with it and tested.
+#
+# Run from the U-Boot source tree as ./test/optimus/simg2img-test.sh
+
+set -e
+
+SRCDIR="$(cd "$(dirname "$0")/../.." && pwd)"
+TESTDIR="${SRCDIR}/test/optimus"
+V2DIR="${SRCDIR}/drivers/usb/gadget/v2_burning"
+HOSTCC="${HOSTCC:-cc}"
+
+PACKET_SIZES="0x10000 0x40000 0x100000 0x400000"
+SEEDS="1 2 3 4"
+BLOCKS=12288		# 48MB images
+
+tmp="$(mktemp -d)"
+trap 'rm -rf "${tmp}"' EXIT
+
+# The parser includes "../v2_burning_i.h", replaced by the host one here
+mkdir "${tmp}/v2_common"
+cp "${V2DIR}/v2_common/optimus_simg2img.c" "${tmp}/v2_common/"
+cp "${TESTDIR}/v2_burning_i.h" "${tmp}/"
+: >"${tmp}/partition_table.h"
+
+${HOSTCC} -O2 -w -I"${tmp}" -I"${V2DIR}" -o "${tmp}/simg2img_host" \
+	"${tmp}/v2_common/optimus_simg2img.c" "${TESTDIR}/simg2img_host.c"
+
+run() {
+	local simg=$1 raw=$2 size erase
+
+	for size in ${PACKET_SIZES}; do
+		for erase in 0 1024; do
+			echo -n "$(basename ${simg}) packet ${size} erase ${erase}: "
+			"${tmp}/simg2img_host" ${simg} ${raw} ${size} ${erase}
+		done
+	done
+}
+
+for seed in ${SEEDS}; do
+	python "${TESTDIR}/mksimg.py" "${tmp}/${seed}.simg" "${tmp}/${seed}.raw" \
+		${seed} ${BLOCKS}
+	run "${tmp}/${seed}.simg" "${tmp}/${seed}.raw"
+
+	if command -v img2simg >/dev/null; then
+		img2simg "${tmp}/${seed}.raw" "${tmp}/${seed}.img2simg"
+		run "${tmp}/${seed}.img2simg" "${tmp}/${seed}.raw"
+	fi
+done
+
+echo "PASS"
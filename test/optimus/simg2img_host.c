@@ -0,0 +1,235 @@
+/*
+ * Host driver for the burning tool's sparse image parser
+ *
+ * Feeds a sparse image to optimus_simg_to_media() in packets the way
+ * optimus_buf_manager_report_transfer_complete() does, with the bytes left
+ * unparsed by one packet copied in front of the next. The media is a
+ * memory buffer which is compared to the expected raw image at the end.
+ *
+ * Usage: simg2img_host <image.simg> <expected.raw> <packet size>
+ *			[erase unit in sectors]
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "v2_burning_i.h"
+
+/* what DONT_CARE regions hold, mksimg.py writes the same */
+#define MEDIA_INIT_BYTE		0x5a
+
+unsigned device_boot_flag = EMMC_BOOT_FLAG;
+
+static u8 *media;
+static u64 media_size;
+static unsigned erase_unit;
+
+static const char *pkt_start, *pkt_end;
+static unsigned raw_writes;
+
+int is_optimus_storage_inited(void)
+{
+	return 0;
+}
+
+u32 optimus_cb_simg_write_media(const unsigned destAddrInSec,
+				const unsigned dataSzInBy, const char *data)
+{
+	const u64 off = (u64)destAddrInSec << 9;
+
+	if (off + dataSzInBy > media_size) {
+		fprintf(stderr, "write 0x%x bytes at sector 0x%x beyond media\n",
+			dataSzInBy, destAddrInSec);
+		return 0;
+	}
+	if (data >= pkt_start && data < pkt_end) {
+		if (data + dataSzInBy > pkt_end) {
+			fprintf(stderr, "write source runs past the packet\n");
+			return 0;
+		}
+		raw_writes++;
+	}
+	memcpy(media + off, data, dataSzInBy);
+
+	return dataSzInBy;
+}
+
+unsigned optimus_cb_simg_erase_unit(void)
+{
+	return erase_unit;
+}
+
+int optimus_cb_simg_erase_media(const unsigned destAddrInSec,
+				const unsigned sizeInSec)
+{
+	if (destAddrInSec % erase_unit || sizeInSec % erase_unit ||
+	    ((u64)destAddrInSec + sizeInSec) << 9 > media_size) {
+		fprintf(stderr, "bad erase 0x%x sectors at 0x%x\n",
+			sizeInSec, destAddrInSec);
+		return -1;
+	}
+	memset(media + ((u64)destAddrInSec << 9), 0, (u64)sizeInSec << 9);
+
+	return 0;
+}
+
+static void *read_file(const char *name, long *size)
+{
+	FILE *f = fopen(name, "rb");
+	void *buf;
+
+	if (!f) {
+		perror(name);
+		exit(1);
+	}
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	rewind(f);
+	buf = malloc(*size + 1);
+	if (!buf || fread(buf, 1, *size, f) != *size) {
+		perror(name);
+		exit(1);
+	}
+	fclose(f);
+
+	return buf;
+}
+
+/*
+ * Count the runs of RAW chunks adjacent on the media, the fewest writes
+ * the parser can do if no run crosses a packet boundary.
+ */
+static unsigned count_raw_runs(const u8 *img, unsigned *raw_chunks)
+{
+	const sparse_header_t *header = (const sparse_header_t *)img;
+	const u8 *p = img + header->file_hdr_sz;
+	unsigned runs = 0, i;
+	int in_run = 0;
+
+	*raw_chunks = 0;
+	for (i = 0; i < header->total_chunks; i++) {
+		const chunk_header_t *chunk = (const chunk_header_t *)p;
+
+		if (chunk->chunk_type == CHUNK_TYPE_RAW) {
+			++*raw_chunks;
+			if (!in_run)
+				runs++;
+			in_run = 1;
+		} else if (chunk->chunk_sz) {
+			in_run = 0;
+		}
+		p += chunk->total_sz;
+	}
+
+	return runs;
+}
+
+int main(int argc, char *argv[])
+{
+	const unsigned long verify_buf = OPTIMUS_DOWNLOAD_SPARSE_INFO_FOR_VERIFY;
+	const unsigned long verify_sz = OPTIMUS_SPARSE_IMG_FILL_VAL_BUF +
+		OPTIMUS_SPARSE_IMG_FILL_BUF_SZ - verify_buf;
+	const sparse_header_t *header;
+	unsigned packets = 0, raw_chunks, raw_runs;
+	unsigned long pkt_sz;
+	long img_sz, raw_sz, pos = 0;
+	u32 left = 0, media_sec = 0;
+	char *buf;
+	u8 *img, *expect;
+
+	if (argc < 4) {
+		fprintf(stderr, "usage: %s <image.simg> <expected.raw> "
+			"<packet size> [erase unit in sectors]\n", argv[0]);
+		return 1;
+	}
+	img = read_file(argv[1], &img_sz);
+	expect = read_file(argv[2], &raw_sz);
+	pkt_sz = strtoul(argv[3], NULL, 0);
+	erase_unit = argc > 4 ? strtoul(argv[4], NULL, 0) : 0;
+
+	/* the parser keeps chunk headers and the FILL pattern at fixed addresses */
+	if (mmap((void *)verify_buf, verify_sz, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) != (void *)verify_buf) {
+		fprintf(stderr, "cannot map parser buffers at 0x%lx\n",
+			verify_buf);
+		return 1;
+	}
+
+	header = (const sparse_header_t *)img;
+	if (!optimus_simg_probe(img, img_sz)) {
+		fprintf(stderr, "%s: not a sparse image\n", argv[1]);
+		return 1;
+	}
+	media_size = (u64)header->total_blks * header->blk_sz;
+	if (media_size != raw_sz) {
+		fprintf(stderr, "%s is 0x%lx bytes, want 0x%llx\n", argv[2],
+			raw_sz, (unsigned long long)media_size);
+		return 1;
+	}
+	media = malloc(media_size);
+	buf = malloc(OPTIMUS_SPARSE_IMG_LEFT_DATA_MAX_SZ + pkt_sz);
+	if (!media || !buf) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	memset(media, MEDIA_INIT_BYTE, media_size);
+	raw_runs = count_raw_runs(img, &raw_chunks);
+
+	optimus_simg_parser_init(img);
+	while (pos < img_sz) {
+		const u32 this_sz = img_sz - pos < pkt_sz ? img_sz - pos : pkt_sz;
+		char *data = buf + OPTIMUS_SPARSE_IMG_LEFT_DATA_MAX_SZ - left;
+		u32 size = left + this_sz;
+		u32 unparsed = 0;
+		int ret;
+
+		memcpy(buf + OPTIMUS_SPARSE_IMG_LEFT_DATA_MAX_SZ, img + pos,
+		       this_sz);
+		pos += this_sz;
+		packets++;
+
+		pkt_start = data;
+		pkt_end = data + size;
+		ret = optimus_simg_to_media(data, size, &unparsed, media_sec);
+		if (ret < 0) {
+			fprintf(stderr, "parser failed at packet %u: %d\n",
+				packets, ret);
+			return 1;
+		}
+		media_sec += ret;
+
+		if (size - unparsed <= left) {
+			fprintf(stderr, "packet %u: parsed 0x%x <= left 0x%x\n",
+				packets, size - unparsed, left);
+			return 1;
+		}
+		left = unparsed;
+		if (left > OPTIMUS_SPARSE_IMG_LEFT_DATA_MAX_SZ || (left & 3)) {
+			fprintf(stderr, "packet %u: bad left size 0x%x\n",
+				packets, left);
+			return 1;
+		}
+		memmove(buf + OPTIMUS_SPARSE_IMG_LEFT_DATA_MAX_SZ - left,
+			data + size - left, left);
+	}
+
+	if (left || optimus_sparse_back_info_probe() != OPT_DOWN_TRUE) {
+		fprintf(stderr, "image not completely parsed, 0x%x left\n",
+			left);
+		return 1;
+	}
+	if (memcmp(media, expect, media_size)) {
+		fprintf(stderr, "media differs from %s\n", argv[2]);
+		return 1;
+	}
+	if (raw_writes > raw_runs + packets) {
+		fprintf(stderr, "%u RAW writes for %u runs in %u packets\n",
+			raw_writes, raw_runs, packets);
+		return 1;
+	}
+	printf("%u packets, %u RAW chunks in %u runs, %u RAW writes\n",
+	       packets, raw_chunks, raw_runs, raw_writes);
+
+	return 0;
+}
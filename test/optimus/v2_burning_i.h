@@ -0,0 +1,35 @@
+/*
+ * Host stand-in for drivers/usb/gadget/v2_burning/v2_burning_i.h, used by
+ * simg2img-test.sh to build optimus_simg2img.c as a host program.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __V2_BURNING_I_H__
+#define __V2_BURNING_I_H__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef uint16_t __le16;
+typedef uint32_t __le32;
+
+/* from include/partition_table.h */
+#define SPI_BOOT_FLAG		0
+#define NAND_BOOT_FLAG		1
+#define EMMC_BOOT_FLAG		2
+#define CARD_BOOT_FLAG		3
+#define SPI_NAND_FLAG		4
+#define SPI_EMMC_FLAG		5
+extern unsigned device_boot_flag;
+
+#include "v2_common/sparse_format.h"
+#include "v2_common/optimus_download.h"
+
+#endif /* __V2_BURNING_I_H__ */
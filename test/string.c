@@ -0,0 +1,170 @@
+/*
+ * memcpy/memmove/memset/memcmp correctness and throughput test
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+
+#define SWEEP_SIZE	600
+#define SWEEP_ALIGN	16
+#define AREA		(2 * (SWEEP_SIZE + 2 * SWEEP_ALIGN + 128))
+
+#define BENCH_SIZE	(8 << 20)
+#define BENCH_LOOPS	8
+
+static void copy_ref(char *d, const char *s, size_t n)
+{
+	if (d <= s) {
+		while (n--)
+			*d++ = *s++;
+	} else {
+		while (n--)
+			d[n] = s[n];
+	}
+}
+
+static int sign(int v)
+{
+	return (v > 0) - (v < 0);
+}
+
+/* Every size below SWEEP_SIZE at every source/destination alignment */
+static int sweep(char *pat, char *buf, char *ref)
+{
+	int so, dof, n, k;
+	char *d, *s;
+
+	for (so = 0; so < SWEEP_ALIGN; so++) {
+		for (dof = 0; dof < SWEEP_ALIGN; dof++) {
+			for (n = 0; n < SWEEP_SIZE; n++) {
+				d = buf + AREA / 2 + dof;
+				memcpy(buf, pat, AREA);
+				memcpy(ref, pat, AREA);
+				copy_ref(ref + AREA / 2 + dof, pat + so, n);
+				if (memcpy(d, pat + so, n) != d ||
+				    memcmp(buf, ref, AREA)) {
+					printf("\tmemcpy %d/%d/%d\n", so, dof, n);
+					return 1;
+				}
+
+				memset(ref + AREA / 2 + dof, so, n);
+				if (memset(d, so, n) != d ||
+				    memcmp(buf, ref, AREA)) {
+					printf("\tmemset %d/%d/%d\n", so, dof, n);
+					return 1;
+				}
+
+				/* overlapping, destination below and above */
+				d = buf + 64 + dof;
+				s = buf + 64 + so + 9;
+				for (k = 0; k < 2; k++) {
+					memcpy(buf, pat, AREA);
+					memcpy(ref, pat, AREA);
+					copy_ref(ref + (d - buf), ref + (s - buf),
+						 n);
+					if (memmove(d, s, n) != d ||
+					    memcmp(buf, ref, AREA)) {
+						printf("\tmemmove %d/%d/%d\n",
+						       so, dof, n);
+						return 1;
+					}
+					d = buf + 64 + so + 9;
+					s = buf + 64 + dof;
+				}
+
+				d = buf + AREA / 2 + dof;
+				memcpy(d, pat + so, n);
+				if (memcmp(d, pat + so, n)) {
+					printf("\tmemcmp equal %d/%d/%d\n", so,
+					       dof, n);
+					return 1;
+				}
+				if (!n)
+					continue;
+				k = (n * 7 + so) % n;
+				d[k] ^= 0x81;
+				if (sign(memcmp(pat + so, d, n)) !=
+				    sign((unsigned char)pat[so + k] -
+					 (unsigned char)d[k])) {
+					printf("\tmemcmp %d/%d/%d\n", so, dof, n);
+					return 1;
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* MiB/s of the best of BENCH_LOOPS copies */
+static ulong bench_copy(char *dst, const char *src)
+{
+	ulong start, us, best = ~0UL;
+	int i;
+
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		start = timer_get_us();
+		memcpy(dst, src, BENCH_SIZE);
+		us = timer_get_us() - start;
+		best = min(best, max(us, 1UL));
+	}
+
+	return (BENCH_SIZE >> 20) * 1000000UL / best;
+}
+
+static int do_test_string(cmd_tbl_t *cmdtp, int flag, int argc,
+			  char * const argv[])
+{
+	char *pat, *buf, *ref, *src, *dst;
+	ulong aligned, misaligned;
+	int ret = 0;
+	int i;
+
+	pat = malloc(AREA);
+	buf = malloc(AREA);
+	ref = malloc(AREA);
+	src = malloc(BENCH_SIZE + 64);
+	dst = malloc(BENCH_SIZE + 64);
+	if (!pat || !buf || !ref || !src || !dst) {
+		puts("test_string: out of memory\n");
+		ret = 1;
+		goto out;
+	}
+
+	for (i = 0; i < AREA; i++)
+		pat[i] = i * 7 + (i >> 3);
+	ret = sweep(pat, buf, ref);
+	if (ret)
+		goto out;
+	puts("\tsizes and alignments ok\n");
+
+	memset(src, 0x5a, BENCH_SIZE + 64);
+	aligned = bench_copy(dst, src);
+	misaligned = bench_copy(dst, src + 3);
+	printf("\tmemcpy %d MiB: aligned %lu MiB/s, misaligned %lu MiB/s\n",
+	       BENCH_SIZE >> 20, aligned, misaligned);
+
+	/* a byte at a time is several times slower than word copies */
+	if (misaligned < aligned / 3) {
+		puts("\tmisaligned copy too slow\n");
+		ret = 1;
+	}
+
+out:
+	free(pat);
+	free(buf);
+	free(ref);
+	free(src);
+	free(dst);
+	printf("test_string %s\n", ret == 0 ? "ok" : "FAILED");
+
+	return ret;
+}
+
+U_BOOT_CMD(
+	test_string,	1,	1,	do_test_string,
+	"Check memcpy/memmove/memset/memcmp and measure memcpy throughput", ""
+);
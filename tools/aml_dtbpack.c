@@ -0,0 +1,417 @@
+/*
+ * Pack device trees into an Amlogic multi-dtb container (version 3, see
+ * include/aml_dt.h), or list the entries of a version 1, 2 or 3 one.
+ *
+ * Each dtb is named by its aml_dt id, "<soc>_<platform>_<variant>",
+ * given as id=file or taken from the amlogic-dt-id property of the root
+ * node. Entries are compressed one by one, so U-Boot only inflates the
+ * one it boots.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include "mkimage.h"
+#include <stdint.h>
+#include <zlib.h>
+#include <image.h>
+#include <aml_dt.h>
+
+#define DTB_MAX_SIZE	0x40000	/* space U-Boot allows for one dtb */
+
+struct entry {
+	char id[AML_DT_V3_ID_SIZE];
+	const char *fname;
+	char *data;		/* Stored data */
+	long size;
+	long dtb_size;
+	int comp;
+	uint32_t offset;
+};
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage: aml_dtbpack [-c none|gzip] -o <image> [<id>=]<dtb>...\n"
+		"       aml_dtbpack -l <image>\n"
+		"\n"
+		"   -c\tCompression for each dtb (default gzip)\n"
+		"   -o\tWrite a version 3 container\n"
+		"   -l\tList the dtbs in a container\n"
+		"\n"
+		"<id> is <soc>_<platform>[_<variant>], as in aml_dt. Without\n"
+		"it the amlogic-dt-id property of the dtb is used.\n");
+	exit(EXIT_FAILURE);
+}
+
+static int read_file(const char *fname, char **datap, long *sizep)
+{
+	FILE *fin;
+	char *data;
+	long size;
+
+	fin = fopen(fname, "rb");
+	if (!fin) {
+		fprintf(stderr, "Cannot open '%s'\n", fname);
+		return -1;
+	}
+	fseek(fin, 0, SEEK_END);
+	size = ftell(fin);
+	fseek(fin, 0, SEEK_SET);
+	data = malloc(size ? size : 1);
+	if (!data || fread(data, 1, size, fin) != size) {
+		fprintf(stderr, "Cannot read '%s'\n", fname);
+		fclose(fin);
+		free(data);
+		return -1;
+	}
+	fclose(fin);
+
+	*datap = data;
+	*sizep = size;
+	return 0;
+}
+
+/* Split an aml_dt id the way U-Boot does and lay it out as in the index */
+static int make_id(char *id, const char *name)
+{
+	char *copy, *s, *part;
+	int i;
+
+	memset(id, 0, AML_DT_V3_ID_SIZE);
+	copy = strdup(name);
+	s = copy;
+	for (i = 0; i < AML_DT_V3_ID_FIELDS; i++) {
+		part = strsep(&s, "_");
+		if (!part)
+			break;
+		if (strlen(part) > AML_DT_V3_ID_LEN) {
+			fprintf(stderr, "'%s': '%s' is longer than %d\n",
+				name, part, AML_DT_V3_ID_LEN);
+			free(copy);
+			return -1;
+		}
+		strncpy(id + i * AML_DT_V3_ID_LEN, part, AML_DT_V3_ID_LEN);
+	}
+	free(copy);
+	if (i < 2) {
+		fprintf(stderr, "'%s': expected <soc>_<platform>\n", name);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void print_id(int i, const char *id, int len)
+{
+	printf("%3d  %-16.*s %-16.*s %-16.*s", i, len, id, len, id + len,
+	       len, id + 2 * len);
+}
+
+static int gzip_entry(struct entry *e)
+{
+	z_stream zs;
+	uLong bound;
+	char *out;
+	int ret;
+
+	memset(&zs, 0, sizeof(zs));
+	/* 16 + window bits: gzip wrapping, as gunzip() expects */
+	if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS,
+			 9, Z_DEFAULT_STRATEGY) != Z_OK)
+		return -1;
+	bound = deflateBound(&zs, e->size) + 32;
+	out = malloc(bound);
+	if (!out) {
+		deflateEnd(&zs);
+		return -1;
+	}
+	zs.next_in = (Bytef *)e->data;
+	zs.avail_in = e->size;
+	zs.next_out = (Bytef *)out;
+	zs.avail_out = bound;
+	ret = deflate(&zs, Z_FINISH);
+	deflateEnd(&zs);
+	if (ret != Z_STREAM_END) {
+		free(out);
+		return -1;
+	}
+
+	/* not worth inflating at boot unless it saves something */
+	if (zs.total_out >= e->size) {
+		free(out);
+		return 0;
+	}
+	free(e->data);
+	e->data = out;
+	e->size = zs.total_out;
+	e->comp = IH_COMP_GZIP;
+
+	return 0;
+}
+
+static int read_entry(struct entry *e, const char *arg, int comp)
+{
+	const char *eq = strchr(arg, '=');
+	const char *name;
+	char *id_str = NULL;
+	int len, ret;
+
+	e->fname = eq ? eq + 1 : arg;
+	if (read_file(e->fname, &e->data, &e->size))
+		return -1;
+	ret = fdt_check_header(e->data);
+	if (ret || fdt_totalsize(e->data) > e->size) {
+		fprintf(stderr, "%s: Not a device tree\n", e->fname);
+		return -1;
+	}
+	e->size = fdt_totalsize(e->data);
+	e->dtb_size = e->size;
+	e->comp = IH_COMP_NONE;
+	if (e->dtb_size > DTB_MAX_SIZE)
+		fprintf(stderr, "%s: Warning: larger than the 0x%x bytes U-Boot allows\n",
+			e->fname, DTB_MAX_SIZE);
+
+	if (eq) {
+		id_str = strndup(arg, eq - arg);
+		name = id_str;
+	} else {
+		name = fdt_getprop(e->data, 0, "amlogic-dt-id", &len);
+		if (!name || !len || name[len - 1]) {
+			fprintf(stderr, "%s: No id given and no amlogic-dt-id\n",
+				e->fname);
+			return -1;
+		}
+	}
+	ret = make_id(e->id, name);
+	free(id_str);
+	if (ret)
+		return -1;
+
+	if (comp == IH_COMP_GZIP && gzip_entry(e)) {
+		fprintf(stderr, "%s: Cannot compress\n", e->fname);
+		return -1;
+	}
+
+	return 0;
+}
+
+static int cmp_entry(const void *v1, const void *v2)
+{
+	const struct entry *e1 = v1, *e2 = v2;
+
+	return memcmp(e1->id, e2->id, AML_DT_V3_ID_SIZE);
+}
+
+static void put_le32(uint32_t *p, uint32_t val)
+{
+	*p = cpu_to_le32(val);
+}
+
+static int pack(const char *out_fname, int comp, char *const files[],
+		int count)
+{
+	struct aml_dt_v3_header hdr;
+	struct aml_dt_v3_entry *index;
+	struct entry *e;
+	static const char pad[AML_DT_V3_ALIGN];
+	uint32_t offset;
+	FILE *fout;
+	int i;
+
+	e = calloc(count, sizeof(*e));
+	index = calloc(count, sizeof(*index));
+	if (!e || !index)
+		return -1;
+	for (i = 0; i < count; i++) {
+		if (read_entry(&e[i], files[i], comp))
+			return -1;
+	}
+
+	qsort(e, count, sizeof(*e), cmp_entry);
+	offset = sizeof(hdr) + count * sizeof(*index);
+	for (i = 0; i < count; i++) {
+		if (i && !cmp_entry(&e[i - 1], &e[i])) {
+			fprintf(stderr, "%s and %s have the same id\n",
+				e[i - 1].fname, e[i].fname);
+			return -1;
+		}
+		offset = (offset + AML_DT_V3_ALIGN - 1) &
+			~(AML_DT_V3_ALIGN - 1);
+		e[i].offset = offset;
+		offset += e[i].size;
+
+		memcpy(index[i].id, e[i].id, AML_DT_V3_ID_SIZE);
+		put_le32(&index[i].offset, e[i].offset);
+		put_le32(&index[i].size, e[i].size);
+		put_le32(&index[i].dtb_size, e[i].dtb_size);
+		index[i].comp = e[i].comp;
+	}
+
+	put_le32(&hdr.magic, AML_DT_HEADER_MAGIC);
+	put_le32(&hdr.version, AML_DT_V3_VERSION);
+	put_le32(&hdr.count, count);
+	put_le32(&hdr.entry_size, sizeof(*index));
+
+	fout = fopen(out_fname, "wb");
+	if (!fout) {
+		fprintf(stderr, "Cannot create '%s'\n", out_fname);
+		return -1;
+	}
+	offset = sizeof(hdr) + count * sizeof(*index);
+	if (fwrite(&hdr, sizeof(hdr), 1, fout) != 1 ||
+	    fwrite(index, sizeof(*index), count, fout) != count)
+		goto err;
+	for (i = 0; i < count; i++) {
+		if (fwrite(pad, 1, e[i].offset - offset, fout) !=
+		    e[i].offset - offset ||
+		    fwrite(e[i].data, 1, e[i].size, fout) != e[i].size)
+			goto err;
+		offset = e[i].offset + e[i].size;
+		print_id(i, e[i].id, AML_DT_V3_ID_LEN);
+		printf(" %6ld -> %6ld  %s\n", e[i].dtb_size, e[i].size,
+		       e[i].fname);
+	}
+	if (fclose(fout)) {
+		fout = NULL;
+		goto err;
+	}
+
+	return 0;
+
+err:
+	fprintf(stderr, "Cannot write '%s'\n", out_fname);
+	if (fout)
+		fclose(fout);
+	unlink(out_fname);
+	return -1;
+}
+
+static const char *comp_name(int comp)
+{
+	switch (comp) {
+	case IH_COMP_NONE:
+		return "none";
+	case IH_COMP_GZIP:
+		return "gzip";
+	case IH_COMP_LZ4:
+		return "lz4";
+	}
+
+	return "unknown";
+}
+
+/* Versions 1 and 2 hold each id string in big-endian words, space padded */
+static int list_v1_v2(const char *data, long size, int version)
+{
+	int id_len = version == 1 ? 4 : 16;
+	int hdr_size = 8 + id_len * AML_DT_V3_ID_FIELDS;
+	const uint32_t *w = (const uint32_t *)data;
+	uint32_t count = le32_to_cpu(w[2]);
+	char id[3 * 16];
+	const char *p;
+	uint32_t i, j;
+
+	if (size < 12 + (long)count * hdr_size)
+		return -1;
+	for (i = 0; i < count; i++) {
+		p = data + 12 + i * hdr_size;
+		for (j = 0; j < id_len * AML_DT_V3_ID_FIELDS; j++) {
+			id[j] = p[(j & ~3) + 3 - (j & 3)];
+			if (id[j] == ' ')
+				id[j] = '\0';
+		}
+		w = (const uint32_t *)(p + id_len * AML_DT_V3_ID_FIELDS);
+		print_id(i, id, id_len);
+		printf(" %6u at 0x%x\n", le32_to_cpu(w[1]), le32_to_cpu(w[0]));
+	}
+
+	return 0;
+}
+
+static int list(const char *fname)
+{
+	const struct aml_dt_v3_header *hdr;
+	const struct aml_dt_v3_entry *e;
+	uint32_t count, esize, i;
+	char *data;
+	long size;
+	int version;
+
+	if (read_file(fname, &data, &size))
+		return -1;
+	hdr = (const struct aml_dt_v3_header *)data;
+	if (size < sizeof(*hdr) ||
+	    le32_to_cpu(hdr->magic) != AML_DT_HEADER_MAGIC) {
+		fprintf(stderr, "%s: Not a multi-dtb container\n", fname);
+		return -1;
+	}
+	version = le32_to_cpu(hdr->version);
+	printf("%s: version %d, %u dtbs\n", fname, version,
+	       le32_to_cpu(hdr->count));
+	if (version == 1 || version == 2) {
+		if (list_v1_v2(data, size, version))
+			goto corrupt;
+		return 0;
+	}
+	if (version != AML_DT_V3_VERSION) {
+		fprintf(stderr, "%s: Unknown version\n", fname);
+		return -1;
+	}
+
+	count = le32_to_cpu(hdr->count);
+	esize = le32_to_cpu(hdr->entry_size);
+	if (esize < sizeof(*e) || size < sizeof(*hdr) + (long)count * esize)
+		goto corrupt;
+	for (i = 0; i < count; i++) {
+		e = (const struct aml_dt_v3_entry *)(data + sizeof(*hdr) +
+						     i * esize);
+		if ((long)le32_to_cpu(e->offset) + le32_to_cpu(e->size) > size)
+			goto corrupt;
+		print_id(i, e->id, AML_DT_V3_ID_LEN);
+		printf(" %6u -> %6u  %s at 0x%x\n", le32_to_cpu(e->dtb_size),
+		       le32_to_cpu(e->size), comp_name(e->comp),
+		       le32_to_cpu(e->offset));
+	}
+
+	return 0;
+
+corrupt:
+	fprintf(stderr, "%s: Container is truncated or corrupt\n", fname);
+	return -1;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out_fname = NULL, *list_fname = NULL;
+	int comp = IH_COMP_GZIP;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:l:o:")) != -1) {
+		switch (opt) {
+		case 'c':
+			if (!strcmp(optarg, "none"))
+				comp = IH_COMP_NONE;
+			else if (!strcmp(optarg, "gzip"))
+				comp = IH_COMP_GZIP;
+			else
+				usage();
+			break;
+		case 'l':
+			list_fname = optarg;
+			break;
+		case 'o':
+			out_fname = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+
+	if (list_fname && !out_fname && optind == argc)
+		return list(list_fname) ? EXIT_FAILURE : EXIT_SUCCESS;
+	if (!out_fname || list_fname || optind == argc)
+		usage();
+
+	return pack(out_fname, comp, argv + optind, argc - optind) ?
+		EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,405 @@
+/*
+ * Decode and compare bootstage exports (see 'bootstage export' and
+ * CONFIG_BOOTSTAGE_EXPORT). Two boot timelines are aligned on stage name
+ * and the time spent in each stage is compared, so that a slower boot can
+ * be pinned on the stage that got slower.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <compiler.h>
+#include <bootstage_export.h>
+#include <u-boot/crc.h>
+
+/* One record of a timeline, in host byte order */
+struct stage {
+	uint32_t id;
+	uint32_t flags;
+	uint32_t time_us;	/* Mark time, or total if accumulated */
+	uint32_t elapsed_us;	/* Time since the previous mark */
+	const char *name;
+	int instance;		/* Number of earlier stages with this name */
+	struct stage *match;	/* Same stage in the other timeline */
+};
+
+struct timeline {
+	const char *fname;
+	char *data;		/* Raw export, holds the name strings */
+	struct stage *stage;
+	int count;
+	uint32_t total_us;	/* Time of the last mark */
+};
+
+static int verbose = 1;	/* 0=errors only, 1=warn, 2=info */
+
+static void outf(int level, const char *fmt, ...)
+		__attribute__ ((format (__printf__, 2, 3)));
+#define error(fmt, b...) outf(0, fmt, ##b)
+#define warn(fmt, b...) outf(1, fmt, ##b)
+#define info(fmt, b...) outf(2, fmt, ##b)
+
+static void outf(int level, const char *fmt, ...)
+{
+	if (verbose >= level) {
+		va_list args;
+
+		va_start(args, fmt);
+		vfprintf(stderr, fmt, args);
+		va_end(args);
+	}
+}
+
+static void usage(void)
+{
+	fprintf(stderr,
+		"Usage: bootstage_diff [-t <us>] [-v <0-2>] <cmd> <files>\n"
+		"\n"
+		"Commands\n"
+		"   dump <export>\t\tPrint a timeline as JSON\n"
+		"   diff <base> <new>\t\tCompare two timelines stage by stage\n"
+		"\n"
+		"Options:\n"
+		"   -t <us>\tOnly list stages which changed by this much\n"
+		"   -v <0-2>\tSpecify verbosity\n");
+	exit(EXIT_FAILURE);
+}
+
+static int h_cmp_time(const void *v1, const void *v2)
+{
+	const struct stage *s1 = v1, *s2 = v2;
+
+	/* Marks first, in time order, then accumulated stages */
+	if ((s1->flags ^ s2->flags) & BOOTSTAGE_EXPORTF_ACCUM)
+		return s1->flags & BOOTSTAGE_EXPORTF_ACCUM ? 1 : -1;
+	if (s1->time_us != s2->time_us)
+		return s1->time_us > s2->time_us ? 1 : -1;
+
+	return s1->id > s2->id ? 1 : -1;
+}
+
+static int read_file(const char *fname, char **datap, long *sizep)
+{
+	FILE *fin;
+	char *data;
+	long size;
+
+	fin = fopen(fname, "rb");
+	if (!fin) {
+		error("Cannot open bootstage export '%s'\n", fname);
+		return -1;
+	}
+	fseek(fin, 0, SEEK_END);
+	size = ftell(fin);
+	fseek(fin, 0, SEEK_SET);
+	data = malloc(size + 1);
+	if (!data || fread(data, 1, size, fin) != size) {
+		error("Cannot read bootstage export '%s'\n", fname);
+		fclose(fin);
+		free(data);
+		return -1;
+	}
+	fclose(fin);
+	data[size] = '\0';	/* terminate the last name */
+
+	*datap = data;
+	*sizep = size;
+	return 0;
+}
+
+static int read_timeline(const char *fname, struct timeline *tl)
+{
+	struct bootstage_export_hdr *hdr;
+	struct bootstage_export_rec *rec;
+	const char *names;
+	uint32_t size, count, prev;
+	long fsize;
+	int i, j;
+
+	tl->fname = fname;
+	if (read_file(fname, &tl->data, &fsize))
+		return -1;
+
+	hdr = (struct bootstage_export_hdr *)tl->data;
+	if (fsize < sizeof(*hdr) ||
+	    le32_to_cpu(hdr->magic) != BOOTSTAGE_EXPORT_MAGIC) {
+		error("%s: Not a bootstage export\n", fname);
+		return -1;
+	}
+	if (le32_to_cpu(hdr->version) != BOOTSTAGE_EXPORT_VERSION) {
+		error("%s: Bootstage export version %u unrecognised\n", fname,
+		      le32_to_cpu(hdr->version));
+		return -1;
+	}
+	size = le32_to_cpu(hdr->size);
+	count = le32_to_cpu(hdr->count);
+	if (size > fsize || size < sizeof(*hdr) ||
+	    count > (size - sizeof(*hdr)) / sizeof(*rec)) {
+		error("%s: Bootstage export is truncated\n", fname);
+		return -1;
+	}
+	if (crc32(0, (unsigned char *)(hdr + 1), size - sizeof(*hdr)) !=
+	    le32_to_cpu(hdr->crc32))
+		warn("%s: Bad checksum, data may be corrupt\n", fname);
+
+	rec = (struct bootstage_export_rec *)(hdr + 1);
+	names = (const char *)(rec + count);
+	tl->data[size] = '\0';
+	tl->stage = calloc(count, sizeof(*tl->stage));
+	if (!tl->stage) {
+		error("Cannot allocate stage list\n");
+		return -1;
+	}
+
+	for (i = 0; i < count; i++, rec++) {
+		struct stage *st = &tl->stage[i];
+		uint32_t name = le32_to_cpu(rec->name);
+
+		st->id = le32_to_cpu(rec->id);
+		st->flags = le32_to_cpu(rec->flags);
+		st->time_us = le32_to_cpu(rec->time_us);
+		st->name = names + name < tl->data + size ? names + name : "?";
+	}
+	tl->count = count;
+	qsort(tl->stage, count, sizeof(*tl->stage), h_cmp_time);
+
+	/* Work out the time spent in each stage and number repeated names */
+	for (i = 0, prev = 0; i < count; i++) {
+		struct stage *st = &tl->stage[i];
+
+		if (st->flags & BOOTSTAGE_EXPORTF_ACCUM) {
+			st->elapsed_us = st->time_us;
+		} else {
+			st->elapsed_us = st->time_us - prev;
+			prev = st->time_us;
+		}
+		for (j = 0; j < i; j++) {
+			if (!strcmp(tl->stage[j].name, st->name))
+				st->instance++;
+		}
+	}
+	tl->total_us = prev;
+	info("%s: %d records, %u us to last mark\n", fname, count, prev);
+
+	return 0;
+}
+
+static void print_json_string(const char *str)
+{
+	putchar('"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+}
+
+static int dump_timeline(struct timeline *tl)
+{
+	int i;
+
+	printf("{\n\t\"file\": ");
+	print_json_string(tl->fname);
+	printf(",\n\t\"total_us\": %u,\n\t\"stages\": [\n", tl->total_us);
+	for (i = 0; i < tl->count; i++) {
+		struct stage *st = &tl->stage[i];
+
+		printf("\t\t{ \"id\": %u, \"name\": ", st->id);
+		print_json_string(st->name);
+		printf(", \"type\": \"%s\", \"time_us\": %u, "
+		       "\"elapsed_us\": %u%s }%s\n",
+		       st->flags & BOOTSTAGE_EXPORTF_ACCUM ? "accum" : "mark",
+		       st->time_us, st->elapsed_us,
+		       st->flags & BOOTSTAGE_EXPORTF_ERROR ?
+		       ", \"error\": true" : "",
+		       i == tl->count - 1 ? "" : ",");
+	}
+	printf("\t]\n}\n");
+
+	return 0;
+}
+
+/* Pair up stages with the same name, type and instance number */
+static void match_timelines(struct timeline *base, struct timeline *new)
+{
+	int i, j;
+
+	for (i = 0; i < new->count; i++) {
+		struct stage *st = &new->stage[i];
+
+		for (j = 0; j < base->count; j++) {
+			struct stage *bst = &base->stage[j];
+
+			if (bst->match || bst->instance != st->instance ||
+			    ((bst->flags ^ st->flags) &
+			     BOOTSTAGE_EXPORTF_ACCUM) ||
+			    strcmp(bst->name, st->name))
+				continue;
+			st->match = bst;
+			bst->match = st;
+			break;
+		}
+	}
+}
+
+static void print_us(const char *fmt, long long us, int present)
+{
+	if (present)
+		printf(fmt, us);
+	else
+		printf("%11s", "-");
+}
+
+static void print_stage(struct stage *bst, struct stage *st)
+{
+	long long delta = 0;
+
+	print_us("%11lld", bst ? bst->elapsed_us : 0, bst != NULL);
+	print_us("%11lld", st ? st->elapsed_us : 0, st != NULL);
+	if (bst && st)
+		delta = (long long)st->elapsed_us - bst->elapsed_us;
+	print_us("%+11lld", delta, bst && st);
+	printf("  %s", st ? st->name : bst->name);
+	if ((st ? st : bst)->instance)
+		printf(" #%d", (st ? st : bst)->instance + 1);
+	if (!bst)
+		printf(" (new)");
+	else if (!st)
+		printf(" (gone)");
+	printf("\n");
+}
+
+static int show_change(struct stage *bst, struct stage *st, long threshold)
+{
+	long long delta;
+
+	if (!bst || !st)
+		return 1;
+	delta = (long long)st->elapsed_us - bst->elapsed_us;
+
+	return delta >= threshold || -delta >= threshold;
+}
+
+static int h_cmp_delta(const void *v1, const void *v2)
+{
+	struct stage *const *s1 = v1, *const *s2 = v2;
+	long long d1, d2;
+
+	d1 = (long long)(*s1)->elapsed_us - (*s1)->match->elapsed_us;
+	d2 = (long long)(*s2)->elapsed_us - (*s2)->match->elapsed_us;
+
+	return d1 < d2 ? 1 : d1 > d2 ? -1 : 0;
+}
+
+static int diff_timelines(struct timeline *base, struct timeline *new,
+			  long threshold)
+{
+	struct stage **worst;
+	int accum, i, j, count;
+
+	match_timelines(base, new);
+
+	printf("%11s%11s%11s  %s\n", "Base", "New", "Delta", "Stage");
+	for (accum = 0; accum < 2; accum++) {
+		if (accum)
+			puts("\nAccumulated time:");
+
+		for (i = 0; i < new->count; i++) {
+			struct stage *st = &new->stage[i];
+
+			if (!(st->flags & BOOTSTAGE_EXPORTF_ACCUM) == !accum &&
+			    show_change(st->match, st, threshold))
+				print_stage(st->match, st);
+		}
+
+		/* Then the stages which the new timeline no longer has */
+		for (j = 0; j < base->count; j++) {
+			struct stage *bst = &base->stage[j];
+
+			if (!(bst->flags & BOOTSTAGE_EXPORTF_ACCUM) == !accum &&
+			    !bst->match)
+				print_stage(bst, NULL);
+		}
+	}
+
+	printf("\n%11u%11u%+11lld  total to last mark\n", base->total_us,
+	       new->total_us, (long long)new->total_us - base->total_us);
+
+	/* List the stages that account for most of the change */
+	worst = calloc(new->count, sizeof(*worst));
+	if (!worst) {
+		error("Cannot allocate stage list\n");
+		return -1;
+	}
+	for (i = count = 0; i < new->count; i++) {
+		struct stage *st = &new->stage[i];
+
+		if (st->match && !(st->flags & BOOTSTAGE_EXPORTF_ACCUM) &&
+		    st->elapsed_us > st->match->elapsed_us &&
+		    show_change(st->match, st, threshold))
+			worst[count++] = st;
+	}
+	qsort(worst, count, sizeof(*worst), h_cmp_delta);
+	if (count)
+		puts("\nLargest regressions:");
+	for (i = 0; i < count && i < 5; i++)
+		print_stage(worst[i]->match, worst[i]);
+	free(worst);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct timeline base, new;
+	long threshold = 0;
+	const char *cmd;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:v:")) != -1) {
+		switch (opt) {
+		case 't':
+			threshold = atol(optarg);
+			break;
+
+		case 'v':
+			verbose = atoi(optarg);
+			break;
+
+		default:
+			usage();
+		}
+	}
+	argc -= optind; argv += optind;
+	if (argc < 2)
+		usage();
+
+	memset(&base, '\0', sizeof(base));
+	memset(&new, '\0', sizeof(new));
+	cmd = argv[0];
+	if (!strcmp(cmd, "dump") && argc == 2) {
+		if (read_timeline(argv[1], &new))
+			return EXIT_FAILURE;
+		return dump_timeline(&new) ? EXIT_FAILURE : 0;
+	} else if (!strcmp(cmd, "diff") && argc == 3) {
+		if (read_timeline(argv[1], &base) ||
+		    read_timeline(argv[2], &new))
+			return EXIT_FAILURE;
+		return diff_timelines(&base, &new, threshold) ?
+			EXIT_FAILURE : 0;
+	}
+	usage();
+
+	return 0;
+}